@@ -65,6 +65,9 @@ static void print_usage(const char *command)
     "                                 upgrading\n"
     "      --no-rollback              Do not roll back if an error occurs while\n"
     "                                 deactivating and activating services\n"
+    "      --batch-activities         Submits the activation and deactivation steps\n"
+    "                                 that can be executed on a machine at the same\n"
+    "                                 time with a single request\n"
     "      --dry-run                  Prints the activation and deactivation steps\n"
     "                                 that will be performed but does not actually\n"
     "                                 execute them\n"
@@ -83,6 +86,11 @@ static void print_usage(const char *command)
     "  DISNIX_PROFILE    Sets the name of the profile that stores the manifest on the\n"
     "                    coordinator machine and the deployed services per machine on\n"
     "                    each target (Defaults to: default)\n"
+    "  DISNIX_SSH_SESSION_DIR\n"
+    "                    Directory containing the shared SSH connections of\n"
+    "                    disnix-ssh-client. Only disnix-env sets it up. When it is\n"
+    "                    not set, every remote operation opens a connection of its\n"
+    "                    own\n"
     );
 }
 
@@ -97,6 +105,7 @@ int main(int argc, char *argv[])
         {"profile", required_argument, 0, DISNIX_OPTION_PROFILE},
         {"no-upgrade", no_argument, 0, DISNIX_OPTION_NO_UPGRADE},
         {"no-rollback", no_argument, 0, DISNIX_OPTION_NO_ROLLBACK},
+        {"batch-activities", no_argument, 0, DISNIX_OPTION_BATCH_ACTIVITIES},
         {"dry-run", no_argument, 0, DISNIX_OPTION_DRY_RUN},
         {"help", no_argument, 0, DISNIX_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_OPTION_VERSION},
@@ -124,6 +133,9 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_NO_ROLLBACK:
                 flags |= FLAG_NO_ROLLBACK;
                 break;
+            case DISNIX_OPTION_BATCH_ACTIVITIES:
+                flags |= FLAG_BATCH_ACTIVITIES;
+                break;
             case DISNIX_OPTION_NO_UPGRADE:
                 flags |= FLAG_NO_UPGRADE;
                 break;
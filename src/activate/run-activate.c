@@ -41,7 +41,7 @@ int run_activate_system(const gchar *new_manifest, const gchar *old_manifest, co
             Manifest *previous_manifest = open_previous_manifest(old_manifest_file, MANIFEST_SERVICE_MAPPINGS_FLAG, NULL, NULL);
 
             /* Do the activation process */
-            status = activate_system(manifest, previous_manifest, flags, set_flag_on_interrupt, restore_default_behaviour_on_interrupt);
+            status = activate_system(manifest, previous_manifest, flags, set_flag_on_interrupt, restore_default_behaviour_on_interrupt, NULL);
             print_transition_status(status, old_manifest_file, new_manifest, coordinator_profile_path, profile);
 
             /* Cleanup */
@@ -41,6 +41,13 @@ static void print_usage(const char *command)
     "Options:\n"
     "  -m, --max-concurrent-transfers=NUM  Maximum amount of concurrent closure\n"
     "                                      transfers. Defauls to: 2\n"
+    "      --max-concurrent-builds=NUM     Maximum amount of concurrent builds across\n"
+    "                                      all machines. Each machine never builds\n"
+    "                                      more derivations at the same time than\n"
+    "                                      its numOfCores property. Because it\n"
+    "                                      defaults to 1, a machine builds one\n"
+    "                                      derivation at a time unless the property\n"
+    "                                      is set. Defaults to: 0 (no limit)\n"
     "  -h, --help                          Shows the usage of this command to the user\n"
     "  -v, --version                       Shows the version of this command to the\n"
     "                                      user\n"
@@ -59,12 +66,14 @@ int main(int argc, char *argv[])
     struct option long_options[] =
     {
         {"max-concurrent-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS},
+        {"max-concurrent-builds", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_BUILDS},
         {"help", no_argument, 0, DISNIX_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_OPTION_VERSION},
         {0, 0, 0, 0}
     };
 
     unsigned int max_concurrent_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_TRANSFERS;
+    unsigned int max_concurrent_builds = 0;
     char *tmpdir = NULL;
 
     /* Parse command-line options */
@@ -75,6 +84,9 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS:
                 max_concurrent_transfers = atoi(optarg);
                 break;
+            case DISNIX_OPTION_MAX_CONCURRENT_BUILDS:
+                max_concurrent_builds = atoi(optarg);
+                break;
             case DISNIX_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
@@ -97,5 +109,5 @@ int main(int argc, char *argv[])
         return 1;
     }
     else
-        return run_build(argv[optind], max_concurrent_transfers, tmpdir); /* Perform distributed build operation */
+        return run_build(argv[optind], max_concurrent_transfers, max_concurrent_builds, tmpdir); /* Perform distributed build operation */
 }
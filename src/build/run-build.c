@@ -23,7 +23,7 @@
 #include <derivationmappingarray.h>
 #include <interfacestable.h>
 
-int run_build(const gchar *distributed_derivation_file, const unsigned int max_concurrent_transfers, char *tmpdir)
+int run_build(const gchar *distributed_derivation_file, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_builds, char *tmpdir)
 {
     DistributedDerivation *distributed_derivation = create_distributed_derivation(distributed_derivation_file);
 
@@ -37,7 +37,7 @@ int run_build(const gchar *distributed_derivation_file, const unsigned int max_c
         int exit_status;
 
         if(check_distributed_derivation(distributed_derivation))
-            exit_status = !build(distributed_derivation, max_concurrent_transfers, tmpdir); /* Execute remote builds */
+            exit_status = !build(distributed_derivation, max_concurrent_transfers, max_concurrent_builds, tmpdir); /* Execute remote builds */
         else
             exit_status = 1;
 
@@ -28,9 +28,10 @@
  *
  * @param distributed_derivation_file Path to the distributed derivation file
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param max_concurrent_builds Specifies the maximum amount of concurrent builds across all machines, or 0 for no limit
  * @param tmpdir Directory in which the temp files should be stored
  * @return 0 if everything succeeds, or else a non-zero exit value
  */
-int run_build(const gchar *distributed_derivation_file, const unsigned int max_concurrent_transfers, char *tmpdir);
+int run_build(const gchar *distributed_derivation_file, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_builds, char *tmpdir);
 
 #endif
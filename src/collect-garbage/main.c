@@ -49,6 +49,10 @@ static void print_usage(const char *command)
     "  DISNIX_TARGET_PROPERTY     Specifies which property in the infrastructure Nix\n"
     "                             expression specifies how to connect to the remote\n"
     "                             interface (defaults to: hostname)\n"
+    "  DISNIX_SSH_SESSION_DIR     Directory containing the shared SSH connections of\n"
+    "                             disnix-ssh-client. Only disnix-env sets it up. When\n"
+    "                             it is not set, every remote operation opens a\n"
+    "                             connection of its own\n"
     );
 }
 
@@ -54,6 +54,10 @@ static void print_usage(const char *command)
     "Environment:\n"
     "  DISNIX_CLIENT_INTERFACE    Sets the client interface (which defaults to:\n"
     "                             disnix-ssh-client)\n"
+    "  DISNIX_SSH_SESSION_DIR     Directory containing the shared SSH connections of\n"
+    "                             disnix-ssh-client. Only disnix-env sets it up. When\n"
+    "                             it is not set, every remote operation opens a\n"
+    "                             connection of its own\n"
     );
 }
 
@@ -75,7 +79,6 @@ int main(int argc, char *argv[])
     int to = FALSE;
     char *interface = NULL;
     char *target = NULL;
-    char *tmpdir = NULL;
     char **paths;
 
     /* Parse command-line options */
@@ -111,14 +114,6 @@ int main(int argc, char *argv[])
 
     interface = check_interface_option(interface);
 
-    if(tmpdir == NULL)
-    {
-        tmpdir = getenv("TMPDIR");
-
-        if(tmpdir == NULL)
-            tmpdir = "/tmp";
-    }
-
     if(optind >= argc)
     {
         fprintf(stderr, "At least one path to the Nix store must be specified!\n");
@@ -135,7 +130,7 @@ int main(int argc, char *argv[])
         return 1;
     }
     else if(to)
-        return !copy_closure_to_sync(interface, target, tmpdir, paths, STDERR_FILENO);
+        return !copy_closure_to_sync(interface, target, NULL, paths, NULL, STDERR_FILENO);
     else if(from)
         return !copy_closure_from_sync(interface, target, paths, STDOUT_FILENO, STDERR_FILENO);
 }
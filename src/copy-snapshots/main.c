@@ -57,6 +57,10 @@ static void print_usage(const char *command)
     "  DYSNOMIA_STATEDIR          Specifies where the snapshots must be stored on the\n"
     "                             coordinator machine (defaults to:\n"
     "                             /var/state/dysnomia)\n"
+    "  DISNIX_SSH_SESSION_DIR     Directory containing the shared SSH connections of\n"
+    "                             disnix-ssh-client. Only disnix-env sets it up. When\n"
+    "                             it is not set, every remote operation opens a\n"
+    "                             connection of its own\n"
     );
 }
 
@@ -56,6 +56,9 @@ static void print_usage(const char *command)
     "      --collect-garbage      Collects garbage on the given target machine\n"
     "      --activate             Activates the given service on the target machine\n"
     "      --deactivate           Deactivates the given service on the target machine\n"
+    "      --run-activities       Executes a batch of activities read from the\n"
+    "                             standard input and prints the outcome of each\n"
+    "                             activity\n"
     "      --lock                 Acquires a lock on a Disnix profile of the target\n"
     "                             machine\n"
     "      --unlock               Release the lock on a Disnix profile of the target\n"
@@ -92,6 +95,9 @@ static void print_usage(const char *command)
     "                             loopback connections.\n"
     "      --session-bus          Connects to the session bus instead of the system\n"
     "                             bus. This is useful for testing/debugging purposes\n"
+    "      --stream-log           Writes the log of the job to the standard error\n"
+    "                             while it is in progress, instead of displaying it\n"
+    "                             only when the job fails\n"
 
     "\nImport/Export/Import snapshots/Export snapshots options:\n"
     "      --localfile            Specifies that the given paths are stored locally\n"
@@ -101,6 +107,11 @@ static void print_usage(const char *command)
     "                             and must transferred from the remote machine if\n"
     "                             needed\n"
 
+    "\nImport/Export options:\n"
+    "      --stream               Reads the closure to import from the standard\n"
+    "                             input or writes the exported closure to the\n"
+    "                             standard output, instead of using a file\n"
+
     "\nShell options:\n"
     "      --command=COMMAND      Commands to execute in the shell session\n"
 
@@ -178,7 +189,10 @@ typedef enum
     DISNIX_CLIENT_OPTION_COMPONENT = 'c',
     DISNIX_CLIENT_OPTION_KEEP = 281,
     DISNIX_CLIENT_OPTION_COMMAND = 282,
-    DISNIX_CLIENT_OPTION_SESSION_BUS = 283
+    DISNIX_CLIENT_OPTION_SESSION_BUS = 283,
+    DISNIX_CLIENT_OPTION_STREAM = 284,
+    DISNIX_CLIENT_OPTION_RUN_ACTIVITIES = 285,
+    DISNIX_CLIENT_OPTION_STREAM_LOG = 286
 }
 DisnixClientCommandLineOption;
 
@@ -198,6 +212,7 @@ int main(int argc, char *argv[])
         {"collect-garbage", no_argument, 0, DISNIX_CLIENT_OPTION_COLLECT_GARBAGE},
         {"activate", no_argument, 0, DISNIX_CLIENT_OPTION_ACTIVATE},
         {"deactivate", no_argument, 0, DISNIX_CLIENT_OPTION_DEACTIVATE},
+        {"run-activities", no_argument, 0, DISNIX_CLIENT_OPTION_RUN_ACTIVITIES},
         {"delete-state", no_argument, 0, DISNIX_CLIENT_OPTION_DELETE_STATE},
         {"lock", no_argument, 0, DISNIX_CLIENT_OPTION_LOCK},
         {"unlock", no_argument, 0, DISNIX_CLIENT_OPTION_UNLOCK},
@@ -223,6 +238,8 @@ int main(int argc, char *argv[])
         {"keep", required_argument, 0, DISNIX_CLIENT_OPTION_KEEP},
         {"command", required_argument, 0, DISNIX_CLIENT_OPTION_COMMAND},
         {"session-bus", no_argument, 0, DISNIX_CLIENT_OPTION_SESSION_BUS},
+        {"stream", no_argument, 0, DISNIX_CLIENT_OPTION_STREAM},
+        {"stream-log", no_argument, 0, DISNIX_CLIENT_OPTION_STREAM_LOG},
         {"help", no_argument, 0, DISNIX_CLIENT_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_CLIENT_OPTION_VERSION},
         {0, 0, 0, 0}
@@ -309,6 +326,9 @@ int main(int argc, char *argv[])
             case DISNIX_CLIENT_OPTION_SHELL:
                 operation = OP_SHELL;
                 break;
+            case DISNIX_CLIENT_OPTION_RUN_ACTIVITIES:
+                operation = OP_RUN_ACTIVITIES;
+                break;
             case DISNIX_CLIENT_OPTION_TARGET:
                 break;
             case DISNIX_CLIENT_OPTION_LOCALFILE:
@@ -341,6 +361,12 @@ int main(int argc, char *argv[])
             case DISNIX_CLIENT_OPTION_SESSION_BUS:
                 flags |= FLAG_SESSION_BUS;
                 break;
+            case DISNIX_CLIENT_OPTION_STREAM:
+                flags |= FLAG_STREAM;
+                break;
+            case DISNIX_CLIENT_OPTION_STREAM_LOG:
+                flags |= FLAG_STREAM_LOG;
+                break;
             case DISNIX_CLIENT_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
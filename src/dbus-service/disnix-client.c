@@ -22,12 +22,32 @@
 #include <stdlib.h>
 
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <gio/gunixfdlist.h>
 
 #include "disnix-dbus.h"
+#include "activity-batch.h"
 #define BUFFER_SIZE 1024
 
+/* Amount of milliseconds between two checks for new log output */
+#define LOG_POLL_INTERVAL 100
+
+/* Maximum amount of buffers of log output that are forwarded per check */
+#define MAX_LOG_BUFFERS_PER_POLL 64
+
 char *logdir;
 
+/* Temp file that holds a closure that was read from the standard input */
+static gchar *spooled_closure = NULL;
+
+/* Indicates whether an exported closure must be written to the standard output */
+static gboolean stream_export = FALSE;
+
+/* Descriptor of the job's logfile that is followed while the job is in progress, or -1 if the log is not streamed */
+static int streamed_log_fd = -1;
+
 static void print_log(const gint pid)
 {
     char pidStr[15], buf[BUFFER_SIZE];
@@ -53,6 +73,236 @@ static void print_log(const gint pid)
     g_free(logfile);
 }
 
+static int open_log_fd(OrgNixosDisnixDisnix *proxy, const gint pid)
+{
+    GError *error = NULL;
+    GUnixFDList *out_fd_list = NULL;
+    gint handle;
+    int log_fd;
+
+    if(org_nixos_disnix_disnix_call_open_log_sync(proxy, pid, NULL, &handle, &out_fd_list, NULL, &error))
+    {
+        log_fd = g_unix_fd_list_get(out_fd_list, handle, &error);
+        g_object_unref(out_fd_list);
+    }
+    else if(g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+    {
+        /* Older services do not pass the logfile, so we open it from the log directory ourselves */
+        gchar pidStr[15];
+        gchar *logfile;
+
+        g_clear_error(&error);
+        sprintf(pidStr, "%d", pid);
+        logfile = g_strconcat(logdir, "/", pidStr, NULL);
+        log_fd = open(logfile, O_RDONLY);
+
+        if(log_fd == -1)
+            g_printerr("Cannot open logfile: %s\n", logfile);
+
+        g_free(logfile);
+    }
+    else
+        log_fd = -1;
+
+    if(error != NULL)
+    {
+        g_printerr("Cannot stream the log of job: %d! Reason: %s\n", pid, error->message);
+        g_error_free(error);
+    }
+
+    return log_fd;
+}
+
+static void forward_log(gboolean drain)
+{
+    char buf[BUFFER_SIZE];
+    ssize_t bytes_read;
+    unsigned int num_of_buffers = 0;
+
+    /* Forward a bounded amount of output per check, so that a chatty job cannot starve the main loop */
+    while((drain || num_of_buffers < MAX_LOG_BUFFERS_PER_POLL) && (bytes_read = read(streamed_log_fd, buf, BUFFER_SIZE)) > 0)
+    {
+        fwrite(buf, 1, bytes_read, stderr);
+        num_of_buffers++;
+    }
+
+    fflush(stderr);
+}
+
+static gboolean poll_log(gpointer user_data)
+{
+    forward_log(FALSE);
+    return TRUE;
+}
+
+static void start_streaming_log(OrgNixosDisnixDisnix *proxy, const gint pid)
+{
+    streamed_log_fd = open_log_fd(proxy, pid);
+
+    /* A logfile does not signal readiness, so we check for output that has been appended at a fixed interval */
+    if(streamed_log_fd != -1)
+        g_timeout_add(LOG_POLL_INTERVAL, poll_log, NULL);
+}
+
+static void finish_streaming_log(void)
+{
+    if(streamed_log_fd != -1)
+    {
+        forward_log(TRUE);
+        close(streamed_log_fd);
+    }
+}
+
+static gchar *spool_stdin_to_tempfile(void)
+{
+    char buf[BUFFER_SIZE];
+    ssize_t bytes_read;
+    gchar *tmpdir = getenv("TMPDIR");
+    gchar *tempfilename;
+    int temp_fd;
+
+    if(tmpdir == NULL)
+        tmpdir = "/tmp";
+
+    tempfilename = g_strconcat(tmpdir, "/disnix.XXXXXX", NULL);
+    temp_fd = mkstemp(tempfilename);
+
+    if(temp_fd == -1)
+    {
+        g_printerr("Cannot create tempfile: %s\n", tempfilename);
+        g_free(tempfilename);
+        return NULL;
+    }
+
+    /* The service runs as a different user and must be able to read the closure */
+    fchmod(temp_fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    while((bytes_read = read(0, buf, BUFFER_SIZE)) > 0)
+    {
+        if(write(temp_fd, buf, bytes_read) != bytes_read)
+        {
+            bytes_read = -1;
+            break;
+        }
+    }
+
+    close(temp_fd);
+
+    if(bytes_read == -1)
+    {
+        g_printerr("Cannot spool the closure to: %s\n", tempfilename);
+        unlink(tempfilename);
+        g_free(tempfilename);
+        return NULL;
+    }
+    else
+        return tempfilename;
+}
+
+static int write_file_to_stdout(const gchar *path)
+{
+    char buf[BUFFER_SIZE];
+    size_t bytes_read;
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+    {
+        g_printerr("Cannot open exported closure: %s\n", path);
+        return 1;
+    }
+
+    while((bytes_read = fread(buf, 1, BUFFER_SIZE, file)) > 0)
+        fwrite(buf, 1, bytes_read, stdout);
+
+    fclose(file);
+    fflush(stdout);
+
+    unlink(path); /* Remove the closure if we are permitted to do so. It is no longer needed. */
+    return 0;
+}
+
+static GUnixFDList *create_closure_fd_list(int closure_fd, gint *handle, GError **error)
+{
+    GUnixFDList *fd_list = g_unix_fd_list_new();
+    *handle = g_unix_fd_list_append(fd_list, closure_fd, error);
+
+    if(*handle == -1)
+    {
+        g_object_unref(fd_list);
+        return NULL;
+    }
+    else
+        return fd_list;
+}
+
+static gboolean import_closure_from_fd(OrgNixosDisnixDisnix *proxy, gint pid, int closure_fd, GError **error)
+{
+    gint handle;
+    GUnixFDList *fd_list = create_closure_fd_list(closure_fd, &handle, error);
+
+    if(fd_list == NULL)
+        return FALSE;
+    else
+    {
+        gboolean status = org_nixos_disnix_disnix_call_import_fd_sync(proxy, pid, handle, fd_list, NULL, NULL, error);
+        g_object_unref(fd_list);
+        return status;
+    }
+}
+
+static gboolean export_closure_to_fd(OrgNixosDisnixDisnix *proxy, gint pid, const gchar **paths, int closure_fd, GError **error)
+{
+    gint handle;
+    GUnixFDList *fd_list = create_closure_fd_list(closure_fd, &handle, error);
+
+    if(fd_list == NULL)
+        return FALSE;
+    else
+    {
+        gboolean status = org_nixos_disnix_disnix_call_export_fd_sync(proxy, pid, paths, handle, fd_list, NULL, NULL, error);
+        g_object_unref(fd_list);
+        return status;
+    }
+}
+
+/* Services that predate the file descriptor based methods do not know them */
+static gboolean is_unknown_method(GError **error)
+{
+    if(g_error_matches(*error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+    {
+        g_clear_error(error);
+        return TRUE;
+    }
+    else
+        return FALSE;
+}
+
+static GVariant *create_activities_variant(const GPtrArray *batch)
+{
+    GVariantBuilder builder;
+    unsigned int i;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ussssas)"));
+
+    for(i = 0; i < batch->len; i++)
+    {
+        ActivityBatchItem *item = g_ptr_array_index(batch, i);
+        g_variant_builder_add(&builder, "(ussss^as)", item->stage, item->activity, item->component, item->container, item->type, item->arguments);
+    }
+
+    return g_variant_builder_end(&builder);
+}
+
+static void remove_spooled_closure(void)
+{
+    if(spooled_closure != NULL)
+    {
+        unlink(spooled_closure);
+        g_free(spooled_closure);
+        spooled_closure = NULL;
+    }
+}
+
 /* Signal handlers */
 
 static void disnix_finish_signal_handler(GDBusProxy *proxy, const gint pid, gpointer user_data)
@@ -60,7 +310,11 @@ static void disnix_finish_signal_handler(GDBusProxy *proxy, const gint pid, gpoi
     gint my_pid = *((gint*)user_data);
 
     if(pid == my_pid)
+    {
+        finish_streaming_log();
+        remove_spooled_closure();
         exit(0);
+    }
 }
 
 static void disnix_success_signal_handler(GDBusProxy *proxy, const gint pid, gchar **paths, gpointer user_data)
@@ -69,12 +323,19 @@ static void disnix_success_signal_handler(GDBusProxy *proxy, const gint pid, gch
 
     if(pid == my_pid)
     {
-        unsigned int i;
+        finish_streaming_log();
+
+        if(stream_export)
+            exit(paths[0] == NULL ? 1 : write_file_to_stdout(paths[0]));
+        else
+        {
+            unsigned int i;
 
-        for(i = 0; i < g_strv_length(paths); i++)
-            g_print("%s\n", paths[i]);
+            for(i = 0; i < g_strv_length(paths); i++)
+                g_print("%s\n", paths[i]);
 
-        exit(0);
+            exit(0);
+        }
     }
 }
 
@@ -84,11 +345,34 @@ static void disnix_failure_signal_handler(GDBusProxy *proxy, const gint pid, gpo
 
     if(pid == my_pid)
     {
-        print_log(pid);
+        remove_spooled_closure();
+
+        /* If the log has been streamed, the user has already seen it */
+        if(streamed_log_fd == -1)
+            print_log(pid);
+        else
+            finish_streaming_log();
+
         exit(1);
     }
 }
 
+static void disnix_item_finish_signal_handler(GDBusProxy *proxy, const gint pid, const guint index, gpointer user_data)
+{
+    gint my_pid = *((gint*)user_data);
+
+    if(pid == my_pid)
+        statemgmt_print_activity_batch_result(stdout, index, TRUE);
+}
+
+static void disnix_item_failure_signal_handler(GDBusProxy *proxy, const gint pid, const guint index, gpointer user_data)
+{
+    gint my_pid = *((gint*)user_data);
+
+    if(pid == my_pid)
+        statemgmt_print_activity_batch_result(stdout, index, FALSE);
+}
+
 static void cleanup(OrgNixosDisnixDisnix *proxy, gchar **paths, gchar **arguments)
 {
     g_free(logdir);
@@ -172,6 +456,8 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
     g_signal_connect(proxy, "finish", G_CALLBACK(disnix_finish_signal_handler), &pid);
     g_signal_connect(proxy, "success", G_CALLBACK(disnix_success_signal_handler), &pid);
     g_signal_connect(proxy, "failure", G_CALLBACK(disnix_failure_signal_handler), &pid);
+    g_signal_connect(proxy, "item-finish", G_CALLBACK(disnix_item_finish_signal_handler), &pid);
+    g_signal_connect(proxy, "item-failure", G_CALLBACK(disnix_item_failure_signal_handler), &pid);
 
     /* Receive the logdir */
     org_nixos_disnix_disnix_call_get_logdir_sync(proxy, &logdir, NULL, &error);
@@ -200,7 +486,24 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
     switch(operation)
     {
         case OP_IMPORT:
-            if(paths[0] == NULL)
+            if(flags & FLAG_STREAM)
+            {
+                /* Let the service read the closure straight from our standard input */
+                if(!import_closure_from_fd(proxy, pid, 0, &error) && is_unknown_method(&error))
+                {
+                    /* Older services import closures from files, so we must spool the stream first */
+                    spooled_closure = spool_stdin_to_tempfile();
+
+                    if(spooled_closure == NULL)
+                    {
+                        cleanup(proxy, paths, arguments);
+                        return 1;
+                    }
+                    else
+                        org_nixos_disnix_disnix_call_import_sync(proxy, pid, spooled_closure, NULL, &error);
+                }
+            }
+            else if(paths[0] == NULL)
             {
                 g_printerr("ERROR: A Nix store component has to be specified!\n");
                 cleanup(proxy, paths, arguments);
@@ -210,7 +513,18 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
                 org_nixos_disnix_disnix_call_import_sync(proxy, pid, paths[0], NULL, &error);
             break;
         case OP_EXPORT:
-            org_nixos_disnix_disnix_call_export_sync(proxy, pid, (const gchar**) paths, NULL, &error);
+            if(flags & FLAG_STREAM)
+            {
+                /* Let the service write the closure straight to our standard output. The finish signal indicates that it is complete */
+                if(!export_closure_to_fd(proxy, pid, (const gchar**) paths, 1, &error) && is_unknown_method(&error))
+                {
+                    /* Older services export closures to tempfiles, which we have to copy to the standard output */
+                    stream_export = TRUE;
+                    org_nixos_disnix_disnix_call_export_sync(proxy, pid, (const gchar**) paths, NULL, &error);
+                }
+            }
+            else
+                org_nixos_disnix_disnix_call_export_sync(proxy, pid, (const gchar**) paths, NULL, &error);
             break;
         case OP_PRINT_INVALID:
             org_nixos_disnix_disnix_call_print_invalid_sync(proxy, pid, (const gchar**) paths, NULL, &error);
@@ -267,6 +581,22 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
             if(container != NULL)
                 org_nixos_disnix_disnix_call_restore_sync(proxy, pid, paths[0], container, type, (const gchar**) arguments, NULL, &error);
             break;
+        case OP_RUN_ACTIVITIES:
+            {
+                GPtrArray *batch = statemgmt_read_activity_batch(stdin);
+
+                if(batch == NULL || !statemgmt_check_activity_batch(batch))
+                {
+                    g_printerr("ERROR: Cannot read a valid batch of activities from the standard input!\n");
+                    delete_activity_batch(batch);
+                    cleanup(proxy, paths, arguments);
+                    return 1;
+                }
+
+                org_nixos_disnix_disnix_call_run_activities_sync(proxy, pid, create_activities_variant(batch), NULL, &error);
+                delete_activity_batch(batch);
+            }
+            break;
         case OP_LOCK:
             org_nixos_disnix_disnix_call_lock_sync(proxy, pid, profile, NULL, &error);
             break;
@@ -328,6 +658,7 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
     if(error != NULL)
     {
         g_printerr("Error while executing the operation! Reason: %s\n", error->message);
+        remove_spooled_closure();
         cleanup(proxy, paths, arguments);
         g_error_free(error);
         return 1;
@@ -342,6 +673,10 @@ int run_disnix_client(Operation operation, gchar **paths, const unsigned int fla
         return 1;
     }
 
+    /* Follow the job's log while it is in progress. Signals are dispatched by the main loop, so none can be missed */
+    if(flags & FLAG_STREAM_LOG)
+        start_streaming_log(proxy, pid);
+
     /* Run loop and wait for signals */
     g_main_loop_run(mainloop);
 
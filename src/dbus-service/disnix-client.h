@@ -22,6 +22,8 @@
 
 #define FLAG_DELETE_OLD 0x1
 #define FLAG_SESSION_BUS 0x2
+#define FLAG_STREAM 0x4
+#define FLAG_STREAM_LOG 0x8
 
 #include <glib.h>
 
@@ -53,7 +55,8 @@ typedef enum
     OP_CLEAN_SNAPSHOTS,
     OP_DELETE_STATE,
     OP_CAPTURE_CONFIG,
-    OP_SHELL
+    OP_SHELL,
+    OP_RUN_ACTIVITIES
 }
 Operation;
 
@@ -18,11 +18,11 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <getopt.h>
 #include "disnix-service.h"
-
-#define TRUE 1
-#define FALSE 0
+#include "scheduling.h"
+#include "logretention.h"
 
 static void print_usage(const char *command)
 {
@@ -54,6 +54,30 @@ static void print_usage(const char *command)
     "                     is stored (defaults to: /var/run/disnix-service.pid)\n"
     "      --log-file     Specifies to which file the general daemon output messages\n"
     "                     should be logged (defaults to: /var/log/disnix.log)\n"
+    "      --max-concurrent-transfers=NUM\n"
+    "                     Maximum amount of imports and exports of closures and\n"
+    "                     snapshots that may run concurrently (defaults to: 0,\n"
+    "                     which means no limit)\n"
+    "      --max-concurrent-builds=NUM\n"
+    "                     Maximum amount of realisations and garbage collections\n"
+    "                     that may run concurrently (defaults to: 0, which means\n"
+    "                     no limit)\n"
+    "      --max-concurrent-activities=NUM\n"
+    "                     Maximum amount of Dysnomia activities that may run\n"
+    "                     concurrently (defaults to: 0, which means no limit)\n"
+    "      --log-retention-count=NUM\n"
+    "                     Maximum amount of job logs that are kept in the log\n"
+    "                     directory (defaults to: 0, which means no limit)\n"
+    "      --log-retention-age=DAYS\n"
+    "                     Removes job logs that are older than the given amount of\n"
+    "                     days (defaults to: 0, which means no limit)\n"
+    "      --log-retention-size=MIB\n"
+    "                     Maximum total size in MiB of the job logs that are kept\n"
+    "                     in the log directory (defaults to: 0, which means no\n"
+    "                     limit)\n"
+    "      --compress-logs\n"
+    "                     Compresses job logs that have not been modified for a\n"
+    "                     day with gzip\n"
     "  -h, --help         Shows the usage of this command to the user\n"
     "  -v, --version      Shows the version of this command to the user\n"
     );
@@ -74,6 +98,13 @@ typedef enum
     DISNIX_SERVICE_OPTION_LOG_DIR = 257,
     DISNIX_SERVICE_OPTION_PID_FILE = 258,
     DISNIX_SERVICE_OPTION_LOG_FILE = 259,
+    DISNIX_SERVICE_OPTION_MAX_CONCURRENT_TRANSFERS = 260,
+    DISNIX_SERVICE_OPTION_MAX_CONCURRENT_BUILDS = 261,
+    DISNIX_SERVICE_OPTION_MAX_CONCURRENT_ACTIVITIES = 262,
+    DISNIX_SERVICE_OPTION_LOG_RETENTION_COUNT = 263,
+    DISNIX_SERVICE_OPTION_LOG_RETENTION_AGE = 264,
+    DISNIX_SERVICE_OPTION_LOG_RETENTION_SIZE = 265,
+    DISNIX_SERVICE_OPTION_COMPRESS_LOGS = 266,
     DISNIX_SERVICE_OPTION_HELP = 'h',
     DISNIX_SERVICE_OPTION_VERSION = 'v'
 }
@@ -90,6 +121,13 @@ int main(int argc, char *argv[])
         {"log-dir", required_argument, 0, DISNIX_SERVICE_OPTION_LOG_DIR},
         {"pid-file", required_argument, 0, DISNIX_SERVICE_OPTION_PID_FILE},
         {"log-file", required_argument, 0, DISNIX_SERVICE_OPTION_LOG_FILE},
+        {"max-concurrent-transfers", required_argument, 0, DISNIX_SERVICE_OPTION_MAX_CONCURRENT_TRANSFERS},
+        {"max-concurrent-builds", required_argument, 0, DISNIX_SERVICE_OPTION_MAX_CONCURRENT_BUILDS},
+        {"max-concurrent-activities", required_argument, 0, DISNIX_SERVICE_OPTION_MAX_CONCURRENT_ACTIVITIES},
+        {"log-retention-count", required_argument, 0, DISNIX_SERVICE_OPTION_LOG_RETENTION_COUNT},
+        {"log-retention-age", required_argument, 0, DISNIX_SERVICE_OPTION_LOG_RETENTION_AGE},
+        {"log-retention-size", required_argument, 0, DISNIX_SERVICE_OPTION_LOG_RETENTION_SIZE},
+        {"compress-logs", no_argument, 0, DISNIX_SERVICE_OPTION_COMPRESS_LOGS},
         {"help", no_argument, 0, DISNIX_SERVICE_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_SERVICE_OPTION_VERSION},
         {0, 0, 0, 0}
@@ -121,6 +159,27 @@ int main(int argc, char *argv[])
             case DISNIX_SERVICE_OPTION_LOG_FILE:
                 log_file = optarg;
                 break;
+            case DISNIX_SERVICE_OPTION_MAX_CONCURRENT_TRANSFERS:
+                set_max_concurrent_jobs(JOB_CLASS_TRANSFER, atoi(optarg));
+                break;
+            case DISNIX_SERVICE_OPTION_MAX_CONCURRENT_BUILDS:
+                set_max_concurrent_jobs(JOB_CLASS_BUILD, atoi(optarg));
+                break;
+            case DISNIX_SERVICE_OPTION_MAX_CONCURRENT_ACTIVITIES:
+                set_max_concurrent_jobs(JOB_CLASS_ACTIVITY, atoi(optarg));
+                break;
+            case DISNIX_SERVICE_OPTION_LOG_RETENTION_COUNT:
+                set_log_retention_count(atoi(optarg));
+                break;
+            case DISNIX_SERVICE_OPTION_LOG_RETENTION_AGE:
+                set_log_retention_age(atoi(optarg));
+                break;
+            case DISNIX_SERVICE_OPTION_LOG_RETENTION_SIZE:
+                set_log_retention_size(strtoull(optarg, NULL, 10) * 1024 * 1024);
+                break;
+            case DISNIX_SERVICE_OPTION_COMPRESS_LOGS:
+                set_log_compression(TRUE);
+                break;
             case DISNIX_SERVICE_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
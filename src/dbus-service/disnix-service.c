@@ -25,6 +25,7 @@
 #include <glib-unix.h>
 #include "disnix-dbus.h"
 #include "jobmanagement.h"
+#include "logretention.h"
 #include "logging.h"
 #include "methods.h"
 #include "daemonize.h"
@@ -64,6 +65,8 @@ static void on_bus_acquired(GDBusConnection *connection, const gchar *name, gpoi
     g_signal_connect(interface, "handle-get-job-id", G_CALLBACK(on_handle_get_job_id), NULL);
     g_signal_connect(interface, "handle-import", G_CALLBACK(on_handle_import), NULL);
     g_signal_connect(interface, "handle-export", G_CALLBACK(on_handle_export), NULL);
+    g_signal_connect(interface, "handle-import-fd", G_CALLBACK(on_handle_import_fd), NULL);
+    g_signal_connect(interface, "handle-export-fd", G_CALLBACK(on_handle_export_fd), NULL);
     g_signal_connect(interface, "handle-print-invalid", G_CALLBACK(on_handle_print_invalid), NULL);
     g_signal_connect(interface, "handle-realise", G_CALLBACK(on_handle_realise), NULL);
     g_signal_connect(interface, "handle-set", G_CALLBACK(on_handle_set), NULL);
@@ -72,6 +75,7 @@ static void on_bus_acquired(GDBusConnection *connection, const gchar *name, gpoi
     g_signal_connect(interface, "handle-collect-garbage", G_CALLBACK(on_handle_collect_garbage), NULL);
     g_signal_connect(interface, "handle-activate", G_CALLBACK(on_handle_activate), NULL);
     g_signal_connect(interface, "handle-deactivate", G_CALLBACK(on_handle_deactivate), NULL);
+    g_signal_connect(interface, "handle-run-activities", G_CALLBACK(on_handle_run_activities), NULL);
     g_signal_connect(interface, "handle-lock", G_CALLBACK(on_handle_lock), NULL);
     g_signal_connect(interface, "handle-unlock", G_CALLBACK(on_handle_unlock), NULL);
     g_signal_connect(interface, "handle-delete-state", G_CALLBACK(on_handle_delete_state), NULL);
@@ -84,6 +88,7 @@ static void on_bus_acquired(GDBusConnection *connection, const gchar *name, gpoi
     g_signal_connect(interface, "handle-resolve-snapshots", G_CALLBACK(on_handle_resolve_snapshots), NULL);
     g_signal_connect(interface, "handle-clean-snapshots", G_CALLBACK(on_handle_clean_snapshots), NULL);
     g_signal_connect(interface, "handle-get-logdir", G_CALLBACK(on_handle_get_logdir), NULL);
+    g_signal_connect(interface, "handle-open-log", G_CALLBACK(on_handle_open_log), NULL);
     g_signal_connect(interface, "handle-capture-config", G_CALLBACK(on_handle_capture_config), NULL);
 
     /* Export skeleton */
@@ -152,6 +157,9 @@ static ProcReact_bool initialize_disnix_service(void *data)
     /* Figure out what the next job id number is */
     determine_next_pid(logdir);
 
+    /* Keep the log directory from growing without bounds */
+    start_log_retention(logdir);
+
     /* Connect to the system/session bus */
     GBusType bus_type;
 
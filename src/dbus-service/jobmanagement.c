@@ -20,10 +20,28 @@
 #include "jobmanagement.h"
 #include <stdlib.h>
 #include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+/* Name of the file in the log directory that records the job ids that have been handed out */
+#define JOB_COUNTER_FILE ".job-counter"
+
+/*
+ * Amount of job ids that are reserved with a single update of the counter file.
+ * After a restart, the unused ids of the last reservation are skipped.
+ */
+#define JOB_ID_RESERVATION 1024
 
 /* Provides each job a unique job id */
 int job_counter;
 
+/* Job ids below this value have been reserved in the counter file */
+static int reserved_job_counter;
+
+/* Path to the counter file */
+static gchar *job_counter_file = NULL;
+
 static int numbersort(const struct dirent **a, const struct dirent **b)
 {
     int left = atoi((*a)->d_name);
@@ -37,26 +55,89 @@ static int numbersort(const struct dirent **a, const struct dirent **b)
         return 0;
 }
 
-void determine_next_pid(char *logdir)
+static int scan_next_pid(char *logdir)
 {
     struct dirent **namelist;
     int num_of_entries = scandir(logdir, &namelist, 0, numbersort);
     
     if(num_of_entries <= 0)
-       job_counter = 0;
+       return 0;
     else
     {
-       char *filename = namelist[num_of_entries - 1]->d_name;
-       job_counter = atoi(filename);
-       job_counter++;
-       free(namelist[num_of_entries - 1]);
+       int i, next_pid = atoi(namelist[num_of_entries - 1]->d_name) + 1;
+
+       for(i = 0; i < num_of_entries; i++)
+           free(namelist[i]);
+
        free(namelist);
+       return next_pid;
+    }
+}
+
+static gboolean read_job_counter(int *value)
+{
+    gchar *contents;
+    gboolean status = FALSE;
+
+    if(g_file_get_contents(job_counter_file, &contents, NULL, NULL))
+    {
+        char *end;
+        gint64 counter = g_ascii_strtoll(contents, &end, 10);
+
+        if(end != contents && (*end == '\n' || *end == '\0') && counter >= 0 && counter <= G_MAXINT)
+        {
+            *value = (int)counter;
+            status = TRUE;
+        }
+
+        g_free(contents);
+    }
+
+    return status;
+}
+
+static void reserve_job_ids(void)
+{
+    GError *error = NULL;
+    gchar *contents;
+
+    if(job_counter > G_MAXINT - JOB_ID_RESERVATION)
+        reserved_job_counter = G_MAXINT;
+    else
+        reserved_job_counter = job_counter + JOB_ID_RESERVATION;
+
+    contents = g_strdup_printf("%d\n", reserved_job_counter);
+
+    /* g_file_set_contents() writes a temp file and renames it, so that the counter is updated atomically */
+    if(!g_file_set_contents(job_counter_file, contents, -1, &error))
+    {
+        g_printerr("Cannot update the job counter file: %s\n", error->message);
+        g_error_free(error);
     }
+
+    g_free(contents);
+}
+
+void determine_next_pid(char *logdir)
+{
+    g_free(job_counter_file);
+    job_counter_file = g_strconcat(logdir, "/" JOB_COUNTER_FILE, NULL);
+
+    /* Use the counter file if it exists. Otherwise, fall back to scanning the log files, for example after an upgrade */
+    if(!read_job_counter(&job_counter))
+        job_counter = scan_next_pid(logdir);
+
+    mkdir(logdir, 0755);
+    reserve_job_ids();
 }
 
 int assign_pid(void)
 {
     int return_value = job_counter;
     job_counter++;
+
+    if(job_counter >= reserved_job_counter)
+        reserve_job_ids();
+
     return return_value;
 }
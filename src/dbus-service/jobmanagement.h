@@ -21,15 +21,18 @@
 #define __DISNIX_JOBMANAGEMENT_H
 
 /**
- * Determines what the next job id would be by inspecting the log files stored
- * in the log directory.
+ * Determines what the next job id would be by reading the job counter file in
+ * the log directory. If the counter file does not exist, it inspects the log
+ * files stored in the log directory instead. Then it reserves a range of job
+ * ids in the counter file, so that job ids are never reused after a restart.
  *
  * @param logdir Path to the log directory
  */
 void determine_next_pid(char *logdir);
 
 /**
- * Assigns a pid to a job.
+ * Assigns a pid to a job. When the reserved range of job ids is exhausted, a
+ * new range is reserved in the counter file.
  *
  * @return A numeric job id
  */
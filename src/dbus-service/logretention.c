@@ -0,0 +1,253 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "logretention.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <gio/gio.h>
+#include <procreact_pid.h>
+#include <procreact_spawn.h>
+#include "scheduling.h"
+
+/* Amount of seconds between two log retention passes */
+#define LOG_RETENTION_INTERVAL 3600
+
+/* Amount of seconds after which an unmodified log gets compressed */
+#define LOG_COMPRESSION_AGE (24 * 3600)
+
+#define SECONDS_PER_DAY (24 * 3600)
+
+static unsigned int max_log_count = 0;
+
+static unsigned int max_log_age = 0;
+
+static guint64 max_log_size = 0;
+
+static gboolean compress_logs = FALSE;
+
+/* Path to the log directory */
+static char *retention_logdir = NULL;
+
+/* Indicates whether a thread is applying the retention policy */
+static gboolean retention_in_progress = FALSE;
+
+void set_log_retention_count(unsigned int count)
+{
+    max_log_count = count;
+}
+
+void set_log_retention_age(unsigned int age)
+{
+    max_log_age = age;
+}
+
+void set_log_retention_size(guint64 size)
+{
+    max_log_size = size;
+}
+
+void set_log_compression(gboolean compress)
+{
+    compress_logs = compress;
+}
+
+/* Job logs are named after their job id, optionally followed by a .gz suffix */
+static int is_log_file(const struct dirent *entry)
+{
+    const char *name = entry->d_name;
+
+    if(*name < '0' || *name > '9')
+        return FALSE;
+
+    while(*name >= '0' && *name <= '9')
+        name++;
+
+    return (*name == '\0' || strcmp(name, ".gz") == 0);
+}
+
+static int numbersort(const struct dirent **a, const struct dirent **b)
+{
+    int left = atoi((*a)->d_name);
+    int right = atoi((*b)->d_name);
+
+    if(left < right)
+        return -1;
+    else if(left > right)
+        return 1;
+    else
+        return 0;
+}
+
+static ProcReact_bool compress_log_file(const char *path)
+{
+    ProcReact_Status status;
+    char *const args[] = {"gzip", "-f", (char*)path, NULL};
+    pid_t pid = procreact_spawn(args, NULL, -1, -1, 2, 0);
+    return (procreact_wait_for_boolean(pid, &status) && status == PROCREACT_STATUS_OK);
+}
+
+static gboolean log_has_expired(const struct stat *st, unsigned int remaining_count, guint64 remaining_size, time_t now)
+{
+    return (max_log_count > 0 && remaining_count > max_log_count)
+        || (max_log_age > 0 && now - st->st_mtime > (time_t)max_log_age * SECONDS_PER_DAY)
+        || (max_log_size > 0 && remaining_size > max_log_size);
+}
+
+/*
+ * Logs of jobs that are in progress must be kept, even if they exceed the
+ * limits. Jobs that are not scheduled, or that have started after this pass,
+ * are not known to the scheduler, so recently modified logs are kept as well.
+ */
+static gboolean log_is_in_use(GHashTable *jobs_table, const char *name, const struct stat *st, time_t now)
+{
+    return g_hash_table_contains(jobs_table, GINT_TO_POINTER(atoi(name))) || now - st->st_mtime < LOG_RETENTION_INTERVAL;
+}
+
+static int apply_log_retention_policy(GHashTable *jobs_table)
+{
+    struct dirent **namelist;
+    struct stat *stats;
+    int i, num_of_entries = scandir(retention_logdir, &namelist, is_log_file, numbersort);
+    unsigned int remaining_count = 0;
+    guint64 remaining_size = 0;
+    time_t now = time(NULL);
+    int exit_status = 0;
+
+    if(num_of_entries < 0)
+    {
+        fprintf(stderr, "Cannot scan the log directory: %s\n", retention_logdir);
+        return 1;
+    }
+
+    /* Determine the modification times and sizes of all job logs */
+    stats = (struct stat*)g_malloc0(num_of_entries * sizeof(struct stat));
+
+    for(i = 0; i < num_of_entries; i++)
+    {
+        gchar *path = g_strconcat(retention_logdir, "/", namelist[i]->d_name, NULL);
+
+        if(stat(path, &stats[i]) == 0)
+        {
+            remaining_count++;
+            remaining_size += stats[i].st_size;
+        }
+        else
+            namelist[i]->d_name[0] = '\0'; /* The log has disappeared in the meantime */
+
+        g_free(path);
+    }
+
+    /* Remove or compress the job logs, starting with the oldest */
+    for(i = 0; i < num_of_entries; i++)
+    {
+        if(namelist[i]->d_name[0] != '\0')
+        {
+            gchar *path = g_strconcat(retention_logdir, "/", namelist[i]->d_name, NULL);
+
+            /* Keep the logs that may still be written to */
+            if(!log_is_in_use(jobs_table, namelist[i]->d_name, &stats[i], now))
+            {
+                if(log_has_expired(&stats[i], remaining_count, remaining_size, now))
+                {
+                    if(unlink(path) == 0)
+                    {
+                        remaining_count--;
+                        remaining_size -= stats[i].st_size;
+                    }
+                    else
+                    {
+                        fprintf(stderr, "Cannot remove log file: %s\n", path);
+                        exit_status = 1;
+                    }
+                }
+                else if(compress_logs && !g_str_has_suffix(path, ".gz") && now - stats[i].st_mtime > LOG_COMPRESSION_AGE)
+                {
+                    if(!compress_log_file(path))
+                    {
+                        fprintf(stderr, "Cannot compress log file: %s\n", path);
+                        exit_status = 1;
+                    }
+                }
+            }
+
+            g_free(path);
+        }
+
+        free(namelist[i]);
+    }
+
+    free(namelist);
+    g_free(stats);
+    return exit_status;
+}
+
+static void apply_log_retention_policy_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    g_task_return_boolean(task, apply_log_retention_policy((GHashTable*)task_data) == 0);
+}
+
+static void on_log_retention_finished(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+    if(!g_task_propagate_boolean(G_TASK(result), NULL))
+        g_printerr("Cannot completely apply the log retention policy!\n");
+
+    retention_in_progress = FALSE;
+}
+
+static gboolean run_log_retention(gpointer user_data)
+{
+    /* Skip this pass if the previous one is still in progress */
+    if(!retention_in_progress)
+    {
+        /*
+         * The scheduler is only accessed from the main loop, so we take a
+         * snapshot of the jobs in progress before the thread starts.
+         */
+        GTask *task = g_task_new(NULL, NULL, on_log_retention_finished, NULL);
+        g_task_set_task_data(task, query_jobs_in_progress(), (GDestroyNotify)g_hash_table_destroy);
+
+        retention_in_progress = TRUE;
+        g_task_run_in_thread(task, apply_log_retention_policy_thread);
+        g_object_unref(task);
+    }
+
+    return TRUE;
+}
+
+static gboolean run_initial_log_retention(gpointer user_data)
+{
+    run_log_retention(user_data);
+    return FALSE;
+}
+
+void start_log_retention(char *logdir)
+{
+    if(max_log_count > 0 || max_log_age > 0 || max_log_size > 0 || compress_logs)
+    {
+        retention_logdir = logdir;
+        g_idle_add(run_initial_log_retention, NULL);
+        g_timeout_add_seconds(LOG_RETENTION_INTERVAL, run_log_retention, NULL);
+    }
+}
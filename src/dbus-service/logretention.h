@@ -0,0 +1,66 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_LOGRETENTION_H
+#define __DISNIX_LOGRETENTION_H
+#include <glib.h>
+
+/**
+ * Configures the maximum amount of job logs that are kept in the log directory.
+ *
+ * @param max_log_count Maximum amount of job logs or 0 for no limit
+ */
+void set_log_retention_count(unsigned int max_log_count);
+
+/**
+ * Configures the maximum age of the job logs that are kept in the log directory.
+ *
+ * @param max_log_age Maximum age in days or 0 for no limit
+ */
+void set_log_retention_age(unsigned int max_log_age);
+
+/**
+ * Configures the maximum total size of the job logs that are kept in the log
+ * directory.
+ *
+ * @param max_log_size Maximum total size in bytes or 0 for no limit
+ */
+void set_log_retention_size(guint64 max_log_size);
+
+/**
+ * Configures whether job logs that have not been modified for a day should be
+ * compressed with gzip.
+ *
+ * @param compress_logs TRUE to compress old job logs, else FALSE
+ */
+void set_log_compression(gboolean compress_logs);
+
+/**
+ * Periodically applies the log retention policy to the log directory. Every
+ * pass runs in a separate thread, so that the service can keep handling
+ * requests while the log directory is inspected. The oldest job logs are
+ * removed first. Logs of jobs that are in progress and logs that have been
+ * modified since the previous pass are never removed. If no policy has been
+ * configured, this function does nothing.
+ *
+ * @param logdir Path to the log directory
+ */
+void start_log_retention(char *logdir);
+
+#endif
@@ -20,14 +20,18 @@
 #include "methods.h"
 #include <stdio.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <glib.h>
+#include <gio/gunixfdlist.h>
 #include "logging.h"
 #include "locking.h"
 #include "jobmanagement.h"
 #include "signaling.h"
+#include "scheduling.h"
 #include "package-management.h"
 #include "state-management.h"
 #include "snapshot-management.h"
+#include "activity-batch.h"
 
 #define BUFFER_SIZE 1024
 
@@ -45,6 +49,13 @@ gboolean on_handle_get_job_id(OrgNixosDisnixDisnix *object, GDBusMethodInvocatio
 
 /* Import method */
 
+static void start_import(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar *closure;
+    g_variant_get(parameters, "(i&s)", NULL, &closure);
+    signal_boolean_result(pkgmgmt_import_closure(closure, log_fd, log_fd), object, jid, log_fd);
+}
+
 gboolean on_handle_import(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_closure)
 {
     int log_fd = open_log_file(object, arg_pid);
@@ -54,8 +65,8 @@ gboolean on_handle_import(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *i
         /* Print log entry */
         dprintf(log_fd, "Importing: %s\n", arg_closure);
 
-        /* Execute command */
-        signal_boolean_result(pkgmgmt_import_closure(arg_closure, log_fd, log_fd), object, arg_pid, log_fd);
+        /* Execute command when there is capacity */
+        schedule_job(JOB_CLASS_TRANSFER, start_import, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_import(object, invocation);
@@ -64,30 +75,133 @@ gboolean on_handle_import(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *i
 
 /* Export method */
 
+static void start_export(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar **derivation;
+    pid_t pid;
+    int temp_fd;
+    gchar *tempfilename;
+
+    g_variant_get(parameters, "(i^a&s)", NULL, &derivation);
+    tempfilename = pkgmgmt_export_closure(tmpdir, (gchar**)derivation, g_strv_length((gchar**)derivation), log_fd, &pid, &temp_fd);
+    signal_tempfile_result(pid, tempfilename, temp_fd, object, jid, log_fd);
+    g_free(derivation);
+}
+
 gboolean on_handle_export(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation)
 {
     int log_fd = open_log_file(object, arg_pid);
 
     if(log_fd != -1)
     {
-        pid_t pid;
-        int temp_fd;
-        gchar *tempfilename;
-
         /* Print log entry */
         dprintf(log_fd, "Exporting: ");
         print_paths(log_fd, (gchar**)arg_derivation);
         dprintf(log_fd, "\n");
 
-        /* Execute command */
-        tempfilename = pkgmgmt_export_closure(tmpdir, (gchar**)arg_derivation, g_strv_length((gchar**)arg_derivation), log_fd, &pid, &temp_fd);
-        signal_tempfile_result(pid, tempfilename, temp_fd, object, arg_pid, log_fd);
+        /* Execute command when there is capacity */
+        schedule_job(JOB_CLASS_TRANSFER, start_export, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_export(object, invocation);
     return TRUE;
 }
 
+/*
+ * File descriptor based import and export methods. The client passes one end
+ * of a pipe (or its own standard input or output), so that the closure is
+ * streamed between the client and Nix without being stored in a tempfile.
+ */
+
+static int receive_closure_fd(GUnixFDList *fd_list, gint handle, int log_fd)
+{
+    GError *error = NULL;
+    int closure_fd = g_unix_fd_list_get(fd_list, handle, &error);
+
+    if(error != NULL)
+    {
+        dprintf(log_fd, "Cannot receive the file descriptor of the closure: %s\n", error->message);
+        g_error_free(error);
+    }
+
+    return closure_fd;
+}
+
+/* Import from file descriptor method */
+
+static void start_import_fd(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    gint closure_fd;
+    g_variant_get(parameters, "(ih)", NULL, &closure_fd);
+    signal_boolean_result(pkgmgmt_import_closure_fd(closure_fd, log_fd, log_fd), object, jid, log_fd);
+    close(closure_fd); /* The import process has its own copy */
+}
+
+gboolean on_handle_import_fd(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid, gint arg_closure)
+{
+    int log_fd = open_log_file(object, arg_pid);
+
+    if(log_fd != -1)
+    {
+        int closure_fd;
+
+        /* Print log entry */
+        dprintf(log_fd, "Importing closure from stream\n");
+
+        /* Execute command when there is capacity. The job refers to the received descriptor instead of the handle */
+        if((closure_fd = receive_closure_fd(fd_list, arg_closure, log_fd)) == -1)
+        {
+            org_nixos_disnix_disnix_emit_failure(object, arg_pid);
+            close(log_fd);
+        }
+        else
+            schedule_job(JOB_CLASS_TRANSFER, start_import_fd, object, arg_pid, log_fd, g_variant_new("(ih)", arg_pid, closure_fd));
+    }
+
+    org_nixos_disnix_disnix_complete_import_fd(object, invocation, NULL);
+    return TRUE;
+}
+
+/* Export to file descriptor method */
+
+static void start_export_fd(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar **derivation;
+    gint closure_fd;
+
+    g_variant_get(parameters, "(i^a&sh)", NULL, &derivation, &closure_fd);
+    signal_boolean_result(pkgmgmt_export_closure_fd((gchar**)derivation, g_strv_length((gchar**)derivation), closure_fd, log_fd), object, jid, log_fd);
+    close(closure_fd); /* The export process has its own copy, so that the client observes the end of the stream when it finishes */
+    g_free(derivation);
+}
+
+gboolean on_handle_export_fd(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid, const gchar *const *arg_derivation, gint arg_closure)
+{
+    int log_fd = open_log_file(object, arg_pid);
+
+    if(log_fd != -1)
+    {
+        int closure_fd;
+
+        /* Print log entry */
+        dprintf(log_fd, "Exporting to stream: ");
+        print_paths(log_fd, (gchar**)arg_derivation);
+        dprintf(log_fd, "\n");
+
+        /* Execute command when there is capacity. The job refers to the received descriptor instead of the handle */
+        if((closure_fd = receive_closure_fd(fd_list, arg_closure, log_fd)) == -1)
+        {
+            org_nixos_disnix_disnix_emit_failure(object, arg_pid);
+            close(log_fd);
+        }
+        else
+            schedule_job(JOB_CLASS_TRANSFER, start_export_fd, object, arg_pid, log_fd, g_variant_new("(i^ash)", arg_pid, arg_derivation, closure_fd));
+    }
+
+    org_nixos_disnix_disnix_complete_export_fd(object, invocation, NULL);
+    return TRUE;
+}
+
 /* Print invalid paths method */
 
 gboolean on_handle_print_invalid(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation)
@@ -111,6 +225,14 @@ gboolean on_handle_print_invalid(OrgNixosDisnixDisnix *object, GDBusMethodInvoca
 
 /* Realise method */
 
+static void start_realise(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar **derivation;
+    g_variant_get(parameters, "(i^a&s)", NULL, &derivation);
+    signal_strv_result(pkgmgmt_realise((gchar**)derivation, g_strv_length((gchar**)derivation), log_fd), object, jid, log_fd);
+    g_free(derivation);
+}
+
 gboolean on_handle_realise(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation)
 {
     int log_fd = open_log_file(object, arg_pid);
@@ -122,8 +244,8 @@ gboolean on_handle_realise(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *
         print_paths(log_fd, (gchar**)arg_derivation);
         dprintf(log_fd, "\n");
 
-        /* Execute command and wait and asychronously propagate its end result */
-        signal_strv_result(pkgmgmt_realise((gchar**)arg_derivation, g_strv_length((gchar**)arg_derivation), log_fd), object, arg_pid, log_fd);
+        /* Execute command when there is capacity and asychronously propagate its end result */
+        schedule_job(JOB_CLASS_BUILD, start_realise, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_realise(object, invocation);
@@ -191,6 +313,13 @@ gboolean on_handle_query_requisites(OrgNixosDisnixDisnix *object, GDBusMethodInv
 
 /* Garbage collect method */
 
+static void start_collect_garbage(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    gboolean delete_old;
+    g_variant_get(parameters, "(ib)", NULL, &delete_old);
+    signal_boolean_result(pkgmgmt_collect_garbage(delete_old, log_fd, log_fd), object, jid, log_fd);
+}
+
 gboolean on_handle_collect_garbage(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, gboolean arg_delete_old)
 {
     int log_fd = open_log_file(object, arg_pid);
@@ -203,8 +332,8 @@ gboolean on_handle_collect_garbage(OrgNixosDisnixDisnix *object, GDBusMethodInvo
         else
             dprintf(log_fd, "Garbage collect\n");
 
-        /* Execute command */
-        signal_boolean_result(pkgmgmt_collect_garbage(arg_delete_old, log_fd, log_fd), object, arg_pid, log_fd);
+        /* Execute command when there is capacity */
+        schedule_job(JOB_CLASS_BUILD, start_collect_garbage, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_collect_garbage(object, invocation);
@@ -215,7 +344,17 @@ gboolean on_handle_collect_garbage(OrgNixosDisnixDisnix *object, GDBusMethodInvo
 
 typedef pid_t StateActivityFunction(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd);
 
-static gboolean on_handle_state_activity(gchar *activity, StateActivityFunction *activity_function, OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
+static void start_state_activity(StateActivityFunction *activity_function, OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar *derivation, *container, *type;
+    const gchar **arguments;
+
+    g_variant_get(parameters, "(i&s&s&s^a&s)", NULL, &derivation, &container, &type, &arguments);
+    signal_boolean_result(activity_function((gchar*)type, (gchar*)derivation, (gchar*)container, (gchar**)arguments, log_fd, log_fd), object, jid, log_fd);
+    g_free(arguments);
+}
+
+static gboolean on_handle_state_activity(gchar *activity, start_job_function start_activity, OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
     int log_fd = open_log_file(object, arg_pid);
 
@@ -226,8 +365,8 @@ static gboolean on_handle_state_activity(gchar *activity, StateActivityFunction
         print_paths(log_fd, (gchar**)arg_arguments);
         dprintf(log_fd, "\n");
 
-        /* Execute command */
-        signal_boolean_result(activity_function((gchar*)arg_type, (gchar*)arg_derivation, (gchar*)arg_container, (gchar**)arg_arguments, log_fd, log_fd), object, arg_pid, log_fd);
+        /* Execute command when there is capacity */
+        schedule_job(JOB_CLASS_ACTIVITY, start_activity, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_activate(object, invocation);
@@ -236,16 +375,63 @@ static gboolean on_handle_state_activity(gchar *activity, StateActivityFunction
 
 /* Activate method */
 
+static void start_activate(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    start_state_activity(statemgmt_activate, object, jid, log_fd, parameters);
+}
+
 gboolean on_handle_activate(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
-    return on_handle_state_activity("activate", statemgmt_activate, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+    return on_handle_state_activity("activate", start_activate, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
 }
 
 /* Deactivate method */
 
+static void start_deactivate(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    start_state_activity(statemgmt_deactivate, object, jid, log_fd, parameters);
+}
+
 gboolean on_handle_deactivate(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
-    return on_handle_state_activity("deactivate", statemgmt_deactivate, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+    return on_handle_state_activity("deactivate", start_deactivate, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+}
+
+/* Run activities method */
+
+static void start_run_activities(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    GPtrArray *batch = g_ptr_array_new();
+    GVariantIter *iter;
+    guint stage;
+    const gchar *activity, *derivation, *container, *type;
+    const gchar **arguments;
+
+    g_variant_get(parameters, "(ia(ussssas))", NULL, &iter);
+
+    while(g_variant_iter_loop(iter, "(u&s&s&s&s^a&s)", &stage, &activity, &derivation, &container, &type, &arguments))
+        g_ptr_array_add(batch, create_activity_batch_item(stage, activity, type, container, (gchar**)arguments, g_strv_length((gchar**)arguments), derivation));
+
+    g_variant_iter_free(iter);
+
+    signal_activity_batch_results(batch, object, jid, log_fd);
+}
+
+gboolean on_handle_run_activities(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, GVariant *arg_activities)
+{
+    int log_fd = open_log_file(object, arg_pid);
+
+    if(log_fd != -1)
+    {
+        /* Print log entry */
+        dprintf(log_fd, "Running a batch of %lu activities\n", (unsigned long)g_variant_n_children(arg_activities));
+
+        /* Execute the batch as a single job when there is capacity */
+        schedule_job(JOB_CLASS_ACTIVITY, start_run_activities, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
+    }
+
+    org_nixos_disnix_disnix_complete_run_activities(object, invocation);
+    return TRUE;
 }
 
 /* Lock method */
@@ -326,16 +512,26 @@ gboolean on_handle_unlock(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *i
 
 /* Snapshot method */
 
+static void start_snapshot(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    start_state_activity(statemgmt_snapshot, object, jid, log_fd, parameters);
+}
+
 gboolean on_handle_snapshot(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
-    return on_handle_state_activity("snapshot", statemgmt_snapshot, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+    return on_handle_state_activity("snapshot", start_snapshot, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
 }
 
 /* Restore method */
 
+static void start_restore(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    start_state_activity(statemgmt_restore, object, jid, log_fd, parameters);
+}
+
 gboolean on_handle_restore(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
-    return on_handle_state_activity("restore", statemgmt_restore, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+    return on_handle_state_activity("restore", start_restore, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
 }
 
 /* Query all snapshots method */
@@ -399,6 +595,16 @@ gboolean on_handle_print_missing_snapshots(OrgNixosDisnixDisnix *object, GDBusMe
 
 /* Import snapshots operation */
 
+static void start_import_snapshots(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    const gchar *container, *component;
+    const gchar **snapshots;
+
+    g_variant_get(parameters, "(i&s&s^a&s)", NULL, &container, &component, &snapshots);
+    signal_boolean_result(statemgmt_import_snapshots((gchar*)container, (gchar*)component, (gchar**)snapshots, g_strv_length((gchar**)snapshots), log_fd, log_fd), object, jid, log_fd);
+    g_free(snapshots);
+}
+
 gboolean on_handle_import_snapshots(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_container, const gchar *arg_component, const gchar *const *arg_snapshots)
 {
     int log_fd = open_log_file(object, arg_pid);
@@ -410,8 +616,8 @@ gboolean on_handle_import_snapshots(OrgNixosDisnixDisnix *object, GDBusMethodInv
         print_paths(log_fd, (gchar**)arg_snapshots);
         dprintf(log_fd, "\n");
 
-        /* Execute command */
-        signal_boolean_result(statemgmt_import_snapshots((gchar*)arg_container, (gchar*)arg_component, (gchar**)arg_snapshots, g_strv_length((gchar**)arg_snapshots), log_fd, log_fd), object, arg_pid, log_fd);
+        /* Execute command when there is capacity */
+        schedule_job(JOB_CLASS_TRANSFER, start_import_snapshots, object, arg_pid, log_fd, g_dbus_method_invocation_get_parameters(invocation));
     }
 
     org_nixos_disnix_disnix_complete_import_snapshots(object, invocation);
@@ -468,9 +674,14 @@ gboolean on_handle_clean_snapshots(OrgNixosDisnixDisnix *object, GDBusMethodInvo
 
 /* Delete state operation */
 
+static void start_delete_state(OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    start_state_activity(statemgmt_collect_garbage, object, jid, log_fd, parameters);
+}
+
 gboolean on_handle_delete_state(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments)
 {
-    return on_handle_state_activity("collect-garbage", statemgmt_collect_garbage, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
+    return on_handle_state_activity("collect-garbage", start_delete_state, object, invocation, arg_pid, arg_derivation, arg_container, arg_type, arg_arguments);
 }
 
 /* Get logdir operation */
@@ -481,6 +692,32 @@ gboolean on_handle_get_logdir(OrgNixosDisnixDisnix *object, GDBusMethodInvocatio
     return TRUE;
 }
 
+/* Open log operation */
+
+gboolean on_handle_open_log(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid)
+{
+    gchar pidStr[15];
+    gchar *log_path;
+    int log_fd;
+
+    sprintf(pidStr, "%d", arg_pid);
+    log_path = g_strconcat(logdir, "/", pidStr, NULL);
+    log_fd = open(log_path, O_RDONLY);
+
+    if(log_fd == -1)
+        g_dbus_method_invocation_return_error(invocation, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "Cannot open logfile for job id: %d", arg_pid);
+    else
+    {
+        /* Pass a read-only descriptor of the logfile, so that the client can follow it while the job is in progress */
+        GUnixFDList *out_fd_list = g_unix_fd_list_new_from_array(&log_fd, 1); /* Takes ownership of the descriptor */
+        org_nixos_disnix_disnix_complete_open_log(object, invocation, out_fd_list, 0);
+        g_object_unref(out_fd_list);
+    }
+
+    g_free(log_path);
+    return TRUE;
+}
+
 /* Capture config operation */
 
 gboolean on_handle_capture_config(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid)
@@ -27,6 +27,10 @@ gboolean on_handle_import(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *i
 
 gboolean on_handle_export(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation);
 
+gboolean on_handle_import_fd(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid, gint arg_closure);
+
+gboolean on_handle_export_fd(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid, const gchar *const *arg_derivation, gint arg_closure);
+
 gboolean on_handle_print_invalid(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation);
 
 gboolean on_handle_realise(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *const *arg_derivation);
@@ -43,6 +47,8 @@ gboolean on_handle_activate(OrgNixosDisnixDisnix *object, GDBusMethodInvocation
 
 gboolean on_handle_deactivate(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_derivation, const gchar *arg_container, const gchar *arg_type, const gchar *const *arg_arguments);
 
+gboolean on_handle_run_activities(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, GVariant *arg_activities);
+
 gboolean on_handle_lock(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_profile);
 
 gboolean on_handle_unlock(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid, const gchar *arg_profile);
@@ -67,6 +73,8 @@ gboolean on_handle_delete_state(OrgNixosDisnixDisnix *object, GDBusMethodInvocat
 
 gboolean on_handle_get_logdir(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation);
 
+gboolean on_handle_open_log(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, GUnixFDList *fd_list, gint arg_pid);
+
 gboolean on_handle_capture_config(OrgNixosDisnixDisnix *object, GDBusMethodInvocation *invocation, gint arg_pid);
 
 #endif
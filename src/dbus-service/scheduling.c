@@ -0,0 +1,140 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "scheduling.h"
+#include <stdio.h>
+
+typedef struct
+{
+    JobClass job_class;
+    start_job_function start_job;
+    OrgNixosDisnixDisnix *object;
+    gint jid;
+    int log_fd;
+    GVariant *parameters;
+}
+ScheduledJob;
+
+typedef struct
+{
+    unsigned int max_concurrent_jobs;
+    unsigned int running_jobs;
+    GQueue *queue;
+}
+JobClassState;
+
+static JobClassState job_classes[JOB_CLASS_COUNT];
+
+/* Maps the job IDs of running scheduled jobs to their classes */
+static GHashTable *running_jobs_table = NULL;
+
+void set_max_concurrent_jobs(JobClass job_class, unsigned int max_concurrent_jobs)
+{
+    job_classes[job_class].max_concurrent_jobs = max_concurrent_jobs;
+}
+
+static void start_scheduled_job(ScheduledJob *job)
+{
+    if(running_jobs_table == NULL)
+        running_jobs_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    /* Register the job first, because a job that fails to start completes right away */
+    g_hash_table_insert(running_jobs_table, GINT_TO_POINTER(job->jid), GINT_TO_POINTER(job->job_class + 1));
+    job_classes[job->job_class].running_jobs++;
+
+    job->start_job(job->object, job->jid, job->log_fd, job->parameters);
+
+    /* Cleanup */
+    g_variant_unref(job->parameters);
+    g_free(job);
+}
+
+void schedule_job(JobClass job_class, start_job_function start_job, OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters)
+{
+    JobClassState *state = &job_classes[job_class];
+    ScheduledJob *job = (ScheduledJob*)g_malloc(sizeof(ScheduledJob));
+
+    job->job_class = job_class;
+    job->start_job = start_job;
+    job->object = object;
+    job->jid = jid;
+    job->log_fd = log_fd;
+    job->parameters = g_variant_ref_sink(parameters); /* The parameters must outlive the method call if the job gets queued */
+
+    if(state->max_concurrent_jobs == 0 || state->running_jobs < state->max_concurrent_jobs)
+        start_scheduled_job(job);
+    else
+    {
+        if(state->queue == NULL)
+            state->queue = g_queue_new();
+
+        dprintf(log_fd, "Waiting for other jobs to complete...\n");
+        g_queue_push_tail(state->queue, job);
+    }
+}
+
+void complete_job(gint jid)
+{
+    gpointer value;
+
+    if(running_jobs_table != NULL && (value = g_hash_table_lookup(running_jobs_table, GINT_TO_POINTER(jid))) != NULL)
+    {
+        JobClassState *state = &job_classes[GPOINTER_TO_INT(value) - 1];
+        ScheduledJob *job;
+
+        g_hash_table_remove(running_jobs_table, GINT_TO_POINTER(jid));
+        state->running_jobs--;
+
+        /* Admit the job that has been waiting the longest */
+        if(state->queue != NULL && (job = g_queue_pop_head(state->queue)) != NULL)
+            start_scheduled_job(job);
+    }
+}
+
+static void add_queued_job_id(gpointer data, gpointer user_data)
+{
+    ScheduledJob *job = (ScheduledJob*)data;
+    GHashTable *jobs_table = (GHashTable*)user_data;
+    g_hash_table_add(jobs_table, GINT_TO_POINTER(job->jid));
+}
+
+GHashTable *query_jobs_in_progress(void)
+{
+    GHashTable *jobs_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    unsigned int i;
+
+    if(running_jobs_table != NULL)
+    {
+        GHashTableIter iter;
+        gpointer key;
+
+        g_hash_table_iter_init(&iter, running_jobs_table);
+
+        while(g_hash_table_iter_next(&iter, &key, NULL))
+            g_hash_table_add(jobs_table, key);
+    }
+
+    for(i = 0; i < JOB_CLASS_COUNT; i++)
+    {
+        if(job_classes[i].queue != NULL)
+            g_queue_foreach(job_classes[i].queue, add_queued_job_id, jobs_table);
+    }
+
+    return jobs_table;
+}
@@ -0,0 +1,91 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_SCHEDULING_H
+#define __DISNIX_SCHEDULING_H
+
+#include <glib.h>
+#include "disnix-dbus.h"
+
+/**
+ * @brief Enumerates the classes of jobs that compete for the same resources
+ */
+typedef enum
+{
+    /** Jobs that import or export closures or snapshots */
+    JOB_CLASS_TRANSFER,
+    /** Jobs that realise store derivations or collect garbage */
+    JOB_CLASS_BUILD,
+    /** Jobs that execute Dysnomia activities */
+    JOB_CLASS_ACTIVITY,
+    /** The amount of job classes */
+    JOB_CLASS_COUNT
+}
+JobClass;
+
+/**
+ * Function that starts a job and propagates its result with one of the signal
+ * functions.
+ *
+ * @param object A Disnix DBus interface object
+ * @param jid Job ID of the job
+ * @param log_fd File descriptor of the job's logfile
+ * @param parameters Parameters of the method call that requested the job
+ */
+typedef void (*start_job_function) (OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters);
+
+/**
+ * Configures the maximum amount of jobs of a class that may run concurrently.
+ *
+ * @param job_class Class of jobs
+ * @param max_concurrent_jobs Maximum amount of concurrent jobs or 0 for no limit
+ */
+void set_max_concurrent_jobs(JobClass job_class, unsigned int max_concurrent_jobs);
+
+/**
+ * Starts a job right away if the limit of its class permits it, or otherwise
+ * appends it to the queue of its class. Queued jobs are started in FIFO order
+ * as soon as running jobs of the same class complete.
+ *
+ * @param job_class Class of the job
+ * @param start_job Function that starts the job
+ * @param object A Disnix DBus interface object
+ * @param jid Job ID of the job
+ * @param log_fd File descriptor of the job's logfile
+ * @param parameters Parameters of the method call that requested the job
+ */
+void schedule_job(JobClass job_class, start_job_function start_job, OrgNixosDisnixDisnix *object, gint jid, int log_fd, GVariant *parameters);
+
+/**
+ * Notifies the scheduler that a job has completed, so that a queued job of the
+ * same class can take its place. Job IDs that were not scheduled are ignored.
+ *
+ * @param jid Job ID of the completed job
+ */
+void complete_job(gint jid);
+
+/**
+ * Collects the job IDs of all scheduled jobs that are running or waiting in a
+ * queue.
+ *
+ * @return A hash table set of job IDs (converted with GINT_TO_POINTER()). It should be destroyed with g_hash_table_destroy()
+ */
+GHashTable *query_jobs_in_progress(void);
+
+#endif
@@ -19,8 +19,59 @@
 
 #include "signaling.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <glib-unix.h>
 #include <procreact_pid.h>
+#include "scheduling.h"
+#include "logging.h"
+#include "activity-batch.h"
+
+/*
+ * All results are propagated from the main loop: processes are observed with
+ * child watches and the output of futures is read as soon as it becomes
+ * available. As a result, the amount of threads stays constant regardless of
+ * the amount of jobs that run concurrently.
+ */
+
+/* Failure signaling infrastructure */
+
+typedef struct
+{
+    OrgNixosDisnixDisnix *object;
+    gint jid;
+    int log_fd;
+}
+SignalFailureData;
+
+static gboolean emit_failure(gpointer data)
+{
+    SignalFailureData *failure_data = (SignalFailureData*)data;
+
+    org_nixos_disnix_disnix_emit_failure(failure_data->object, failure_data->jid);
+
+    /* Cleanup */
+    close(failure_data->log_fd);
+    complete_job(failure_data->jid);
+    g_free(failure_data);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Jobs that cannot be started fail right away. The signal is propagated from
+ * the main loop so that it is emitted after the method call has completed.
+ */
+static void signal_failure_later(OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+{
+    SignalFailureData *data = (SignalFailureData*)g_malloc(sizeof(SignalFailureData));
+
+    data->object = object;
+    data->jid = jid;
+    data->log_fd = log_fd;
+
+    g_idle_add(emit_failure, data);
+}
 
 /* Boolean signaling infrastructure */
 
@@ -29,15 +80,14 @@ typedef struct
     OrgNixosDisnixDisnix *object;
     gint jid;
     int log_fd;
-    pid_t pid;
 }
-SignalBooleanResultThreadData;
+SignalBooleanResultData;
 
-static gpointer signal_boolean_result_thread_func(gpointer data)
+static void complete_boolean_process(GPid pid, gint wait_status, gpointer data)
 {
     ProcReact_Status status;
-    SignalBooleanResultThreadData *boolean_data = (SignalBooleanResultThreadData*)data;
-    int result = procreact_wait_for_boolean(boolean_data->pid, &status);
+    SignalBooleanResultData *boolean_data = (SignalBooleanResultData*)data;
+    int result = procreact_retrieve_boolean(pid, wait_status, &status);
 
     if(status == PROCREACT_STATUS_OK && result)
         org_nixos_disnix_disnix_emit_finish(boolean_data->object, boolean_data->jid);
@@ -45,27 +95,31 @@ static gpointer signal_boolean_result_thread_func(gpointer data)
         org_nixos_disnix_disnix_emit_failure(boolean_data->object, boolean_data->jid);
 
     /* Cleanup */
-    g_free(boolean_data);
     close(boolean_data->log_fd);
-
-    return NULL;
+    complete_job(boolean_data->jid);
+    g_free(boolean_data);
+    g_spawn_close_pid(pid);
 }
 
 void signal_boolean_result(pid_t pid, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
 {
-    GThread *thread;
-    SignalBooleanResultThreadData *data = (SignalBooleanResultThreadData*)g_malloc(sizeof(SignalBooleanResultThreadData));
+    if(pid == -1)
+        signal_failure_later(object, jid, log_fd);
+    else
+    {
+        SignalBooleanResultData *data = (SignalBooleanResultData*)g_malloc(sizeof(SignalBooleanResultData));
 
-    data->object = object;
-    data->jid = jid;
-    data->log_fd = log_fd;
-    data->pid = pid;
+        data->object = object;
+        data->jid = jid;
+        data->log_fd = log_fd;
 
-    thread = g_thread_new("evaluate-boolean", signal_boolean_result_thread_func, data);
-    g_thread_unref(thread);
+        g_child_watch_add(pid, complete_boolean_process, data);
+    }
 }
 
-/* String vector signaling infrastructure */
+/* Future signaling infrastructure */
+
+typedef void (*emit_future_result_function) (OrgNixosDisnixDisnix *object, gint jid, void *result);
 
 typedef struct
 {
@@ -73,42 +127,70 @@ typedef struct
     gint jid;
     int log_fd;
     ProcReact_Future future;
+    emit_future_result_function emit_future_result;
 }
-SignalStrvResultThreadData;
+SignalFutureResultData;
 
-static gpointer signal_strv_result_thread_func(gpointer data)
+static gboolean read_future_output(gint fd, GIOCondition condition, gpointer data)
 {
-    SignalStrvResultThreadData *strv_data = (SignalStrvResultThreadData*)data;
-    ProcReact_Status status;
-    char **result = procreact_future_get(&strv_data->future, &status);
+    SignalFutureResultData *future_data = (SignalFutureResultData*)data;
+    ProcReact_Future *future = &future_data->future;
 
-    if(status != PROCREACT_STATUS_OK || result == NULL)
-        org_nixos_disnix_disnix_emit_failure(strv_data->object, strv_data->jid);
+    if(future->type.append(&future->type, future->state, future->fd) > 0)
+        return G_SOURCE_CONTINUE;
     else
     {
-        org_nixos_disnix_disnix_emit_success(strv_data->object, strv_data->jid, (const gchar**)result);
-        procreact_free_string_array(result);
-    }
+        ProcReact_Status status;
 
-    /* Cleanup */
-    g_free(strv_data);
-    close(strv_data->log_fd);
+        /* The process has closed its end of the pipe, which means that it has finished */
+        future->result = future->type.finalize(future->state, future->pid, &status);
+        procreact_destroy_future(future);
+
+        if(status != PROCREACT_STATUS_OK || future->result == NULL)
+            org_nixos_disnix_disnix_emit_failure(future_data->object, future_data->jid);
+        else
+            future_data->emit_future_result(future_data->object, future_data->jid, future->result);
+
+        /* Cleanup */
+        close(future_data->log_fd);
+        complete_job(future_data->jid);
+        g_free(future_data);
 
-    return NULL;
+        return G_SOURCE_REMOVE;
+    }
 }
 
-void signal_strv_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+static void signal_future_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd, emit_future_result_function emit_future_result)
 {
-    GThread *thread;
-    SignalStrvResultThreadData *data = (SignalStrvResultThreadData*)g_malloc(sizeof(SignalStrvResultThreadData));
+    if(future.fd == -1)
+        signal_failure_later(object, jid, log_fd);
+    else
+    {
+        SignalFutureResultData *data = (SignalFutureResultData*)g_malloc(sizeof(SignalFutureResultData));
 
-    data->object = object;
-    data->jid = jid;
-    data->log_fd = log_fd;
-    data->future = future;
+        data->object = object;
+        data->jid = jid;
+        data->log_fd = log_fd;
+        data->future = future;
+        data->future.state = future.type.initialize();
+        data->emit_future_result = emit_future_result;
+
+        g_unix_fd_add(future.fd, G_IO_IN | G_IO_HUP | G_IO_ERR, read_future_output, data);
+    }
+}
+
+/* String vector signaling infrastructure */
 
-    thread = g_thread_new("evaluate-strv", signal_strv_result_thread_func, data);
-    g_thread_unref(thread);
+static void emit_strv_result(OrgNixosDisnixDisnix *object, gint jid, void *result)
+{
+    char **strv_result = (char**)result;
+    org_nixos_disnix_disnix_emit_success(object, jid, (const gchar**)strv_result);
+    procreact_free_string_array(strv_result);
+}
+
+void signal_strv_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+{
+    signal_future_result(future, object, jid, log_fd, emit_strv_result);
 }
 
 /* Temp file signaling infrastructure */
@@ -118,23 +200,22 @@ typedef struct
     OrgNixosDisnixDisnix *object;
     gint jid;
     int log_fd;
-    pid_t pid;
     gchar *tempfilename;
     int temp_fd;
 }
-SignalTempFileResultThreadData;
+SignalTempFileResultData;
 
-static gpointer evaluate_tempfile_process_thread_func(gpointer data)
+static void complete_tempfile_process(GPid pid, gint wait_status, gpointer data)
 {
-    SignalTempFileResultThreadData *tempfile_data = (SignalTempFileResultThreadData*)data;
+    SignalTempFileResultData *tempfile_data = (SignalTempFileResultData*)data;
     ProcReact_Status status;
-    int result = procreact_wait_for_boolean(tempfile_data->pid, &status);
+    int result = procreact_retrieve_boolean(pid, wait_status, &status);
 
     if(status == PROCREACT_STATUS_OK && result)
     {
         const gchar *tempfilepaths[] = { tempfile_data->tempfilename, NULL };
 
-        if(fchmod(tempfile_data->temp_fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 1)
+        if(fchmod(tempfile_data->temp_fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == -1)
         {
             dprintf(tempfile_data->log_fd, "Cannot change permissions of tempfile: %s\n", tempfile_data->tempfilename);
             org_nixos_disnix_disnix_emit_failure(tempfile_data->object, tempfile_data->jid);
@@ -142,75 +223,204 @@ static gpointer evaluate_tempfile_process_thread_func(gpointer data)
         else
             org_nixos_disnix_disnix_emit_success(tempfile_data->object, tempfile_data->jid, tempfilepaths);
     }
-
-    g_free(tempfile_data->tempfilename);
+    else
+        org_nixos_disnix_disnix_emit_failure(tempfile_data->object, tempfile_data->jid);
 
     /* Cleanup */
     close(tempfile_data->log_fd);
     close(tempfile_data->temp_fd);
-
-    return NULL;
+    g_free(tempfile_data->tempfilename);
+    complete_job(tempfile_data->jid);
+    g_free(tempfile_data);
+    g_spawn_close_pid(pid);
 }
 
 void signal_tempfile_result(pid_t pid, gchar *tempfilename, int temp_fd, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
 {
-    GThread *thread;
-    SignalTempFileResultThreadData *data = (SignalTempFileResultThreadData*)g_malloc(sizeof(SignalTempFileResultThreadData));
+    if(tempfilename == NULL || pid == -1)
+    {
+        if(temp_fd != -1)
+            close(temp_fd);
 
-    data->object = object;
-    data->jid = jid;
-    data->log_fd = log_fd;
-    data->pid = pid;
-    data->tempfilename = tempfilename;
-    data->temp_fd = temp_fd;
+        g_free(tempfilename);
+        signal_failure_later(object, jid, log_fd);
+    }
+    else
+    {
+        SignalTempFileResultData *data = (SignalTempFileResultData*)g_malloc(sizeof(SignalTempFileResultData));
+
+        data->object = object;
+        data->jid = jid;
+        data->log_fd = log_fd;
+        data->tempfilename = tempfilename;
+        data->temp_fd = temp_fd;
 
-    thread = g_thread_new("evaluate-tempfile", evaluate_tempfile_process_thread_func, data);
-    g_thread_unref(thread);
+        g_child_watch_add(pid, complete_tempfile_process, data);
+    }
 }
 
 /* String signaling infrastructure */
 
+static void emit_string_result(OrgNixosDisnixDisnix *object, gint jid, void *result)
+{
+    char *result_array[] = { (char*)result, NULL };
+    org_nixos_disnix_disnix_emit_success(object, jid, (const gchar**)result_array);
+    free(result);
+}
+
+void signal_string_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+{
+    signal_future_result(future, object, jid, log_fd, emit_string_result);
+}
+
+/* Activity batch signaling infrastructure */
+
 typedef struct
 {
     OrgNixosDisnixDisnix *object;
     gint jid;
     int log_fd;
-    ProcReact_Future future;
+    GPtrArray *batch;
+    guint stage;
+    unsigned int num_of_running_items;
+    gboolean success;
 }
-SignalStringResultThreadData;
+ActivityBatchData;
 
-static gpointer signal_string_result_thread_func(gpointer data)
+typedef struct
 {
-    SignalStringResultThreadData *string_data = (SignalStringResultThreadData*)data;
-    ProcReact_Status status;
-    char *result = procreact_future_get(&string_data->future, &status);
+    ActivityBatchData *batch_data;
+    guint index;
+}
+ActivityBatchItemData;
+
+static void complete_activity_batch_item(GPid pid, gint wait_status, gpointer data);
 
-    if(status != PROCREACT_STATUS_OK || result == NULL)
-        org_nixos_disnix_disnix_emit_failure(string_data->object, string_data->jid);
+static void emit_item_result(ActivityBatchData *batch_data, guint index, gboolean result)
+{
+    if(result)
+        org_nixos_disnix_disnix_emit_item_finish(batch_data->object, batch_data->jid, index);
     else
     {
-        char *result_array[] = { result, NULL };
-        org_nixos_disnix_disnix_emit_success(string_data->object, string_data->jid, (const gchar**)result_array);
-        free(result);
+        org_nixos_disnix_disnix_emit_item_failure(batch_data->object, batch_data->jid, index);
+        batch_data->success = FALSE;
+    }
+}
+
+static void start_activity_batch_stage(ActivityBatchData *batch_data)
+{
+    unsigned int i;
+
+    for(i = 0; i < batch_data->batch->len; i++)
+    {
+        ActivityBatchItem *item = g_ptr_array_index(batch_data->batch, i);
+
+        if(item->stage == batch_data->stage)
+        {
+            if(batch_data->success)
+            {
+                pid_t pid;
+
+                /* Print log entry */
+                dprintf(batch_data->log_fd, "%s: %s of type: %s in container: %s with arguments: ", item->activity, item->component, item->type, item->container);
+                print_paths(batch_data->log_fd, item->arguments);
+                dprintf(batch_data->log_fd, "\n");
+
+                pid = statemgmt_lookup_activity(item->activity)(item->type, item->component, item->container, item->arguments, batch_data->log_fd, batch_data->log_fd);
+
+                if(pid == -1)
+                    emit_item_result(batch_data, i, FALSE);
+                else
+                {
+                    ActivityBatchItemData *item_data = (ActivityBatchItemData*)g_malloc(sizeof(ActivityBatchItemData));
+                    item_data->batch_data = batch_data;
+                    item_data->index = i;
+
+                    g_child_watch_add(pid, complete_activity_batch_item, item_data);
+                    batch_data->num_of_running_items++;
+                }
+            }
+            else
+                emit_item_result(batch_data, i, FALSE); /* Skip the activities that follow a failed stage */
+        }
     }
+}
+
+static void complete_activity_batch(ActivityBatchData *batch_data)
+{
+    if(batch_data->success)
+        org_nixos_disnix_disnix_emit_finish(batch_data->object, batch_data->jid);
+    else
+        org_nixos_disnix_disnix_emit_failure(batch_data->object, batch_data->jid);
 
     /* Cleanup */
-    g_free(string_data);
-    close(string_data->log_fd);
+    close(batch_data->log_fd);
+    complete_job(batch_data->jid);
+    delete_activity_batch(batch_data->batch);
+    g_free(batch_data);
+}
+
+static void proceed_activity_batch(ActivityBatchData *batch_data, gboolean first)
+{
+    /* Start the next stage that has activities to wait for, or complete the batch if there are no stages left */
+    while(batch_data->num_of_running_items == 0)
+    {
+        if(statemgmt_next_activity_batch_stage(batch_data->batch, batch_data->stage, first, &batch_data->stage))
+            start_activity_batch_stage(batch_data);
+        else
+        {
+            complete_activity_batch(batch_data);
+            break;
+        }
 
-    return NULL;
+        first = FALSE;
+    }
 }
 
-void signal_string_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+static void complete_activity_batch_item(GPid pid, gint wait_status, gpointer data)
 {
-    GThread *thread;
-    SignalStringResultThreadData *data = (SignalStringResultThreadData*)g_malloc(sizeof(SignalStringResultThreadData));
+    ActivityBatchItemData *item_data = (ActivityBatchItemData*)data;
+    ActivityBatchData *batch_data = item_data->batch_data;
+    ProcReact_Status status;
+    int result = procreact_retrieve_boolean(pid, wait_status, &status);
 
-    data->object = object;
-    data->jid = jid;
-    data->log_fd = log_fd;
-    data->future = future;
+    emit_item_result(batch_data, item_data->index, status == PROCREACT_STATUS_OK && result);
+    batch_data->num_of_running_items--;
+
+    /* Cleanup */
+    g_free(item_data);
+    g_spawn_close_pid(pid);
+
+    proceed_activity_batch(batch_data, FALSE);
+}
+
+static gboolean start_activity_batch(gpointer data)
+{
+    proceed_activity_batch((ActivityBatchData*)data, TRUE);
+    return G_SOURCE_REMOVE;
+}
 
-    thread = g_thread_new("evaluate-string", signal_string_result_thread_func, data);
-    g_thread_unref(thread);
+void signal_activity_batch_results(GPtrArray *batch, OrgNixosDisnixDisnix *object, gint jid, int log_fd)
+{
+    if(batch == NULL || !statemgmt_check_activity_batch(batch))
+    {
+        dprintf(log_fd, "Invalid batch of activities!\n");
+        delete_activity_batch(batch);
+        signal_failure_later(object, jid, log_fd);
+    }
+    else
+    {
+        ActivityBatchData *data = (ActivityBatchData*)g_malloc(sizeof(ActivityBatchData));
+
+        data->object = object;
+        data->jid = jid;
+        data->log_fd = log_fd;
+        data->batch = batch;
+        data->stage = 0;
+        data->num_of_running_items = 0;
+        data->success = TRUE;
+
+        /* Start from the main loop so that all signals are emitted after the method call has completed */
+        g_idle_add(start_activity_batch, data);
+    }
 }
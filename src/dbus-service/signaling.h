@@ -26,8 +26,8 @@
 #include "disnix-dbus.h"
 
 /**
- * Spawns a thread that waits for process to complete and propagates a finish
- * signal when it yields TRUE or a failure signal when it yiels FALSE.
+ * Watches a process from the main loop and propagates a finish signal when it
+ * yields TRUE or a failure signal when it yiels FALSE.
  *
  * @param pid PID of the running process
  * @param object A Disnix DBus interface object
@@ -37,7 +37,7 @@
 void signal_boolean_result(pid_t pid, OrgNixosDisnixDisnix *object, gint jid, int log_fd);
 
 /**
- * Spawns a thread that waits for future to complete and propagates a success
+ * Reads the output of a future from the main loop and propagates a success
  * signal with the result if it succeeds or a failure signal when it fails.
  *
  * @param future Future delivering a string vector
@@ -48,9 +48,9 @@ void signal_boolean_result(pid_t pid, OrgNixosDisnixDisnix *object, gint jid, in
 void signal_strv_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd);
 
 /**
- * Spawns a thread that waits for process that writes to a tempfile to complete
- * and propagates a success signal with the correspondng path if it succeeds or
- * a failure signal when it fails.
+ * Watches a process that writes to a tempfile from the main loop and
+ * propagates a success signal with the correspondng path if it succeeds or a
+ * failure signal when it fails.
  *
  * @param pid PID of the running process
  * @param tempfilename String containing the path to the tempfile
@@ -63,4 +63,19 @@ void signal_tempfile_result(pid_t pid, gchar *tempfilename, int temp_fd, OrgNixo
 
 void signal_string_result(ProcReact_Future future, OrgNixosDisnixDisnix *object, gint jid, int log_fd);
 
+/**
+ * Executes a batch of activities from the main loop. Activities in the same
+ * stage run in parallel and stages run in ascending order. For each activity,
+ * an item finish or item failure signal is propagated. When an activity fails,
+ * the activities of the subsequent stages are not executed and reported as
+ * failed. When all activities have been processed, a finish signal is
+ * propagated if all of them succeeded, or a failure signal otherwise.
+ *
+ * @param batch An array of activity batch items. The batch is owned by this function.
+ * @param object A Disnix DBus interface object
+ * @param jid Job ID of the batch
+ * @param log_fd File descriptor of the job's logfile
+ */
+void signal_activity_batch_results(GPtrArray *batch, OrgNixosDisnixDisnix *object, gint jid, int log_fd);
+
 #endif
@@ -49,6 +49,13 @@ static void print_usage(const char *command)
     "                                       they have been annotated as such\n"
     "      --no-lock                        Do not attempt to acquire and release\n"
     "                                       any locks\n"
+    "      --pipeline                       Activates the services of a machine as\n"
+    "                                       soon as it has received its closure,\n"
+    "                                       instead of waiting for all transfers to\n"
+    "                                       complete\n"
+    "      --batch-activities               Submits the activation and deactivation\n"
+    "                                       steps that can be executed on a machine\n"
+    "                                       at the same time with a single request\n"
     "      --delete-state                   Remove the obsolete state of deactivated\n"
     "                                       services\n"
     "      --transfer-only                  Transfers the snapshot from the target\n"
@@ -71,6 +78,10 @@ static void print_usage(const char *command)
     "                                       in most cases.\n"
     "  -m, --max-concurrent-transfers=NUM   Maximum amount of concurrent closure\n"
     "                                       transfers. Defauls to: 2\n"
+    "      --max-concurrent-snapshot-transfers=NUM\n"
+    "                                       Maximum amount of concurrent snapshot\n"
+    "                                       transfers per target machine. Defaults\n"
+    "                                       to: 1\n"
     "  -h, --help                           Shows the usage of this command to the\n"
     "                                       user\n"
 
@@ -82,6 +93,11 @@ static void print_usage(const char *command)
     "                       state after upgrading. (defaults to: 0)\n"
     "  DYSNOMIA_STATEDIR    Specifies where the snapshots must be stored on the\n"
     "                       coordinator machine (defaults to: /var/state/dysnomia)\n"
+    "  DISNIX_SSH_SESSION_DIR\n"
+    "                       Directory containing the shared SSH connections of\n"
+    "                       disnix-ssh-client. Only disnix-env sets it up. When it is\n"
+    "                       not set, every remote operation opens a connection of its\n"
+    "                       own\n"
     );
 }
 
@@ -97,18 +113,22 @@ int main(int argc, char *argv[])
         {"no-upgrade", no_argument, 0, DISNIX_OPTION_NO_UPGRADE},
         {"no-migration", no_argument, 0, DISNIX_OPTION_NO_MIGRATION},
         {"no-lock", no_argument, 0, DISNIX_OPTION_NO_LOCK},
+        {"pipeline", no_argument, 0, DISNIX_OPTION_PIPELINE},
+        {"batch-activities", no_argument, 0, DISNIX_OPTION_BATCH_ACTIVITIES},
         {"delete-state", no_argument, 0, DISNIX_OPTION_DELETE_STATE},
         {"transfer-only", no_argument, 0, DISNIX_OPTION_TRANSFER_ONLY},
         {"depth-first", no_argument, 0, DISNIX_OPTION_DEPTH_FIRST},
         {"all", no_argument, 0, DISNIX_OPTION_ALL},
         {"keep", required_argument, 0, DISNIX_OPTION_KEEP},
         {"max-concurrent-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS},
+        {"max-concurrent-snapshot-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS},
         {"help", no_argument, 0, DISNIX_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_OPTION_VERSION},
         {0, 0, 0, 0}
     };
 
     unsigned int max_concurrent_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_TRANSFERS;
+    unsigned int max_concurrent_snapshot_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_SNAPSHOT_TRANSFERS;
     unsigned int flags = 0;
     int keep = DISNIX_DEFAULT_KEEP;
     char *manifest_file;
@@ -143,6 +163,12 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_NO_LOCK:
                 flags |= FLAG_NO_LOCK;
                 break;
+            case DISNIX_OPTION_PIPELINE:
+                flags |= FLAG_PIPELINE;
+                break;
+            case DISNIX_OPTION_BATCH_ACTIVITIES:
+                flags |= FLAG_BATCH_ACTIVITIES;
+                break;
             case DISNIX_OPTION_ALL:
                 flags |= FLAG_ALL;
                 break;
@@ -158,6 +184,9 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS:
                 max_concurrent_transfers = atoi(optarg);
                 break;
+            case DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS:
+                max_concurrent_snapshot_transfers = atoi(optarg);
+                break;
             case DISNIX_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
@@ -183,5 +212,5 @@ int main(int argc, char *argv[])
     if(check_global_delete_state())
         flags |= FLAG_DELETE_STATE;
 
-    return run_deploy(manifest_file, old_manifest, coordinator_profile_path, profile, max_concurrent_transfers, keep, flags, tmpdir); /* Execute deploy operation */
+    return run_deploy(manifest_file, old_manifest, coordinator_profile_path, profile, max_concurrent_transfers, max_concurrent_snapshot_transfers, keep, flags, tmpdir); /* Execute deploy operation */
 }
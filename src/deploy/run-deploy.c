@@ -109,7 +109,7 @@ static void print_unsafe_migration_message(void)
     );
 }
 
-int run_deploy(const gchar *new_manifest, gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const unsigned int max_concurrent_transfers, const int keep, const unsigned int flags, char *tmpdir)
+int run_deploy(const gchar *new_manifest, gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const int keep, const unsigned int flags, char *tmpdir)
 {
     Manifest *manifest = create_manifest(new_manifest, MANIFEST_ALL_FLAGS, NULL, NULL);
 
@@ -138,7 +138,7 @@ int run_deploy(const gchar *new_manifest, gchar *old_manifest, const gchar *coor
                 else
                 {
                     /* Execute the deployment process */
-                    status = deploy(old_manifest_file, new_manifest, manifest, previous_manifest, profile, coordinator_profile_path, max_concurrent_transfers, tmpdir, keep, flags, set_flag_on_interrupt, restore_default_behaviour_on_interrupt);
+                    status = deploy(old_manifest_file, new_manifest, manifest, previous_manifest, profile, coordinator_profile_path, max_concurrent_transfers, max_concurrent_snapshot_transfers, tmpdir, keep, flags, set_flag_on_interrupt, restore_default_behaviour_on_interrupt);
 
                     switch(status)
                     {
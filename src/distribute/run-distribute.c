@@ -36,7 +36,7 @@ int run_distribute(const gchar *manifest_file, const unsigned int max_concurrent
         int exit_status;
 
         if(check_manifest(manifest))
-            exit_status = !distribute(manifest, max_concurrent_transfers, tmpdir); /* Iterate over the distribution mappings, limiting concurrency to the desired concurrent transfers and distribute them */
+            exit_status = !distribute(manifest, NULL, max_concurrent_transfers, tmpdir); /* Iterate over the distribution mappings, limiting concurrency to the desired concurrent transfers and distribute them */
         else
             exit_status = 1;
 
@@ -19,75 +19,253 @@
 
 #include "build.h"
 #include <distributedderivation.h>
-#include <derivationmapping-iterator.h>
+#include <derivationmapping.h>
 #include <interfacestable.h>
 #include <copy-closure.h>
+#include <export-cache.h>
 #include <remote-package-management.h>
+#include <procreact_future_iterator.h>
+#include <unistd.h>
+#include <fcntl.h>
 
-/* Distribute store derivations infrastructure */
-
-static pid_t copy_derivation_mapping_to(void *data, DerivationMapping *mapping, Interface *interface)
+/**
+ * @brief Enumerates the stages that each derivation mapping goes through
+ */
+typedef enum
 {
-    char *tmpdir = (char*)data;
-    char *paths[] = { (char*)mapping->derivation, NULL };
-    g_print("[target: %s]: Receiving intra-dependency closure of store derivation: %s\n", mapping->interface, mapping->derivation);
-    return copy_closure_to((char*)interface->client_interface, (char*)interface->target_address, tmpdir, paths, STDERR_FILENO);
+    BUILD_JOB_DISTRIBUTE,
+    BUILD_JOB_REALISE,
+    BUILD_JOB_RETRIEVE
 }
+BuildJobType;
 
-static void complete_copy_derivation_mapping_to(void *data, DerivationMapping *mapping, ProcReact_Status status, int result)
+/**
+ * @brief A unit of work in the build pipeline
+ */
+typedef struct
 {
-    if(status != PROCREACT_STATUS_OK || !result)
-        g_printerr("[target: %s]: Cannot receive intra-dependency closure of store derivation: %s\n", mapping->interface, mapping->derivation);
+    /** Stage of the pipeline that this job executes */
+    BuildJobType type;
+    /** Name of the interface of the target machine */
+    gchar *interface_name;
+    /** Derivation mapping to realise or retrieve, or NULL if the job distributes all store derivations of a target */
+    DerivationMapping *mapping;
 }
+BuildJob;
 
-static ProcReact_bool distribute_derivation_mappings(const GPtrArray *derivation_mapping_array, GHashTable *interfaces_table, const unsigned int max_concurrent_transfers, char *tmpdir)
+/**
+ * @brief Schedules the jobs of the build pipeline
+ *
+ * The store derivations are transferred to each target in one batch. As soon
+ * as the derivations of a target have arrived, they are realised, but never
+ * more at the same time than the target has CPU cores. As soon as a
+ * derivation has been realised, its build result is retrieved.
+ */
+typedef struct
 {
+    /** Hash table mapping interface names to NULL-terminated arrays of store derivation paths */
+    GHashTable *derivations_table;
+    /** Hash table mapping interface names to arrays of derivation mappings */
+    GHashTable *mappings_table;
+    /** Hash table with interfaces */
+    GHashTable *interfaces_table;
+    /** Path to the export cache shared by all transfers or NULL if they do not share any store path */
+    gchar *export_cache_dir;
+    /** Queue of distribution jobs waiting for a transfer slot */
+    GQueue *distribute_queue;
+    /** Hash table mapping interface names to queues of realise jobs waiting for a CPU core of the target */
+    GHashTable *realise_queues_table;
+    /** Amount of realise jobs that are waiting in any of the realise queues */
+    unsigned int num_of_waiting_realisations;
+    /** Queue of retrieval jobs waiting for a transfer slot */
+    GQueue *retrieve_queue;
+    /** Hash table mapping PIDs to the jobs that are running */
+    GHashTable *running_jobs_table;
+    /** Job that has been spawned most recently */
+    BuildJob *last_job;
+    /** Maximum amount of concurrent transfers */
+    unsigned int max_concurrent_transfers;
+    /** Amount of transfers that are currently running */
+    unsigned int running_transfers;
+    /** Maximum amount of concurrent realisations across all targets, or 0 for no limit */
+    unsigned int max_concurrent_builds;
+    /** Amount of realisations that are currently running */
+    unsigned int running_builds;
+    /** Indicates whether all jobs have succeeded so far */
     ProcReact_bool success;
-    ProcReact_PidIterator iterator = create_derivation_mapping_pid_iterator(derivation_mapping_array, interfaces_table, copy_derivation_mapping_to, complete_copy_derivation_mapping_to, tmpdir);
+}
+BuildPipeline;
 
-    g_print("[coordinator]: Distributing store derivation files...\n");
+static BuildJob *create_build_job(BuildJobType type, gchar *interface_name, DerivationMapping *mapping)
+{
+    BuildJob *job = (BuildJob*)g_malloc(sizeof(BuildJob));
+    job->type = type;
+    job->interface_name = interface_name;
+    job->mapping = mapping;
+    return job;
+}
 
-    procreact_fork_and_wait_in_parallel_limit(&iterator, max_concurrent_transfers);
-    success = derivation_mapping_iterator_has_succeeded(iterator.data);
+static void delete_array(gpointer data)
+{
+    g_ptr_array_free((GPtrArray*)data, TRUE);
+}
 
-    destroy_derivation_mapping_pid_iterator(&iterator);
-    return success;
+static void delete_build_jobs(gpointer data)
+{
+    g_queue_free_full((GQueue*)data, g_free);
 }
 
-/* Realisation infrastructure */
+static void group_derivations_per_interface(BuildPipeline *pipeline, const GPtrArray *derivation_mapping_array)
+{
+    unsigned int i;
+
+    for(i = 0; i < derivation_mapping_array->len; i++)
+    {
+        DerivationMapping *mapping = g_ptr_array_index(derivation_mapping_array, i);
+        GPtrArray *derivation_paths = g_hash_table_lookup(pipeline->derivations_table, mapping->interface);
+
+        if(derivation_paths == NULL)
+        {
+            derivation_paths = g_ptr_array_new();
+            g_ptr_array_add(derivation_paths, NULL);
+            g_hash_table_insert(pipeline->derivations_table, mapping->interface, derivation_paths);
+            g_hash_table_insert(pipeline->mappings_table, mapping->interface, g_ptr_array_new());
+            g_hash_table_insert(pipeline->realise_queues_table, mapping->interface, g_queue_new());
+
+            /* Batch the store derivations per target, so that each target is only asked once which paths are missing */
+            g_queue_push_tail(pipeline->distribute_queue, create_build_job(BUILD_JOB_DISTRIBUTE, (gchar*)mapping->interface, NULL));
+        }
+
+        /* Keep the array NULL-terminated */
+        g_ptr_array_index(derivation_paths, derivation_paths->len - 1) = mapping->derivation;
+        g_ptr_array_add(derivation_paths, NULL);
+
+        g_ptr_array_add(g_hash_table_lookup(pipeline->mappings_table, mapping->interface), mapping);
+    }
+}
+
+static gchar *create_derivations_export_cache(GHashTable *derivations_table, char *tmpdir)
+{
+    /* Export store paths that multiple targets need only once */
+    GPtrArray *transfers = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer key, value;
+    gchar *export_cache_dir;
+
+    g_hash_table_iter_init(&iter, derivations_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+        g_ptr_array_add(transfers, ((GPtrArray*)value)->pdata);
+
+    export_cache_dir = pkgmgmt_create_export_cache(tmpdir, transfers, STDERR_FILENO);
+    g_ptr_array_free(transfers, TRUE);
+
+    return export_cache_dir;
+}
+
+static void delete_transfer_result(void *result)
+{
+    if(result != NULL)
+    {
+        ProcReact_BytesState *bytes_state = (ProcReact_BytesState*)result;
+        free(bytes_state->data);
+        free(bytes_state);
+    }
+}
 
-static ProcReact_Future realise_derivation_mapping(void *data, DerivationMapping *mapping, Interface *interface)
+static ProcReact_Future initialize_transfer_future(void)
 {
-    g_print("[target: %s]: Realising derivation: %s\n", mapping->interface, mapping->derivation);
-    return pkgmgmt_remote_realise((char*)interface->client_interface, (char*)interface->target_address, (char*)mapping->derivation);
+    ProcReact_Future future = procreact_initialize_future(procreact_create_bytes_type());
+
+    /*
+     * The pipe of the future reaches its end when the transfer process
+     * terminates. Processes that the transfer spawns must not keep it open.
+     */
+    if(future.pid == 0)
+        fcntl(future.fd, F_SETFD, FD_CLOEXEC);
+
+    return future;
 }
 
-static void complete_realise_derivation_mapping(void *data, DerivationMapping *mapping, ProcReact_Future *future, ProcReact_Status status)
+/* Distribute store derivations infrastructure */
+
+static ProcReact_Future distribute_derivations(BuildPipeline *pipeline, BuildJob *job)
+{
+    GPtrArray *derivation_paths = g_hash_table_lookup(pipeline->derivations_table, job->interface_name);
+    Interface *interface = g_hash_table_lookup(pipeline->interfaces_table, job->interface_name);
+    ProcReact_Future future;
+    unsigned int i;
+
+    g_print("[target: %s]: Receiving intra-dependency closure of store derivations:", job->interface_name);
+
+    for(i = 0; i < derivation_paths->len - 1; i++)
+        g_print(" %s", (gchar*)g_ptr_array_index(derivation_paths, i));
+
+    g_print("\n");
+
+    future = initialize_transfer_future();
+
+    /* Compute the union of the requisites, check their validity and transfer the missing paths in one go */
+    if(future.pid == 0)
+        _exit(!copy_closure_to_sync((char*)interface->client_interface, (char*)interface->target_address, pipeline->export_cache_dir, (gchar**)derivation_paths->pdata, NULL, STDERR_FILENO));
+
+    return future;
+}
+
+static void complete_distribute_derivations(BuildPipeline *pipeline, BuildJob *job, ProcReact_Future *future, ProcReact_Status status)
 {
     if(status == PROCREACT_STATUS_OK && future->result != NULL)
-        mapping->result = future->result;
+    {
+        GPtrArray *mappings = g_hash_table_lookup(pipeline->mappings_table, job->interface_name);
+        GQueue *realise_queue = g_hash_table_lookup(pipeline->realise_queues_table, job->interface_name);
+        unsigned int i;
+
+        /* All derivations of the target have arrived, so they can be realised */
+        for(i = 0; i < mappings->len; i++)
+            g_queue_push_tail(realise_queue, create_build_job(BUILD_JOB_REALISE, job->interface_name, g_ptr_array_index(mappings, i)));
+
+        pipeline->num_of_waiting_realisations += mappings->len;
+    }
     else
-        g_printerr("[target: %s]: Realising derivation: %s has failed!\n", mapping->interface, mapping->derivation);
+    {
+        g_printerr("[target: %s]: Cannot receive intra-dependency closure of store derivations\n", job->interface_name);
+        pipeline->success = FALSE;
+    }
+
+    delete_transfer_result(future->result);
 }
 
-static ProcReact_bool realise(const GPtrArray *derivation_mapping_array, GHashTable *interfaces_table)
-{
-    ProcReact_bool success;
-    ProcReact_FutureIterator iterator = create_derivation_mapping_future_iterator(derivation_mapping_array, interfaces_table, realise_derivation_mapping, complete_realise_derivation_mapping, NULL);
-    procreact_fork_in_parallel_buffer_and_wait(&iterator);
+/* Realisation infrastructure */
 
-    g_print("[coordinator]: Realising store derivation files...\n");
+static ProcReact_Future realise_derivation_mapping(BuildPipeline *pipeline, BuildJob *job)
+{
+    Interface *interface = g_hash_table_lookup(pipeline->interfaces_table, job->interface_name);
+    g_print("[target: %s]: Realising derivation: %s\n", job->mapping->interface, job->mapping->derivation);
+    return pkgmgmt_remote_realise((char*)interface->client_interface, (char*)interface->target_address, (char*)job->mapping->derivation);
+}
 
-    success = derivation_mapping_iterator_has_succeeded(iterator.data);
+static void complete_realise_derivation_mapping(BuildPipeline *pipeline, BuildJob *job, ProcReact_Future *future, ProcReact_Status status)
+{
+    if(status == PROCREACT_STATUS_OK && future->result != NULL)
+    {
+        job->mapping->result = future->result;
 
-    destroy_derivation_mapping_future_iterator(&iterator);
-    return success;
+        /* The build result can be retrieved right away */
+        g_queue_push_tail(pipeline->retrieve_queue, create_build_job(BUILD_JOB_RETRIEVE, job->interface_name, job->mapping));
+    }
+    else
+    {
+        g_printerr("[target: %s]: Realising derivation: %s has failed!\n", job->mapping->interface, job->mapping->derivation);
+        pipeline->success = FALSE;
+    }
 }
 
 /* Build result retrieval infrastructure */
 
-static pid_t copy_result_from(void *data, DerivationMapping *mapping, Interface *interface)
+static ProcReact_Future copy_result_from(BuildPipeline *pipeline, BuildJob *job)
 {
+    DerivationMapping *mapping = job->mapping;
+    Interface *interface = g_hash_table_lookup(pipeline->interfaces_table, job->interface_name);
+    ProcReact_Future future;
     char *path;
     unsigned int count = 0;
 
@@ -101,34 +279,177 @@ static pid_t copy_result_from(void *data, DerivationMapping *mapping, Interface
 
     g_print("\n");
 
-    return copy_closure_from((char*)interface->client_interface, (char*)interface->target_address, mapping->result, STDOUT_FILENO, STDERR_FILENO);
+    future = initialize_transfer_future();
+
+    if(future.pid == 0)
+        _exit(!copy_closure_from_sync((char*)interface->client_interface, (char*)interface->target_address, mapping->result, STDOUT_FILENO, STDERR_FILENO));
+
+    return future;
 }
 
-static void complete_copy_result_from(void *data, DerivationMapping *mapping, ProcReact_Status status, int result)
+static void complete_copy_result_from(BuildPipeline *pipeline, BuildJob *job, ProcReact_Future *future, ProcReact_Status status)
 {
-    if(status != PROCREACT_STATUS_OK || !result)
-        g_print("[target: %s]: Cannot send build result of store derivation to coordinator: %s\n", mapping->interface, mapping->derivation);
+    if(status != PROCREACT_STATUS_OK || future->result == NULL)
+    {
+        g_print("[target: %s]: Cannot send build result of store derivation to coordinator: %s\n", job->mapping->interface, job->mapping->derivation);
+        pipeline->success = FALSE;
+    }
+
+    delete_transfer_result(future->result);
 }
 
-static ProcReact_bool retrieve_results(const GPtrArray *derivation_mapping_array, GHashTable *interfaces_table, const unsigned int max_concurrent_transfers)
+/* Build orchestration */
+
+static GQueue *find_realise_queue_with_available_core(BuildPipeline *pipeline)
 {
-    ProcReact_bool success;
-    ProcReact_PidIterator iterator = create_derivation_mapping_pid_iterator(derivation_mapping_array, interfaces_table, copy_result_from, complete_copy_result_from, NULL);
+    if(pipeline->num_of_waiting_realisations == 0 || (pipeline->max_concurrent_builds > 0 && pipeline->running_builds >= pipeline->max_concurrent_builds))
+        return NULL;
+    else
+    {
+        GHashTableIter iter;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&iter, pipeline->realise_queues_table);
 
-    g_print("[coordinator]: Retrieving build results...\n");
+        while(g_hash_table_iter_next(&iter, &key, &value))
+        {
+            GQueue *realise_queue = (GQueue*)value;
+            Interface *interface = g_hash_table_lookup(pipeline->interfaces_table, (gchar*)key);
 
-    procreact_fork_and_wait_in_parallel_limit(&iterator, max_concurrent_transfers);
-    success = derivation_mapping_iterator_has_succeeded(iterator.data);
+            if(!g_queue_is_empty(realise_queue) && interface->available_cores > 0)
+                return realise_queue;
+        }
 
-    destroy_derivation_mapping_pid_iterator(&iterator);
-    return success;
+        return NULL;
+    }
 }
 
-/* Build orchestration */
+static ProcReact_bool has_next_build_job(void *data)
+{
+    BuildPipeline *pipeline = (BuildPipeline*)data;
 
-ProcReact_bool build(DistributedDerivation *distributed_derivation, const unsigned int max_concurrent_transfers, char *tmpdir)
+    /* Stop scheduling new jobs after a failure, but let the running jobs finish */
+    if(!pipeline->success)
+        return FALSE;
+    else
+        return (find_realise_queue_with_available_core(pipeline) != NULL
+          || (pipeline->running_transfers < pipeline->max_concurrent_transfers && (!g_queue_is_empty(pipeline->distribute_queue) || !g_queue_is_empty(pipeline->retrieve_queue))));
+}
+
+static ProcReact_Future next_build_job(void *data)
 {
-    return (distribute_derivation_mappings(distributed_derivation->derivation_mapping_array, distributed_derivation->interfaces_table, max_concurrent_transfers, tmpdir) /* Distribute derivations to target machines */
-      && realise(distributed_derivation->derivation_mapping_array, distributed_derivation->interfaces_table) /* Realise derivations on target machines */
-      && retrieve_results(distributed_derivation->derivation_mapping_array, distributed_derivation->interfaces_table, max_concurrent_transfers)); /* Retrieve back the build results */
+    BuildPipeline *pipeline = (BuildPipeline*)data;
+    GQueue *realise_queue = find_realise_queue_with_available_core(pipeline);
+    BuildJob *job;
+    ProcReact_Future future;
+
+    /* Realisations do not need a transfer slot, but a CPU core of the target, so they are started first. Among the transfers, distributions go before retrievals, because they unblock realisations */
+    if(realise_queue != NULL)
+    {
+        job = g_queue_pop_head(realise_queue);
+        request_available_interface_core(g_hash_table_lookup(pipeline->interfaces_table, job->interface_name));
+        pipeline->num_of_waiting_realisations--;
+        pipeline->running_builds++;
+        future = realise_derivation_mapping(pipeline, job);
+    }
+    else
+    {
+        if((job = g_queue_pop_head(pipeline->distribute_queue)) != NULL)
+            future = distribute_derivations(pipeline, job);
+        else
+        {
+            job = g_queue_pop_head(pipeline->retrieve_queue);
+            future = copy_result_from(pipeline, job);
+        }
+
+        pipeline->running_transfers++;
+    }
+
+    if(future.pid > 0)
+        g_hash_table_insert(pipeline->running_jobs_table, GINT_TO_POINTER(future.pid), job);
+
+    pipeline->last_job = job;
+    return future;
+}
+
+static void complete_build_job(void *data, ProcReact_Future *future, ProcReact_Status status)
+{
+    BuildPipeline *pipeline = (BuildPipeline*)data;
+    BuildJob *job;
+
+    /* A job that could not be spawned is completed right away */
+    if(status == PROCREACT_STATUS_FORK_FAIL)
+        job = pipeline->last_job;
+    else
+    {
+        job = g_hash_table_lookup(pipeline->running_jobs_table, GINT_TO_POINTER(future->pid));
+        g_hash_table_remove(pipeline->running_jobs_table, GINT_TO_POINTER(future->pid));
+    }
+
+    switch(job->type)
+    {
+        case BUILD_JOB_DISTRIBUTE:
+            complete_distribute_derivations(pipeline, job, future, status);
+            pipeline->running_transfers--;
+            break;
+        case BUILD_JOB_REALISE:
+            complete_realise_derivation_mapping(pipeline, job, future, status);
+            signal_available_interface_core(g_hash_table_lookup(pipeline->interfaces_table, job->interface_name));
+            pipeline->running_builds--;
+            break;
+        case BUILD_JOB_RETRIEVE:
+            complete_copy_result_from(pipeline, job, future, status);
+            pipeline->running_transfers--;
+            break;
+    }
+
+    g_free(job);
+}
+
+ProcReact_bool build(DistributedDerivation *distributed_derivation, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_builds, char *tmpdir)
+{
+    BuildPipeline pipeline;
+    ProcReact_FutureIterator iterator;
+
+    pipeline.derivations_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, delete_array);
+    pipeline.mappings_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, delete_array);
+    pipeline.interfaces_table = distributed_derivation->interfaces_table;
+    pipeline.distribute_queue = g_queue_new();
+    pipeline.realise_queues_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, delete_build_jobs);
+    pipeline.num_of_waiting_realisations = 0;
+    pipeline.retrieve_queue = g_queue_new();
+    pipeline.running_jobs_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pipeline.last_job = NULL;
+    pipeline.max_concurrent_transfers = max_concurrent_transfers;
+    pipeline.running_transfers = 0;
+    pipeline.max_concurrent_builds = max_concurrent_builds;
+    pipeline.running_builds = 0;
+    pipeline.success = TRUE;
+
+    group_derivations_per_interface(&pipeline, distributed_derivation->derivation_mapping_array);
+    pipeline.export_cache_dir = create_derivations_export_cache(pipeline.derivations_table, tmpdir);
+
+    g_print("[coordinator]: Distributing, realising and retrieving store derivations...\n");
+
+    /* Spawn all jobs that are ready and wait for a job to complete, which may make new jobs ready */
+    iterator = procreact_initialize_future_iterator(has_next_build_job, next_build_job, complete_build_job, &pipeline);
+
+    do
+    {
+        while(procreact_spawn_next_future(&iterator))
+            ;
+    }
+    while(procreact_buffer(&iterator) > 0 || has_next_build_job(&pipeline));
+
+    /* Cleanup */
+    procreact_destroy_future_iterator(&iterator);
+    delete_build_jobs(pipeline.distribute_queue);
+    g_hash_table_destroy(pipeline.realise_queues_table);
+    delete_build_jobs(pipeline.retrieve_queue);
+    g_hash_table_destroy(pipeline.running_jobs_table);
+    g_hash_table_destroy(pipeline.mappings_table);
+    g_hash_table_destroy(pipeline.derivations_table);
+    pkgmgmt_delete_export_cache(pipeline.export_cache_dir);
+
+    return pipeline.success;
 }
@@ -28,9 +28,10 @@
  *
  * @param distributed_derivation Configuration specifying a mapping between store derivations and machines
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param max_concurrent_builds Specifies the maximum amount of concurrent builds across all machines, or 0 to only limit them by the amount of CPU cores of each machine
  * @param tmpdir Directory in which the temp files should be stored
  * @return TRUE if all the remote builds succeed, else FALSE
  */
-ProcReact_bool build(DistributedDerivation *distributed_derivation, const unsigned int max_concurrent_transfers, char *tmpdir);
+ProcReact_bool build(DistributedDerivation *distributed_derivation, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_builds, char *tmpdir);
 
 #endif
@@ -0,0 +1,46 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "client-interface.h"
+#include <string.h>
+#include <procreact_spawn.h>
+
+static gboolean is_local_interface(const gchar *interface)
+{
+    gchar *basename = g_path_get_basename(interface);
+    gboolean result = (strcmp(basename, LOCAL_CLIENT_INTERFACE) == 0);
+    g_free(basename);
+    return result;
+}
+
+pid_t client_interface_spawn(char *const *args, int stdin_fd, int stdout_fd, int stderr_fd, unsigned int flags, local_process_function local_function, void *data)
+{
+    if(local_function != NULL && is_local_interface(args[0]))
+        return local_function(data);
+    else
+        return procreact_spawn(args, NULL, stdin_fd, stdout_fd, stderr_fd, flags);
+}
+
+ProcReact_Future client_interface_spawn_future(ProcReact_Type type, char *const *args, int stdin_fd, int stderr_fd, unsigned int flags, local_future_function local_function, void *data)
+{
+    if(local_function != NULL && is_local_interface(args[0]))
+        return local_function(data);
+    else
+        return procreact_spawn_future(type, args, NULL, stdin_fd, stderr_fd, flags);
+}
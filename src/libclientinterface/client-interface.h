@@ -0,0 +1,81 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_CLIENT_INTERFACE_H
+#define __DISNIX_CLIENT_INTERFACE_H
+#include <unistd.h>
+#include <glib.h>
+#include <procreact_future.h>
+
+/** Name of the client interface that carries out operations on the machine of the caller */
+#define LOCAL_CLIENT_INTERFACE "disnix-run-activity"
+
+/**
+ * Pointer to a function that carries out an operation in-process, instead of
+ * executing the local client interface.
+ *
+ * @param data Pointer to a data structure with the parameters of the operation
+ * @return PID of the spawned process
+ */
+typedef pid_t (*local_process_function) (void *data);
+
+/**
+ * Pointer to a function that carries out an operation in-process, instead of
+ * executing the local client interface, and returns its output as a future.
+ *
+ * @param data Pointer to a data structure with the parameters of the operation
+ * @return Future of the spawned process
+ */
+typedef ProcReact_Future (*local_future_function) (void *data);
+
+/**
+ * Executes an operation through a client interface. This is the only place
+ * in which the backend is chosen: if the interface is disnix-run-activity and
+ * the operation provides a local function, that function is invoked instead,
+ * so that the operation is carried out in-process. Otherwise, the interface
+ * is executed.
+ *
+ * @param args NULL-terminated array of arguments. The first argument is the path or name of the client interface executable
+ * @param stdin_fd File descriptor to attach to the standard input or -1 to use the parent's
+ * @param stdout_fd File descriptor to attach to the standard output or -1 to use the parent's
+ * @param stderr_fd File descriptor to attach to the standard error or -1 to use the parent's
+ * @param flags Spawn flags
+ * @param local_function Function that carries out the operation in-process or NULL if the interface must always be executed
+ * @param data Parameters passed to the local function
+ * @return PID of the spawned process
+ */
+pid_t client_interface_spawn(char *const *args, int stdin_fd, int stdout_fd, int stderr_fd, unsigned int flags, local_process_function local_function, void *data);
+
+/**
+ * Executes an operation through a client interface and captures its output
+ * in a future. The backend is chosen in the same way as
+ * client_interface_spawn().
+ *
+ * @param type Type where the output will be converted to
+ * @param args NULL-terminated array of arguments. The first argument is the path or name of the client interface executable
+ * @param stdin_fd File descriptor to attach to the standard input or -1 to use the parent's
+ * @param stderr_fd File descriptor to attach to the standard error or -1 to use the parent's
+ * @param flags Spawn flags
+ * @param local_function Function that carries out the operation in-process or NULL if the interface must always be executed
+ * @param data Parameters passed to the local function
+ * @return Future of the spawned process
+ */
+ProcReact_Future client_interface_spawn_future(ProcReact_Type type, char *const *args, int stdin_fd, int stderr_fd, unsigned int flags, local_future_function local_function, void *data);
+
+#endif
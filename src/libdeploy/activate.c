@@ -65,7 +65,7 @@ void print_transition_status(TransitionStatus status, const gchar *old_manifest_
     }
 }
 
-TransitionStatus activate_system(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void))
+TransitionStatus activate_system(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void), BackgroundProcesses *background)
 {
     TransitionStatus status;
 
@@ -85,7 +85,7 @@ TransitionStatus activate_system(Manifest *manifest, Manifest *previous_manifest
     if(pre_hook != NULL) /* Execute hook before the lock operations are executed */
         pre_hook();
 
-    status = transition(manifest, previous_manifest, flags);
+    status = transition(manifest, previous_manifest, flags, background);
 
     if(post_hook != NULL) /* Execute hook after the lock operations have been completed */
         post_hook();
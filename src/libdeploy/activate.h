@@ -43,8 +43,9 @@ void print_transition_status(TransitionStatus status, const gchar *old_manifest_
  * @param Deployment option flags
  * @param pre_hook Pointer to a function that gets executed before a series of critical operations start. This function can be used to catch a SIGINT signal and do a proper rollback. If the pointer is NULL then no function is executed.
  * @param pre_hook Pointer to a function that gets executed after the critical operations are done. This function can be used to restore the handler for the SIGINT to normal. If the pointer is NULL then no function is executed.
+ * @param background Background processes that prepare the target machines or NULL if all target machines are ready
  * @return A value from the TransitionStatus enumeration
  */
-TransitionStatus activate_system(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void));
+TransitionStatus activate_system(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void), BackgroundProcesses *background);
 
 #endif
@@ -4,20 +4,27 @@
 #include "activate.h"
 #include "locking.h"
 #include "set-profiles.h"
+#include "pipeline.h"
 
-static int distribute_closures(Manifest *manifest, const unsigned int max_concurrent_transfers, char *tmpdir)
+static int distribute_closures(Manifest *manifest, Manifest *old_manifest, const unsigned int max_concurrent_transfers, char *tmpdir)
 {
     g_print("[coordinator]: Distributing intra-dependency closures...\n");
-    return distribute(manifest, max_concurrent_transfers, tmpdir);
+    return distribute(manifest, old_manifest, max_concurrent_transfers, tmpdir);
 }
 
-static TransitionStatus activate_new_configuration(gchar *old_manifest_file, const gchar *new_manifest, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void))
+static TargetPreparation *prepare_targets(Manifest *manifest, Manifest *old_manifest, gchar *profile, const unsigned int max_concurrent_transfers, char *tmpdir, const unsigned int flags)
+{
+    g_print("[coordinator]: Distributing intra-dependency closures and acquiring locks while activating...\n");
+    return start_target_preparation(manifest, old_manifest, profile, max_concurrent_transfers, tmpdir, flags);
+}
+
+static TransitionStatus activate_new_configuration(gchar *old_manifest_file, const gchar *new_manifest, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void), TargetPreparation *preparation)
 {
     TransitionStatus status;
 
     g_print("[coordinator]: Activating new configuration...\n");
 
-    status = activate_system(manifest, old_manifest, flags, pre_hook, post_hook);
+    status = activate_system(manifest, old_manifest, flags, pre_hook, post_hook, (preparation == NULL) ? NULL : &preparation->background);
     print_transition_status(status, old_manifest_file, new_manifest, coordinator_profile_path, profile);
 
     return status;
@@ -37,7 +44,7 @@ static int acquire_locks(Manifest *manifest, const unsigned int flags, gchar *pr
     }
 }
 
-static int release_locks(Manifest *manifest, const unsigned int flags, gchar *profile, void (*pre_hook) (void), void (*post_hook) (void))
+static int release_locks(Manifest *manifest, const unsigned int flags, gchar *profile, void (*pre_hook) (void), void (*post_hook) (void), TargetPreparation *preparation)
 {
     if(flags & FLAG_NO_LOCK)
     {
@@ -47,18 +54,22 @@ static int release_locks(Manifest *manifest, const unsigned int flags, gchar *pr
     else
     {
         g_print("[coordinator]: Releasing locks...\n");
-        return unlock(manifest->profile_mapping_table, manifest->targets_table, profile, pre_hook, post_hook);
+
+        if(preparation == NULL)
+            return unlock(manifest->profile_mapping_table, manifest->targets_table, profile, pre_hook, post_hook);
+        else
+            return unlock(preparation->lock_table, manifest->targets_table, profile, pre_hook, post_hook); /* Only the targets that have been prepared are locked */
     }
 }
 
-static int migrate_data(Manifest *manifest, Manifest *old_manifest, const unsigned int max_concurrent_transfers, const unsigned int flags, const unsigned int keep)
+static int migrate_data(Manifest *manifest, Manifest *old_manifest, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const unsigned int keep)
 {
     if(flags & FLAG_NO_MIGRATION)
         return TRUE;
     else
     {
         g_print("[coordinator]: Migrating data...\n");
-        return migrate(manifest, old_manifest, max_concurrent_transfers, flags, keep);
+        return migrate(manifest, old_manifest, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep);
     }
 }
 
@@ -68,34 +79,67 @@ static int set_all_profiles(Manifest *manifest, const gchar *new_manifest, const
     return set_profiles(manifest, new_manifest, coordinator_profile_path, profile, 0);
 }
 
-DeployStatus deploy(gchar *old_manifest_file, const gchar *new_manifest_file, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int max_concurrent_transfers, char *tmpdir, const unsigned int keep, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void))
+static DeployStatus execute_deployment(gchar *old_manifest_file, const gchar *new_manifest_file, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int keep, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void), TargetPreparation *preparation)
 {
-    if(!distribute_closures(manifest, max_concurrent_transfers, tmpdir))
-        return DEPLOY_FAIL;
+    if(activate_new_configuration(old_manifest_file, new_manifest_file, manifest, old_manifest, profile, coordinator_profile_path, flags, pre_hook, post_hook, preparation) != 0)
+    {
+        if(preparation != NULL)
+        {
+            if(pre_hook != NULL) /* Execute hook before the remaining preparations are awaited */
+                pre_hook();
 
-    if(!acquire_locks(manifest, flags, profile, pre_hook, post_hook))
-        return DEPLOY_FAIL;
+            finish_target_preparation(preparation); /* Wait for the remaining preparations, so that all acquired locks can be released */
 
-    if(activate_new_configuration(old_manifest_file, new_manifest_file, manifest, old_manifest, profile, coordinator_profile_path, flags, pre_hook, post_hook) != 0)
-    {
-        release_locks(manifest, flags, profile, pre_hook, post_hook);
+            if(post_hook != NULL) /* Execute hook after the preparations have been completed */
+                post_hook();
+        }
+
+        release_locks(manifest, flags, profile, pre_hook, post_hook, preparation);
         return DEPLOY_FAIL;
     }
 
-    if(!migrate_data(manifest, old_manifest, max_concurrent_transfers, flags, keep))
+    if(!migrate_data(manifest, old_manifest, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep))
     {
-        release_locks(manifest, flags, profile, pre_hook, post_hook);
+        release_locks(manifest, flags, profile, pre_hook, post_hook, preparation);
         return DEPLOY_STATE_FAIL;
     }
 
     if(!set_all_profiles(manifest, new_manifest_file, coordinator_profile_path, profile))
     {
-        release_locks(manifest, flags, profile, pre_hook, post_hook);
+        release_locks(manifest, flags, profile, pre_hook, post_hook, preparation);
         return DEPLOY_FAIL;
     }
 
-    if(!release_locks(manifest, flags, profile, pre_hook, post_hook))
+    if(!release_locks(manifest, flags, profile, pre_hook, post_hook, preparation))
         return DEPLOY_FAIL;
 
     return DEPLOY_OK;
 }
+
+DeployStatus deploy(gchar *old_manifest_file, const gchar *new_manifest_file, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, char *tmpdir, const unsigned int keep, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void))
+{
+    if(flags & FLAG_PIPELINE)
+    {
+        /* Activate the services of each target as soon as it has received its closure and has been locked */
+        DeployStatus status;
+        TargetPreparation *preparation;
+
+        if(pre_hook != NULL) /* Execute hook before the preparations acquire their locks */
+            pre_hook();
+
+        preparation = prepare_targets(manifest, old_manifest, profile, max_concurrent_transfers, tmpdir, flags);
+        status = execute_deployment(old_manifest_file, new_manifest_file, manifest, old_manifest, profile, coordinator_profile_path, max_concurrent_transfers, max_concurrent_snapshot_transfers, keep, flags, pre_hook, post_hook, preparation);
+        delete_target_preparation(preparation);
+        return status;
+    }
+    else
+    {
+        if(!distribute_closures(manifest, old_manifest, max_concurrent_transfers, tmpdir))
+            return DEPLOY_FAIL;
+
+        if(!acquire_locks(manifest, flags, profile, pre_hook, post_hook))
+            return DEPLOY_FAIL;
+
+        return execute_deployment(old_manifest_file, new_manifest_file, manifest, old_manifest, profile, coordinator_profile_path, max_concurrent_transfers, max_concurrent_snapshot_transfers, keep, flags, pre_hook, post_hook, NULL);
+    }
+}
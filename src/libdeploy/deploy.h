@@ -37,6 +37,11 @@ DeployStatus;
  * Executes all required deployment activites to deploy a configuration
  * described in a manifest file.
  *
+ * By default, all closures are distributed and all targets are locked before
+ * the transition starts. If the FLAG_PIPELINE flag is set, the services of a
+ * target are (de)activated as soon as it has received its closure and has
+ * been locked.
+ *
  * @param old_manifest_file Path to the old manifest file
  * @param new_manifest_file Path to the new manifest file
  * @param manifest Manifest containing all deployment information of the new configuration
@@ -44,6 +49,7 @@ DeployStatus;
  * @param profile Name of the distributed profile
  * @param coordinator_profile_path Path where the current deployment configuration must be stored
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param max_concurrent_snapshot_transfers Specifies the maximum amount of concurrent snapshot transfers per target machine
  * @param tmpdir Directory in which the temp files should be stored
  * @param keep Indicates how many snapshot generations should be kept remotely while executing the depth first operation
  * @param flags Deployment option flags
@@ -51,6 +57,6 @@ DeployStatus;
  * @param pre_hook Pointer to a function that gets executed after the critical operations are done. This function can be used to restore the handler for the SIGINT to normal. If the pointer is NULL then no function is executed.
  * @return One of the possible outcomes in the DeployStatus enumeration
  */
-DeployStatus deploy(gchar *old_manifest_file, const gchar *new_manifest_fike, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int max_concurrent_transfers, char *tmpdir, const unsigned int keep, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void));
+DeployStatus deploy(gchar *old_manifest_file, const gchar *new_manifest_fike, Manifest *manifest, Manifest *old_manifest, gchar *profile, const gchar *coordinator_profile_path, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, char *tmpdir, const unsigned int keep, const unsigned int flags, void (*pre_hook) (void), void (*post_hook) (void));
 
 #endif
@@ -26,5 +26,7 @@
 #define FLAG_DRY_RUN 0x200
 #define FLAG_NO_LOCK 0x400
 #define FLAG_NO_MIGRATION 0x800
+#define FLAG_PIPELINE 0x1000
+#define FLAG_BATCH_ACTIVITIES 0x2000
 
 #endif
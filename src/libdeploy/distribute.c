@@ -22,14 +22,45 @@
 #include <profilemapping-iterator.h>
 #include <targetstable.h>
 #include <copy-closure.h>
+#include <export-cache.h>
 
-static pid_t transfer_profile_mapping_to(void *data, gchar *target_name, xmlChar *profile_path, Target *target)
+typedef struct
+{
+    gchar *export_cache_dir;
+    GHashTable *old_profile_mapping_table;
+}
+DistributionData;
+
+ProcReact_bool distribute_profile_mapping_sync(gchar *export_cache_dir, GHashTable *old_profile_mapping_table, gchar *target_name, xmlChar *profile_path, Target *target)
 {
-    char *tmpdir = (char*)data;
     char *paths[] = { (char*)profile_path, NULL };
     gchar *target_key = find_target_key(target);
+    xmlChar *old_profile_path = NULL;
+
+    /* The profile that was deployed previously is still in use on the target, so its closure is known to be valid there */
+    if(old_profile_mapping_table != NULL)
+        old_profile_path = g_hash_table_lookup(old_profile_mapping_table, target_name);
+
     g_print("[target: %s]: Receiving intra-dependency closure of profile: %s\n", target_name, profile_path);
-    return copy_closure_to((char*)target->client_interface, target_key, tmpdir, paths, STDERR_FILENO);
+
+    if(old_profile_path == NULL)
+        return copy_closure_to_sync((char*)target->client_interface, target_key, export_cache_dir, paths, NULL, STDERR_FILENO);
+    else
+    {
+        char *known_valid_roots[] = { (char*)old_profile_path, NULL };
+        return copy_closure_to_sync((char*)target->client_interface, target_key, export_cache_dir, paths, known_valid_roots, STDERR_FILENO);
+    }
+}
+
+static pid_t transfer_profile_mapping_to(void *data, gchar *target_name, xmlChar *profile_path, Target *target)
+{
+    DistributionData *distribution_data = (DistributionData*)data;
+    pid_t pid = fork();
+
+    if(pid == 0)
+        _exit(!distribute_profile_mapping_sync(distribution_data->export_cache_dir, distribution_data->old_profile_mapping_table, target_name, profile_path, target));
+
+    return pid;
 }
 
 static void complete_transfer_profile_mapping_to(void *data, gchar *target_name, xmlChar *profile_path, Target *target, ProcReact_Status status, int result)
@@ -38,16 +69,51 @@ static void complete_transfer_profile_mapping_to(void *data, gchar *target_name,
         g_printerr("[target: %s]: Cannot receive intra-dependency closure of profile: %s\n", target_name, profile_path);
 }
 
-ProcReact_bool distribute(const Manifest *manifest, const unsigned int max_concurrent_transfers, char *tmpdir)
+gchar *create_profile_export_cache(const Manifest *manifest, char *tmpdir)
+{
+    GPtrArray *transfers = g_ptr_array_new_with_free_func(g_free);
+    GHashTableIter iter;
+    gpointer key, value;
+    gchar *export_cache_dir;
+
+    g_hash_table_iter_init(&iter, manifest->profile_mapping_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+        if(g_hash_table_contains(manifest->targets_table, key))
+        {
+            gchar **roots = g_new(gchar*, 2);
+            roots[0] = (gchar*)value;
+            roots[1] = NULL;
+            g_ptr_array_add(transfers, roots);
+        }
+    }
+
+    export_cache_dir = pkgmgmt_create_export_cache(tmpdir, transfers, STDERR_FILENO);
+    g_ptr_array_free(transfers, TRUE);
+
+    return export_cache_dir;
+}
+
+ProcReact_bool distribute(const Manifest *manifest, const Manifest *old_manifest, const unsigned int max_concurrent_transfers, char *tmpdir)
 {
     /* Iterate over the profile mappings, limiting concurrency to the desired concurrent transfers and distribute them */
     ProcReact_bool success;
-    ProcReact_PidIterator iterator = create_profile_mapping_iterator(manifest->profile_mapping_table, manifest->targets_table, transfer_profile_mapping_to, complete_transfer_profile_mapping_to, tmpdir);
+    ProcReact_PidIterator iterator;
+    DistributionData distribution_data;
+
+    /* Export store paths that multiple targets need only once */
+    gchar *export_cache_dir = create_profile_export_cache(manifest, tmpdir);
+
+    distribution_data.export_cache_dir = export_cache_dir;
+    distribution_data.old_profile_mapping_table = (old_manifest == NULL) ? NULL : old_manifest->profile_mapping_table;
+
+    iterator = create_profile_mapping_iterator(manifest->profile_mapping_table, manifest->targets_table, transfer_profile_mapping_to, complete_transfer_profile_mapping_to, &distribution_data);
     procreact_fork_and_wait_in_parallel_limit(&iterator, max_concurrent_transfers);
     success = profile_mapping_iterator_has_succeeded(&iterator);
 
     /* Delete resources */
     destroy_profile_mapping_iterator(&iterator);
+    pkgmgmt_delete_export_cache(export_cache_dir);
 
     /* Return status */
     return success;
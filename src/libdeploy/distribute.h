@@ -21,16 +21,42 @@
 #define __DISNIX_DISTRIBUTE_H
 #include <procreact_types.h>
 #include <manifest.h>
+#include <target.h>
+
+/**
+ * Distributes the intra-dependency closure of a profile to a target machine.
+ *
+ * @param export_cache_dir Path to an export cache shared with other transfers or NULL to export the closure directly
+ * @param old_profile_mapping_table Profile mappings of the previous deployment or NULL if they are unknown
+ * @param target_name Name of the target machine
+ * @param profile_path Path to the Nix profile to distribute
+ * @param target The target machine to distribute to
+ * @return TRUE if the closure has been successfully transferred, else FALSE
+ */
+ProcReact_bool distribute_profile_mapping_sync(gchar *export_cache_dir, GHashTable *old_profile_mapping_table, gchar *target_name, xmlChar *profile_path, Target *target);
+
+/**
+ * Creates an export cache for the store paths that the intra-dependency
+ * closures of more than one profile in the manifest share.
+ *
+ * @param manifest Manifest containing all deployment information
+ * @param tmpdir Directory in which the temp files should be stored
+ * @return Path to the cache directory or NULL if the profiles should be exported directly. It should be removed with pkgmgmt_delete_export_cache()
+ */
+gchar *create_profile_export_cache(const Manifest *manifest, char *tmpdir);
 
 /**
  * Distributes the Nix store closures of all services in the manifest to the
- * target machines in the network.
+ * target machines in the network. The closures of the profiles in the
+ * previous manifest are considered valid on their targets, so that only
+ * the remaining requisites have to be checked remotely.
  *
  * @param manifest Manifest containing all deployment information
+ * @param old_manifest Manifest of the previous deployment or NULL if it is unknown
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
  * @param tmpdir Directory in which the temp files should be stored
  * @return TRUE if all closures have been successfully transferred, else FALSE
  */
-ProcReact_bool distribute(const Manifest *manifest, const unsigned int max_concurrent_transfers, char *tmpdir);
+ProcReact_bool distribute(const Manifest *manifest, const Manifest *old_manifest, const unsigned int max_concurrent_transfers, char *tmpdir);
 
 #endif
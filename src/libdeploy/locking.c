@@ -70,12 +70,17 @@ typedef struct
 }
 LockData;
 
-static pid_t lock_profile_mapping(void *data, gchar *target_name, xmlChar *profile_path, Target *target)
+pid_t lock_target(gchar *target_name, xmlChar *profile_path, Target *target, gchar *profile)
 {
-    LockData *lock_data = (LockData*)data;
     gchar *target_key = find_target_key(target);
     g_print("[target: %s]: Acquiring a lock on profile: %s\n", target_name, profile_path);
-    return statemgmt_remote_lock((char*)target->client_interface, target_key, lock_data->profile);
+    return statemgmt_remote_lock((char*)target->client_interface, target_key, profile);
+}
+
+static pid_t lock_profile_mapping(void *data, gchar *target_name, xmlChar *profile_path, Target *target)
+{
+    LockData *lock_data = (LockData*)data;
+    return lock_target(target_name, profile_path, target, lock_data->profile);
 }
 
 static void complete_lock_profile_mapping(void *data, gchar *target_name, xmlChar *profile_path, Target *target, ProcReact_Status status, int result)
@@ -21,6 +21,7 @@
 #define __DISNIX_LOCKING_H
 #include <glib.h>
 #include <procreact_types.h>
+#include <targetstable.h>
 
 /**
  * Unlocks the target machine and all services on all target machines in the
@@ -35,6 +36,17 @@
  */
 ProcReact_bool unlock(GHashTable *profile_mapping_table, GHashTable *targets_table, gchar *profile, void (*pre_hook) (void), void (*post_hook) (void));
 
+/**
+ * Spawns a process that locks a profile and all services on a target machine.
+ *
+ * @param target_name Name of the target machine
+ * @param profile_path Path to the Disnix profile of the target machine
+ * @param target Properties of the target machine
+ * @param profile Identifier of the distributed profile
+ * @return PID of the spawned process
+ */
+pid_t lock_target(gchar *target_name, xmlChar *profile_path, Target *target, gchar *profile);
+
 /**
  * Locks the target machine and all services on all target machines in the
  * network.
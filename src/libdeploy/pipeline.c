@@ -0,0 +1,172 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "pipeline.h"
+#include <sys/wait.h>
+#include <targetstable.h>
+#include <export-cache.h>
+#include "distribute.h"
+#include "deploymentflags.h"
+#include "locking.h"
+
+/* Exit statuses of a preparation process */
+#define PREPARATION_OK 0
+#define PREPARATION_FAILED 1
+#define PREPARATION_LOCK_UNKNOWN 2
+
+extern volatile int interrupted;
+
+static pid_t prepare_target(TargetPreparation *preparation, gchar *target_name, xmlChar *profile_path, Target *target)
+{
+    pid_t pid = fork();
+
+    if(pid == 0)
+    {
+        /* First receive the closure, then lock the target so that it is not locked longer than needed */
+        ProcReact_bool result = distribute_profile_mapping_sync(preparation->export_cache_dir, preparation->old_profile_mapping_table, target_name, profile_path, target);
+
+        if(result && !(preparation->flags & FLAG_NO_LOCK))
+        {
+            ProcReact_Status status;
+
+            if(interrupted) /* Do not acquire new locks after the deployment has been interrupted */
+                _exit(PREPARATION_FAILED);
+
+            result = procreact_wait_for_boolean(lock_target(target_name, profile_path, target, preparation->profile), &status);
+
+            /* If the lock process did not terminate normally, it may have acquired the lock anyway */
+            if(status != PROCREACT_STATUS_OK)
+                _exit(PREPARATION_LOCK_UNKNOWN);
+        }
+
+        _exit(result ? PREPARATION_OK : PREPARATION_FAILED);
+    }
+
+    return pid;
+}
+
+static void start_pending_preparations(TargetPreparation *preparation)
+{
+    gpointer key, value;
+
+    while(preparation->running_processes < preparation->max_concurrent_transfers && g_hash_table_iter_next(&preparation->iter, &key, &value))
+    {
+        gchar *target_name = (gchar*)key;
+        Target *target = g_hash_table_lookup(preparation->manifest->targets_table, target_name);
+
+        if(target != NULL)
+        {
+            pid_t pid = prepare_target(preparation, target_name, (xmlChar*)value, target);
+
+            if(pid == -1)
+            {
+                g_printerr("[target: %s]: Cannot fork process to prepare the target!\n", target_name);
+                target->readiness = TARGET_UNAVAILABLE;
+            }
+            else
+            {
+                procreact_add_pid(&preparation->background.pid_set, pid, target_name);
+                preparation->running_processes++;
+            }
+        }
+    }
+}
+
+static const gchar *complete_target_preparation(void *data, pid_t pid, int wstatus, void *process_data)
+{
+    TargetPreparation *preparation = (TargetPreparation*)data;
+    gchar *target_name = (gchar*)process_data;
+    Target *target = g_hash_table_lookup(preparation->manifest->targets_table, target_name);
+    ProcReact_Status status;
+    ProcReact_bool result = procreact_retrieve_boolean(pid, wstatus, &status);
+
+    if(status == PROCREACT_STATUS_OK && result)
+        target->readiness = TARGET_READY;
+    else
+    {
+        g_printerr("[target: %s]: Cannot receive the intra-dependency closure or acquire the lock!\n", target_name);
+        target->readiness = TARGET_UNAVAILABLE;
+    }
+
+    /*
+     * Targets that have been locked must be unlocked afterwards. This also
+     * applies to targets whose lock process was killed or whose preparation
+     * could not be waited for, as they may still hold the lock.
+     */
+    if(!(preparation->flags & FLAG_NO_LOCK)
+      && (status != PROCREACT_STATUS_OK || result || WEXITSTATUS(wstatus) == PREPARATION_LOCK_UNKNOWN))
+        g_hash_table_insert(preparation->lock_table, target_name, g_hash_table_lookup(preparation->manifest->profile_mapping_table, target_name));
+
+    /* A transfer slot has become available, so the next target can be prepared */
+    preparation->running_processes--;
+    start_pending_preparations(preparation);
+
+    return target_name;
+}
+
+TargetPreparation *start_target_preparation(const Manifest *manifest, const Manifest *old_manifest, gchar *profile, const unsigned int max_concurrent_transfers, char *tmpdir, const unsigned int flags)
+{
+    TargetPreparation *preparation = (TargetPreparation*)g_malloc(sizeof(TargetPreparation));
+    GHashTableIter iter;
+    gpointer key, value;
+
+    preparation->background.pid_set = procreact_initialize_pid_set();
+    preparation->background.complete_background_process = complete_target_preparation;
+    preparation->background.data = preparation;
+    preparation->manifest = manifest;
+    preparation->old_profile_mapping_table = (old_manifest == NULL) ? NULL : old_manifest->profile_mapping_table;
+    preparation->profile = profile;
+    preparation->export_cache_dir = create_profile_export_cache(manifest, tmpdir); /* Export store paths that multiple targets need only once */
+    preparation->max_concurrent_transfers = max_concurrent_transfers;
+    preparation->running_processes = 0;
+    preparation->flags = flags;
+    preparation->lock_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+    /* Services can only be (de)activated on the targets with a profile mapping once they have been prepared */
+    g_hash_table_iter_init(&iter, manifest->profile_mapping_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+        Target *target = g_hash_table_lookup(manifest->targets_table, (gchar*)key);
+
+        if(target != NULL)
+            target->readiness = TARGET_PENDING;
+    }
+
+    g_hash_table_iter_init(&preparation->iter, manifest->profile_mapping_table);
+    start_pending_preparations(preparation);
+
+    return preparation;
+}
+
+ProcReact_bool finish_target_preparation(TargetPreparation *preparation)
+{
+    return wait_for_background_processes(&preparation->background, preparation->manifest->targets_table);
+}
+
+void delete_target_preparation(TargetPreparation *preparation)
+{
+    if(preparation != NULL)
+    {
+        procreact_destroy_pid_set(&preparation->background.pid_set);
+        pkgmgmt_delete_export_cache(preparation->export_cache_dir);
+        g_hash_table_destroy(preparation->lock_table);
+        g_free(preparation);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __DISNIX_PIPELINE_H
+#define __DISNIX_PIPELINE_H
+#include <glib.h>
+#include <procreact_types.h>
+#include <manifest.h>
+#include <servicemapping-traverse.h>
+
+/**
+ * @brief Prepares the target machines in the background while services are being (de)activated
+ *
+ * Preparing a target machine comprises distributing the intra-dependency
+ * closure of its profile and acquiring a lock on it. The services of a target
+ * machine can only be (de)activated once it has been prepared.
+ */
+typedef struct
+{
+    /** Background processes that run alongside the transition */
+    BackgroundProcesses background;
+    /** Manifest containing all deployment information of the new configuration */
+    const Manifest *manifest;
+    /** Profile mappings of the previous deployment or NULL if they are unknown */
+    GHashTable *old_profile_mapping_table;
+    /** Name of the profile to lock */
+    gchar *profile;
+    /** Path to the export cache that is shared by all transfers or NULL if they do not share any store path */
+    gchar *export_cache_dir;
+    /** Iterator over the profile mappings that still need to be prepared */
+    GHashTableIter iter;
+    /** Maximum amount of target machines that are prepared concurrently */
+    unsigned int max_concurrent_transfers;
+    /** Amount of target machines that are currently being prepared */
+    unsigned int running_processes;
+    /** Deployment option flags */
+    unsigned int flags;
+    /** Hash table of the targets that have been locked or whose lock state is unknown */
+    GHashTable *lock_table;
+}
+TargetPreparation;
+
+/**
+ * Starts preparing all target machines that have a profile mapping in the
+ * manifest. Their readiness is set to pending until their preparation
+ * completes.
+ *
+ * @param manifest Manifest containing all deployment information of the new configuration
+ * @param old_manifest Manifest of the previous deployment or NULL if it is unknown
+ * @param profile Name of the profile to lock
+ * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param tmpdir Directory in which the temp files should be stored
+ * @param flags Deployment option flags
+ * @return A target preparation struct that should be removed with delete_target_preparation()
+ */
+TargetPreparation *start_target_preparation(const Manifest *manifest, const Manifest *old_manifest, gchar *profile, const unsigned int max_concurrent_transfers, char *tmpdir, const unsigned int flags);
+
+/**
+ * Waits for all target machines to be prepared.
+ *
+ * @param preparation A target preparation struct
+ * @return TRUE if all target machines have been successfully prepared, else FALSE
+ */
+ProcReact_bool finish_target_preparation(TargetPreparation *preparation);
+
+/**
+ * Deletes a target preparation struct from heap memory.
+ *
+ * @param preparation A target preparation struct
+ */
+void delete_target_preparation(TargetPreparation *preparation);
+
+#endif
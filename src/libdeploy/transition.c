@@ -22,6 +22,7 @@
 #include <manifestservicestable.h>
 #include <targetstable.h>
 #include <remote-state-management.h>
+#include <activity-batch.h>
 
 extern volatile int interrupted;
 
@@ -63,6 +64,75 @@ static pid_t dry_run_deactivate_mapping(ServiceMapping *mapping, ManifestService
     return statemgmt_dummy_command(); /* Execute dummy process */
 }
 
+static pid_t run_mapping_activities(gchar *activity, const gchar *description, ServiceMappingBatch *batch)
+{
+    gchar *target_key = find_target_key(batch->target);
+    GPtrArray *activity_batch = g_ptr_array_new();
+    FILE *batch_file = tmpfile();
+    FILE *results_file = tmpfile();
+    pid_t pid = -1;
+    unsigned int i;
+
+    /* Compose a batch in which all activities run in parallel. The traversal only batches mappings that have no pending prerequisites */
+    for(i = 0; i < batch->mappings->len; i++)
+    {
+        ServiceMapping *mapping = g_ptr_array_index(batch->mappings, i);
+        MappingParameters *params = &g_array_index(batch->parameters, MappingParameters, i);
+
+        print_activation_step(description, mapping, params->service, params->type, params->arguments, params->arguments_size); /* Print debug message */
+        g_ptr_array_add(activity_batch, create_activity_batch_item(0, activity, (gchar*)params->type, (gchar*)mapping->container, (gchar**)params->arguments, params->arguments_size, (gchar*)params->service->pkg));
+    }
+
+    /* The batch is read from a file and the outcomes are written to a file, so that the client interface never blocks on us */
+    if(batch_file != NULL && results_file != NULL && statemgmt_write_activity_batch(batch_file, activity_batch))
+    {
+        rewind(batch_file);
+        pid = statemgmt_remote_run_activities((char*)batch->target->client_interface, target_key, fileno(batch_file), fileno(results_file));
+    }
+
+    /* Cleanup */
+    delete_activity_batch(activity_batch);
+
+    if(batch_file != NULL)
+        fclose(batch_file);
+
+    if(pid == -1)
+    {
+        if(results_file != NULL)
+            fclose(results_file);
+    }
+    else
+        batch->data = results_file;
+
+    return pid;
+}
+
+static ProcReact_bool *complete_mapping_activities(ServiceMappingBatch *batch, ProcReact_Status status, ProcReact_bool result)
+{
+    FILE *results_file = (FILE*)batch->data;
+    gboolean *results;
+
+    rewind(results_file);
+    results = statemgmt_read_activity_batch_results(results_file, batch->mappings->len);
+    fclose(results_file);
+
+    return results;
+}
+
+static pid_t activate_mappings(ServiceMappingBatch *batch)
+{
+    return run_mapping_activities("activate", "Activating", batch);
+}
+
+static pid_t deactivate_mappings(ServiceMappingBatch *batch)
+{
+    return run_mapping_activities("deactivate", "Deactivating", batch);
+}
+
+static const ServiceMappingBatchFunctions batch_activation_functions = { activate_mappings, complete_mapping_activities };
+
+static const ServiceMappingBatchFunctions batch_deactivation_functions = { deactivate_mappings, complete_mapping_activities };
+
 static void complete_activation(ServiceMapping *mapping, ManifestService *service, Target *target, ProcReact_Status status, int result)
 {
     if(status == PROCREACT_STATUS_OK && result)
@@ -98,13 +168,13 @@ static void mark_erroneous_mappings(GPtrArray *unified_service_mapping_array, Se
     }
 }
 
-static int rollback_to_old_mappings(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GPtrArray *old_activation_mappings, GHashTable *targets_table, const unsigned int flags, service_mapping_function activate_mapping_function)
+static int rollback_to_old_mappings(const ServiceMappingIndex *index, GPtrArray *old_activation_mappings, GHashTable *targets_table, const unsigned int flags, service_mapping_function activate_mapping_function, const ServiceMappingBatchFunctions *activate_batch_functions, BackgroundProcesses *background)
 {
-    mark_erroneous_mappings(unified_service_mapping_array, SERVICE_MAPPING_ACTIVATED); /* Mark erroneous mappings as activated */
-    return traverse_service_mappings(old_activation_mappings, unified_service_mapping_array, unified_services_table, targets_table, traverse_inter_dependency_mappings, activate_mapping_function, complete_activation);
+    mark_erroneous_mappings(index->unified_service_mapping_array, SERVICE_MAPPING_ACTIVATED); /* Mark erroneous mappings as activated */
+    return traverse_service_mappings(old_activation_mappings, index, targets_table, lookup_inter_dependency_mappings, visit_inter_dependency_mapping, activate_mapping_function, complete_activation, background, activate_batch_functions);
 }
 
-static TransitionStatus deactivate_obsolete_mappings(GPtrArray *deactivation_array, GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GHashTable *targets_table, GPtrArray *old_activation_mappings, const unsigned int flags, service_mapping_function activate_mapping_function, service_mapping_function deactivate_mapping_function)
+static TransitionStatus deactivate_obsolete_mappings(GPtrArray *deactivation_array, const ServiceMappingIndex *index, GHashTable *targets_table, GPtrArray *old_activation_mappings, const unsigned int flags, service_mapping_function activate_mapping_function, service_mapping_function deactivate_mapping_function, const ServiceMappingBatchFunctions *activate_batch_functions, const ServiceMappingBatchFunctions *deactivate_batch_functions, BackgroundProcesses *background)
 {
     g_print("[coordinator]: Executing deactivation of services:\n");
 
@@ -112,7 +182,7 @@ static TransitionStatus deactivate_obsolete_mappings(GPtrArray *deactivation_arr
         return TRANSITION_SUCCESS;
     else
     {
-        if(traverse_service_mappings(deactivation_array, unified_service_mapping_array, unified_services_table, targets_table, traverse_interdependent_mappings, deactivate_mapping_function, complete_deactivation) && !interrupted)
+        if(traverse_service_mappings(deactivation_array, index, targets_table, lookup_interdependent_mappings, visit_interdependent_mapping, deactivate_mapping_function, complete_deactivation, background, deactivate_batch_functions) && !interrupted)
             return TRANSITION_SUCCESS;
         else
         {
@@ -129,7 +199,7 @@ static TransitionStatus deactivate_obsolete_mappings(GPtrArray *deactivation_arr
             {
                 /* If the deactivation fails, perform a rollback */
                 g_printerr("[coordinator]: Deactivation failed! Doing a rollback...\n");
-                if(rollback_to_old_mappings(unified_service_mapping_array, unified_services_table, old_activation_mappings, targets_table, flags, activate_mapping_function))
+                if(rollback_to_old_mappings(index, old_activation_mappings, targets_table, flags, activate_mapping_function, activate_batch_functions, background))
                     return TRANSITION_FAILED;
                 else
                 {
@@ -141,17 +211,20 @@ static TransitionStatus deactivate_obsolete_mappings(GPtrArray *deactivation_arr
     }
 }
 
-static int rollback_new_mappings(GPtrArray *activation_array, GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GHashTable *targets_table, const unsigned int flags, service_mapping_function deactivate_mapping_function)
+static int rollback_new_mappings(GPtrArray *activation_array, const ServiceMappingIndex *index, GHashTable *targets_table, const unsigned int flags, service_mapping_function deactivate_mapping_function, const ServiceMappingBatchFunctions *deactivate_batch_functions, BackgroundProcesses *background)
 {
-    mark_erroneous_mappings(unified_service_mapping_array, SERVICE_MAPPING_DEACTIVATED); /* Mark erroneous mappings as deactivated */
-    return traverse_service_mappings(activation_array, unified_service_mapping_array, unified_services_table, targets_table, traverse_interdependent_mappings, deactivate_mapping_function, complete_deactivation);
+    mark_erroneous_mappings(index->unified_service_mapping_array, SERVICE_MAPPING_DEACTIVATED); /* Mark erroneous mappings as deactivated */
+    return traverse_service_mappings(activation_array, index, targets_table, lookup_interdependent_mappings, visit_interdependent_mapping, deactivate_mapping_function, complete_deactivation, background, deactivate_batch_functions);
 }
 
-static TransitionStatus activate_new_mappings(GPtrArray *activation_array, GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GHashTable *targets_table, GPtrArray *old_activation_mappings, const unsigned int flags, service_mapping_function activate_mapping_function, service_mapping_function deactivate_mapping_function)
+static TransitionStatus activate_new_mappings(GPtrArray *activation_array, const ServiceMappingIndex *index, GHashTable *targets_table, GPtrArray *old_activation_mappings, const unsigned int flags, service_mapping_function activate_mapping_function, service_mapping_function deactivate_mapping_function, const ServiceMappingBatchFunctions *activate_batch_functions, const ServiceMappingBatchFunctions *deactivate_batch_functions, BackgroundProcesses *background)
 {
     g_print("[coordinator]: Executing activation of services:\n");
 
-    if(traverse_service_mappings(activation_array, unified_service_mapping_array, unified_services_table, targets_table, traverse_inter_dependency_mappings, activate_mapping_function, complete_activation) && !interrupted)
+    /* The activation only succeeds if all target machines have been prepared, including those without any new mappings */
+    if(traverse_service_mappings(activation_array, index, targets_table, lookup_inter_dependency_mappings, visit_inter_dependency_mapping, activate_mapping_function, complete_activation, background, activate_batch_functions)
+      && (background == NULL || wait_for_background_processes(background, targets_table))
+      && !interrupted)
         return TRANSITION_SUCCESS;
     else
     {
@@ -170,7 +243,7 @@ static TransitionStatus activate_new_mappings(GPtrArray *activation_array, GPtrA
             g_printerr("[coordinator]: Activation failed! Doing a rollback...\n");
 
             /* Roll back the new mappings */
-            if(!rollback_new_mappings(activation_array, unified_service_mapping_array, unified_services_table, targets_table, flags, deactivate_mapping_function))
+            if(!rollback_new_mappings(activation_array, index, targets_table, flags, deactivate_mapping_function, deactivate_batch_functions, background))
             {
                 g_printerr("[coordinator]: New mappings rollback failed!\n\n");
                 return TRANSITION_NEW_MAPPINGS_ROLLBACK_FAILED; /* If the rollback failed, stop and notify the user to take manual action */
@@ -182,7 +255,7 @@ static TransitionStatus activate_new_mappings(GPtrArray *activation_array, GPtrA
             {
                 /* If the new mappings have been rolled backed, roll back to the old mappings */
 
-                if(rollback_to_old_mappings(unified_service_mapping_array, unified_services_table, old_activation_mappings, targets_table, flags, activate_mapping_function))
+                if(rollback_to_old_mappings(index, old_activation_mappings, targets_table, flags, activate_mapping_function, activate_batch_functions, background))
                     return TRANSITION_FAILED;
                 else
                     return TRANSITION_OBSOLETE_MAPPINGS_ROLLBACK_FAILED;
@@ -191,15 +264,17 @@ static TransitionStatus activate_new_mappings(GPtrArray *activation_array, GPtrA
     }
 }
 
-TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags)
+TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, BackgroundProcesses *background)
 {
     GPtrArray *unified_service_mapping_array;
     GPtrArray *deactivation_array;
     GPtrArray *activation_array;
     GHashTable *unified_services_table;
     GPtrArray *previous_service_mapping_array;
+    ServiceMappingIndex *index;
     TransitionStatus status;
     service_mapping_function activate_mapping_function, deactivate_mapping_function;
+    const ServiceMappingBatchFunctions *activate_batch_functions = NULL, *deactivate_batch_functions = NULL;
 
     /* Print configurations */
 
@@ -226,6 +301,9 @@ TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, con
         g_ptr_array_free(intersection_array, TRUE);
     }
 
+    /* Index the inter-dependency relationships in both directions, so that the deactivation and rollback do not have to rescan all mappings */
+    index = create_service_mapping_index(unified_service_mapping_array, unified_services_table);
+
     /* Determine the activation and deactivation mapping functions */
 
     if(flags & FLAG_DRY_RUN)
@@ -237,14 +315,23 @@ TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, con
     {
         activate_mapping_function = activate_mapping;
         deactivate_mapping_function = deactivate_mapping;
+
+        /* Submit the activities of the mappings that are ready on the same machine at once */
+        if(flags & FLAG_BATCH_ACTIVITIES)
+        {
+            activate_batch_functions = &batch_activation_functions;
+            deactivate_batch_functions = &batch_deactivation_functions;
+        }
     }
 
     /* Execute transition steps */
-    if((status = deactivate_obsolete_mappings(deactivation_array, unified_service_mapping_array, unified_services_table, manifest->targets_table, previous_service_mapping_array, flags, activate_mapping_function, deactivate_mapping_function)) == TRANSITION_SUCCESS
-      && (status = activate_new_mappings(activation_array, unified_service_mapping_array, unified_services_table, manifest->targets_table, previous_service_mapping_array, flags, activate_mapping_function, deactivate_mapping_function)) == TRANSITION_SUCCESS)
+    if((status = deactivate_obsolete_mappings(deactivation_array, index, manifest->targets_table, previous_service_mapping_array, flags, activate_mapping_function, deactivate_mapping_function, activate_batch_functions, deactivate_batch_functions, background)) == TRANSITION_SUCCESS
+      && (status = activate_new_mappings(activation_array, index, manifest->targets_table, previous_service_mapping_array, flags, activate_mapping_function, deactivate_mapping_function, activate_batch_functions, deactivate_batch_functions, background)) == TRANSITION_SUCCESS)
         ;
 
     /* Cleanup */
+    delete_service_mapping_index(index);
+
     if(previous_manifest != NULL)
     {
         g_ptr_array_free(deactivation_array, TRUE);
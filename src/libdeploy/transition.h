@@ -21,6 +21,7 @@
 #define __DISNIX_TRANSITION_H
 #include <glib.h>
 #include <manifest.h>
+#include <servicemapping-traverse.h>
 #include "deploymentflags.h"
 
 /**
@@ -43,8 +44,9 @@ TransitionStatus;
  * @param old_activation_mappings Array containing the activation mappings of the old configuration or NULL to activate all services in the new configuration
  * @param targets_table Hash table containing all the targets of the new configuration
  * @param flags Deployment option flags
+ * @param background Background processes that prepare the target machines or NULL if all target machines are ready
  * @return A status value from the transition status enumeration
  */
-TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags);
+TransitionStatus transition(Manifest *manifest, Manifest *previous_manifest, const unsigned int flags, BackgroundProcesses *background);
 
 #endif
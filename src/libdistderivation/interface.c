@@ -18,28 +18,41 @@
  */
 
 #include "interface.h"
+#include <stdlib.h>
 #include <nixxml-parse.h>
 
 static void *create_interface(xmlNodePtr element, void *userdata)
 {
-    return g_malloc0(sizeof(Interface));
+    Interface *interface = g_malloc0(sizeof(Interface));
+    interface->num_of_cores = 1;
+    interface->available_cores = 1;
+    return interface;
 }
 
-static void insert_interface_attributes(void *table, const xmlChar *key, void *value, void *userdata)
+static void parse_and_insert_interface_attributes(xmlNodePtr element, void *table, const xmlChar *key, void *userdata)
 {
     Interface *interface = (Interface*)table;
 
     if(xmlStrcmp(key, (xmlChar*) "targetAddress") == 0)
-        interface->target_address = value;
+        interface->target_address = NixXML_parse_value(element, userdata);
     else if(xmlStrcmp(key, (xmlChar*) "clientInterface") == 0)
-        interface->client_interface = value;
-    else
-        xmlFree(value);
+        interface->client_interface = NixXML_parse_value(element, userdata);
+    else if(xmlStrcmp(key, (xmlChar*) "numOfCores") == 0)
+    {
+        gchar *num_of_cores_str = NixXML_parse_value(element, userdata);
+
+        if(num_of_cores_str != NULL)
+        {
+            interface->num_of_cores = atoi((char*)num_of_cores_str);
+            interface->available_cores = interface->num_of_cores;
+            g_free(num_of_cores_str);
+        }
+    }
 }
 
 void *parse_interface(xmlNodePtr element, void *userdata)
 {
-    return NixXML_parse_simple_attrset(element, userdata, create_interface, NixXML_parse_value, insert_interface_attributes);
+    return NixXML_parse_simple_heterogeneous_attrset(element, userdata, create_interface, parse_and_insert_interface_attributes);
 }
 
 void delete_interface(Interface *interface)
@@ -68,5 +81,27 @@ NixXML_bool check_interface(const Interface *interface)
         status = FALSE;
     }
 
+    if(interface->num_of_cores <= 0)
+    {
+        g_printerr("interface.numOfCores should be greater than 0\n");
+        status = FALSE;
+    }
+
     return status;
 }
+
+NixXML_bool request_available_interface_core(Interface *interface)
+{
+    if(interface->available_cores > 0)
+    {
+        interface->available_cores--;
+        return TRUE;
+    }
+    else
+        return FALSE;
+}
+
+void signal_available_interface_core(Interface *interface)
+{
+    interface->available_cores++;
+}
@@ -23,6 +23,17 @@
 #include <glib.h>
 #include <nixxml-types.h>
 
+/**
+ * @brief Indicates whether the services of a target machine can be (de)activated
+ */
+typedef enum
+{
+    TARGET_READY = 0,
+    TARGET_PENDING,
+    TARGET_UNAVAILABLE
+}
+TargetReadiness;
+
 /**
  * @brief Contains properties of a target machine.
  */
@@ -48,6 +59,9 @@ typedef struct
 
     /* Contains the amount of CPU cores that are currently available */
     int available_cores;
+
+    /* Indicates whether the machine has been prepared for the (de)activation of services */
+    TargetReadiness readiness;
 }
 Target;
 
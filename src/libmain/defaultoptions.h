@@ -21,6 +21,7 @@
 #define __DISNIX_DEFAULTOPTIONS_H
 
 #define DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_TRANSFERS 2
+#define DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_SNAPSHOT_TRANSFERS 1
 #define DISNIX_DEFAULT_KEEP 1
 #define DISNIX_DEFAULT_XML FALSE
 
@@ -62,6 +63,8 @@ typedef enum
     /* Connectivity options */
     DISNIX_OPTION_INTERFACE = 256,
     DISNIX_OPTION_TARGET_PROPERTY = 257,
+    DISNIX_OPTION_MAX_CONCURRENT_BUILDS = 276,
+    DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS = 278,
 
     /* Deployment options */
     DISNIX_OPTION_NO_UPGRADE = 258,
@@ -69,6 +72,8 @@ typedef enum
     DISNIX_OPTION_NO_MIGRATION = 260,
     DISNIX_OPTION_NO_LOCK = 261,
     DISNIX_OPTION_DRY_RUN = 252,
+    DISNIX_OPTION_PIPELINE = 275,
+    DISNIX_OPTION_BATCH_ACTIVITIES = 277,
 
     /* Model options */
     DISNIX_OPTION_XML = 263,
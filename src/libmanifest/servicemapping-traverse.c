@@ -18,211 +18,552 @@
  */
 
 #include "servicemapping-traverse.h"
-#include <sys/types.h>
-#include <sys/wait.h>
 #include "mappingparameters.h"
+#include <errno.h>
 
-GPtrArray *find_interdependent_service_mappings(GHashTable *services_table, const GPtrArray *service_mapping_array, const ServiceMapping *mapping)
+static ServiceStatus execute_service_mapping_operation(ServiceMapping *mapping, GHashTable *services_table, Target *target, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping)
 {
-    GPtrArray *return_array = g_ptr_array_new();
-    unsigned int i;
+    MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, services_table, target);
+    pid_t pid = map_service_mapping(mapping, params.service, target, params.type, params.arguments, params.arguments_size); /* Execute the activation operation asynchronously */
 
-    /* For each service mapping, check whether there is a inter-dependency on the requested mapping */
-    for(i = 0; i < service_mapping_array->len; i++)
-    {
-        ServiceMapping *current_mapping = g_ptr_array_index(service_mapping_array, i);
-        ManifestService *service = g_hash_table_lookup(services_table, current_mapping->service);
-        InterDependencyMapping *found_dependency = find_interdependency_mapping(service->depends_on, (InterDependencyMapping*)mapping);
+    /* Cleanup */
+    destroy_mapping_parameters(&params);
 
-        if(found_dependency != NULL)
-            g_ptr_array_add(return_array, current_mapping);
+    if(pid == -1)
+    {
+        g_printerr("[target: %s]: Cannot fork process for service: %s!\n", mapping->target, mapping->service);
+        signal_available_target_core(target);
+        return SERVICE_ERROR;
+    }
+    else
+    {
+        mapping->status = SERVICE_MAPPING_IN_PROGRESS; /* Mark service mapping as in progress */
+        procreact_add_pid(pid_set, pid, mapping); /* Add mapping to the PID set so that we can retrieve its status later */
+        return SERVICE_IN_PROGRESS;
     }
+}
 
-    return return_array;
+static ServiceStatus attempt_to_map_service_mapping(ServiceMapping *mapping, GHashTable *services_table, Target *target, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping)
+{
+    if(target->readiness == TARGET_PENDING)
+        return SERVICE_WAIT; /* Wait until the machine has been prepared */
+    else if(target->readiness == TARGET_UNAVAILABLE)
+    {
+        g_printerr("[target: %s]: Cannot map service: %s since the machine could not be prepared!\n", mapping->target, mapping->service);
+        return SERVICE_ERROR;
+    }
+    else if(request_available_target_core(target)) /* Check if machine has any cores available, if not wait and try again later */
+    {
+        if(map_service_mapping == NULL)
+            return SERVICE_BATCHED; /* The operation gets executed later as part of a batch */
+        else
+            return execute_service_mapping_operation(mapping, services_table, target, pid_set, map_service_mapping);
+    }
+    else
+        return SERVICE_WAIT;
 }
 
-static ServiceStatus attempt_to_map_service_mapping(ServiceMapping *mapping, GHashTable *services_table, Target *target, GHashTable *pid_table, service_mapping_function map_service_mapping)
+ServiceStatus visit_inter_dependency_mapping(ServiceMapping *mapping, GHashTable *unified_services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping)
 {
-    if(request_available_target_core(target)) /* Check if machine has any cores available, if not wait and try again later */
+    /* Activate the mapping if it is not activated yet */
+    switch(mapping->status)
     {
-        MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, services_table, target);
-        pid_t pid = map_service_mapping(mapping, params.service, target, params.type, params.arguments, params.arguments_size); /* Execute the activation operation asynchronously */
+        case SERVICE_MAPPING_DEACTIVATED:
+            {
+                Target *target = g_hash_table_lookup(targets_table, (gchar*)mapping->target);
+
+                if(target == NULL)
+                {
+                    ManifestService *service = g_hash_table_lookup(unified_services_table, (gchar*)mapping->service);
+                    g_print("[target: %s]: Cannot map service with key: %s deploying service: %s since the machine is not present!\n", mapping->service, mapping->target, service->pkg);
+                    return SERVICE_ERROR;
+                }
+                else
+                    return attempt_to_map_service_mapping(mapping, unified_services_table, target, pid_set, map_service_mapping);
+            }
+        case SERVICE_MAPPING_ACTIVATED:
+            return SERVICE_DONE;
+        case SERVICE_MAPPING_IN_PROGRESS:
+            return SERVICE_IN_PROGRESS;
+        default:
+            return SERVICE_ERROR;
+    }
+}
 
-        /* Cleanup */
-        destroy_mapping_parameters(&params);
+ServiceStatus visit_interdependent_mapping(ServiceMapping *mapping, GHashTable *unified_services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping)
+{
+    /* Deactivate the mapping if it has not been deactivated yet */
+    switch(mapping->status)
+    {
+        case SERVICE_MAPPING_ACTIVATED:
+            {
+                Target *target = g_hash_table_lookup(targets_table, (gchar*)mapping->target);
 
-        if(pid == -1)
-        {
-            g_printerr("[target: %s]: Cannot fork process for service: %s!\n", mapping->target, mapping->service);
+                if(target == NULL)
+                {
+                    ManifestService *service = g_hash_table_lookup(unified_services_table, (gchar*)mapping->service);
+                    g_print("[target: %s]: Skip service with key: %s deploying service: %s since machine is no longer present!\n", mapping->target, mapping->service, service->pkg);
+                    mapping->status = SERVICE_MAPPING_DEACTIVATED;
+                    return SERVICE_DONE;
+                }
+                else
+                    return attempt_to_map_service_mapping(mapping, unified_services_table, target, pid_set, map_service_mapping);
+            }
+        case SERVICE_MAPPING_DEACTIVATED:
+            return SERVICE_DONE;
+        case SERVICE_MAPPING_IN_PROGRESS:
+            return SERVICE_IN_PROGRESS;
+        default:
             return SERVICE_ERROR;
-        }
-        else
+    }
+}
+
+/**
+ * @brief Captures the scheduling state of a service mapping in the dependency graph
+ */
+typedef struct
+{
+    /** Service mapping to visit */
+    ServiceMapping *mapping;
+    /** Amount of prerequisites that have not been visited yet */
+    unsigned int num_of_pending_prerequisites;
+    /** Nodes that must wait for this node to be visited */
+    GPtrArray *dependants;
+    /** Indicates whether the node or any of its prerequisites failed */
+    ProcReact_bool failed;
+}
+ServiceMappingNode;
+
+static void delete_service_mapping_node(ServiceMappingNode *node)
+{
+    g_ptr_array_free(node->dependants, TRUE);
+    g_free(node);
+}
+
+static ServiceMappingNode *lookup_or_create_service_mapping_node(GHashTable *nodes_table, ServiceMapping *mapping, GPtrArray *unvisited_nodes)
+{
+    ServiceMappingNode *node = g_hash_table_lookup(nodes_table, mapping);
+
+    if(node == NULL)
+    {
+        node = g_malloc(sizeof(ServiceMappingNode));
+        node->mapping = mapping;
+        node->num_of_pending_prerequisites = 0;
+        node->dependants = g_ptr_array_new();
+        node->failed = FALSE;
+
+        g_hash_table_insert(nodes_table, mapping, node);
+        g_ptr_array_add(unvisited_nodes, node);
+    }
+
+    return node;
+}
+
+static GHashTable *generate_service_mapping_graph(GPtrArray *service_mapping_array, const ServiceMappingIndex *index, query_prerequisite_mappings_function query_prerequisite_mappings)
+{
+    GHashTable *nodes_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)delete_service_mapping_node);
+    GPtrArray *unvisited_nodes = g_ptr_array_new();
+    unsigned int i;
+
+    /* Create nodes for the mappings that must be visited */
+    for(i = 0; i < service_mapping_array->len; i++)
+    {
+        ServiceMapping *mapping = g_ptr_array_index(service_mapping_array, i);
+        ServiceMapping *actual_mapping = find_service_mapping(index->unified_service_mapping_array, (InterDependencyMapping*)mapping); /* Retrieve the mapping from the union array */
+        lookup_or_create_service_mapping_node(nodes_table, actual_mapping, unvisited_nodes);
+    }
+
+    /* Transitively add the prerequisites of each node and connect them with edges */
+    while(unvisited_nodes->len > 0)
+    {
+        ServiceMappingNode *node = g_ptr_array_remove_index_fast(unvisited_nodes, unvisited_nodes->len - 1);
+        const GPtrArray *prerequisite_mappings = query_prerequisite_mappings(index, node->mapping);
+
+        if(prerequisite_mappings != NULL)
         {
-            gint *pid_ptr = g_malloc(sizeof(gint));
-            *pid_ptr = pid;
+            for(i = 0; i < prerequisite_mappings->len; i++)
+            {
+                ServiceMapping *prerequisite_mapping = g_ptr_array_index(prerequisite_mappings, i);
+                ServiceMappingNode *prerequisite_node = lookup_or_create_service_mapping_node(nodes_table, prerequisite_mapping, unvisited_nodes);
 
-            mapping->status = SERVICE_MAPPING_IN_PROGRESS; /* Mark service mapping as in progress */
-            g_hash_table_insert(pid_table, pid_ptr, mapping); /* Add mapping to the pids table so that we can retrieve its status later */
-            return SERVICE_IN_PROGRESS;
+                g_ptr_array_add(prerequisite_node->dependants, node);
+                node->num_of_pending_prerequisites++;
+            }
         }
     }
-    else
-        return SERVICE_WAIT;
+
+    g_ptr_array_free(unvisited_nodes, TRUE);
+    return nodes_table;
+}
+
+static GQueue *lookup_or_create_waiting_queue(GHashTable *waiting_queues_table, const xmlChar *target_name)
+{
+    GQueue *waiting_queue = g_hash_table_lookup(waiting_queues_table, target_name);
+
+    if(waiting_queue == NULL)
+    {
+        waiting_queue = g_queue_new();
+        g_hash_table_insert(waiting_queues_table, (gchar*)target_name, waiting_queue);
+    }
+
+    return waiting_queue;
 }
 
-static void wait_for_service_mapping_to_complete(GHashTable *pid_table, GHashTable *services_table, GHashTable *targets_table, complete_service_mapping_function complete_service_mapping)
+static unsigned int mark_service_mapping_node_failed(ServiceMappingNode *node)
 {
-    int wstatus;
+    unsigned int i, num_failed = 1;
 
-    /* Wait for an activation/deactivation process to finish */
-    pid_t pid = wait(&wstatus);
+    node->failed = TRUE;
 
-    if(pid > 0)
+    /* Dependants can never be visited anymore */
+    for(i = 0; i < node->dependants->len; i++)
     {
-        /* Find the corresponding service mapping and remove it from the pids table */
-        ProcReact_Status status;
-        int result = procreact_retrieve_boolean(pid, wstatus, &status);
-        ServiceMapping *mapping = g_hash_table_lookup(pid_table, &pid);
-        ManifestService *service = g_hash_table_lookup(services_table, (gchar*)mapping->service);
-        Target *target = g_hash_table_lookup(targets_table, (gchar*)mapping->target);
-        g_hash_table_remove(pid_table, &pid);
+        ServiceMappingNode *dependant = g_ptr_array_index(node->dependants, i);
 
-        /* Complete the service mapping */
-        complete_service_mapping(mapping, service, target, status, result);
+        if(!dependant->failed)
+            num_failed += mark_service_mapping_node_failed(dependant);
+    }
 
-        /* Signal the target to make the CPU core available again */
-        target = g_hash_table_lookup(targets_table, (gchar*)mapping->target);
-        signal_available_target_core(target);
+    return num_failed;
+}
+
+static void release_dependants(ServiceMappingNode *node, GQueue *ready_queue)
+{
+    unsigned int i;
+
+    for(i = 0; i < node->dependants->len; i++)
+    {
+        ServiceMappingNode *dependant = g_ptr_array_index(node->dependants, i);
+
+        dependant->num_of_pending_prerequisites--;
+
+        if(dependant->num_of_pending_prerequisites == 0 && !dependant->failed)
+            g_queue_push_tail(ready_queue, dependant);
+    }
+}
+
+static void complete_service_mapping_operation(ServiceMapping *mapping, ProcReact_Status status, ProcReact_bool result, GHashTable *services_table, Target *target, complete_service_mapping_function complete_service_mapping)
+{
+    ManifestService *service = g_hash_table_lookup(services_table, (gchar*)mapping->service);
+
+    /* Complete the service mapping */
+    complete_service_mapping(mapping, service, target, status, result);
+
+    /* Signal the target to make the CPU core available again */
+    signal_available_target_core(target);
+}
+
+static ServiceMappingNode *complete_service_mapping_node(ServiceMappingNode *node, pid_t pid, int wstatus, GHashTable *services_table, GHashTable *targets_table, complete_service_mapping_function complete_service_mapping)
+{
+    ProcReact_Status status;
+    int result = procreact_retrieve_boolean(pid, wstatus, &status);
+    Target *target = g_hash_table_lookup(targets_table, (gchar*)node->mapping->target);
+
+    complete_service_mapping_operation(node->mapping, status, result, services_table, target, complete_service_mapping);
+    return node;
+}
+
+static ServiceMappingBatch *create_service_mapping_batch(GPtrArray *nodes, GHashTable *services_table, Target *target)
+{
+    unsigned int i;
+    ServiceMappingBatch *batch = (ServiceMappingBatch*)g_malloc(sizeof(ServiceMappingBatch));
+
+    batch->target = target;
+    batch->mappings = g_ptr_array_sized_new(nodes->len);
+    batch->parameters = g_array_sized_new(FALSE, FALSE, sizeof(MappingParameters), nodes->len);
+    batch->data = NULL;
+
+    for(i = 0; i < nodes->len; i++)
+    {
+        ServiceMappingNode *node = g_ptr_array_index(nodes, i);
+        ServiceMapping *mapping = node->mapping;
+        MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, services_table, target);
+
+        g_ptr_array_add(batch->mappings, mapping);
+        g_array_append_val(batch->parameters, params);
     }
+
+    return batch;
 }
 
-ServiceStatus traverse_inter_dependency_mappings(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, const InterDependencyMapping *key, GHashTable *targets_table, GHashTable *pid_table, service_mapping_function map_service_mapping)
+static void delete_service_mapping_batch(ServiceMappingBatch *batch)
 {
-    /* Retrieve the mapping from the union array */
-    ServiceMapping *actual_mapping = find_service_mapping(unified_service_mapping_array, key);
+    unsigned int i;
+
+    for(i = 0; i < batch->parameters->len; i++)
+        destroy_mapping_parameters(&g_array_index(batch->parameters, MappingParameters, i));
 
-    ManifestService *service = g_hash_table_lookup(unified_services_table, actual_mapping->service);
+    g_array_free(batch->parameters, TRUE);
+    g_ptr_array_free(batch->mappings, TRUE);
+    g_free(batch);
+}
 
-    /* First, activate all inter-dependency mappings */
-    if(service->depends_on != NULL)
+static void add_to_pending_batch(GHashTable *pending_batches_table, ServiceMappingNode *node)
+{
+    GPtrArray *nodes = g_hash_table_lookup(pending_batches_table, node->mapping->target);
+
+    if(nodes == NULL)
     {
-        unsigned int i;
+        nodes = g_ptr_array_new();
+        g_hash_table_insert(pending_batches_table, (gchar*)node->mapping->target, nodes);
+    }
+
+    g_ptr_array_add(nodes, node);
+}
+
+static unsigned int execute_pending_batches(GHashTable *pending_batches_table, GHashTable *batches_table, GHashTable *services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping, const ServiceMappingBatchFunctions *batch_functions, unsigned int *num_done, ProcReact_bool *success)
+{
+    unsigned int num_started = 0;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&iter, pending_batches_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+        GPtrArray *nodes = (GPtrArray*)value;
+        Target *target = g_hash_table_lookup(targets_table, (gchar*)key);
         ServiceStatus status;
 
-        for(i = 0; i < service->depends_on->len; i++)
+        if(nodes->len == 1)
+            status = execute_service_mapping_operation(((ServiceMappingNode*)g_ptr_array_index(nodes, 0))->mapping, services_table, target, pid_set, map_service_mapping); /* A batch of one is not worth it */
+        else
+        {
+            ServiceMappingBatch *batch = create_service_mapping_batch(nodes, services_table, target);
+            pid_t pid = batch_functions->map_service_mappings(batch);
+
+            if(pid == -1)
+            {
+                unsigned int i;
+
+                g_printerr("[target: %s]: Cannot fork process for a batch of %u services!\n", (gchar*)key, nodes->len);
+
+                for(i = 0; i < nodes->len; i++)
+                    signal_available_target_core(target);
+
+                delete_service_mapping_batch(batch);
+                status = SERVICE_ERROR;
+            }
+            else
+            {
+                unsigned int i;
+
+                for(i = 0; i < batch->mappings->len; i++)
+                    ((ServiceMapping*)g_ptr_array_index(batch->mappings, i))->status = SERVICE_MAPPING_IN_PROGRESS;
+
+                procreact_add_pid(pid_set, pid, batch);
+                g_hash_table_add(batches_table, batch);
+                status = SERVICE_IN_PROGRESS;
+            }
+        }
+
+        if(status == SERVICE_IN_PROGRESS)
+            num_started++;
+        else
         {
-            InterDependencyMapping *dependency_mapping = g_ptr_array_index(service->depends_on, i);
-            status = traverse_inter_dependency_mappings(unified_service_mapping_array, unified_services_table, dependency_mapping, targets_table, pid_table, map_service_mapping);
+            unsigned int i;
 
-            if(status != SERVICE_DONE)
-                return status; /* If any of the inter-dependencies has not been activated yet, relay its status */
+            *success = FALSE;
+
+            for(i = 0; i < nodes->len; i++)
+                *num_done += mark_service_mapping_node_failed(g_ptr_array_index(nodes, i));
         }
     }
 
-    /* Finally, activate the mapping itself if it is not activated yet */
-    switch(actual_mapping->status)
+    g_hash_table_remove_all(pending_batches_table);
+    return num_started;
+}
+
+static void complete_service_mapping_batch(ServiceMappingBatch *batch, pid_t pid, int wstatus, GHashTable *services_table, GHashTable *nodes_table, complete_service_mapping_function complete_service_mapping, const ServiceMappingBatchFunctions *batch_functions, GQueue *ready_queue)
+{
+    ProcReact_Status status;
+    ProcReact_bool result = procreact_retrieve_boolean(pid, wstatus, &status);
+    ProcReact_bool *results = batch_functions->complete_service_mappings(batch, status, result);
+    unsigned int i;
+
+    for(i = 0; i < batch->mappings->len; i++)
     {
-        case SERVICE_MAPPING_DEACTIVATED:
-            {
-                Target *target = g_hash_table_lookup(targets_table, (gchar*)actual_mapping->target);
+        ServiceMapping *mapping = g_ptr_array_index(batch->mappings, i);
 
-                if(target == NULL)
-                {
-                    g_print("[target: %s]: Cannot map service with key: %s deploying service: %s since the machine is not present!\n", actual_mapping->service, actual_mapping->target, service->pkg);
-                    return SERVICE_ERROR;
-                }
-                else
-                    return attempt_to_map_service_mapping(actual_mapping, unified_services_table, target, pid_table, map_service_mapping);
-            }
-        case SERVICE_MAPPING_ACTIVATED:
-            return SERVICE_DONE;
-        case SERVICE_MAPPING_IN_PROGRESS:
-            return SERVICE_IN_PROGRESS;
-        default:
-            return SERVICE_ERROR; /* Should never happen */
+        /* An operation that reported its outcome has completed, even if the batch process terminated abnormally afterwards */
+        complete_service_mapping_operation(mapping, results[i] ? PROCREACT_STATUS_OK : status, results[i], services_table, batch->target, complete_service_mapping);
+        g_queue_push_tail(ready_queue, g_hash_table_lookup(nodes_table, mapping)); /* Revisit the node to determine the outcome of the operation */
     }
+
+    g_free(results);
 }
 
-ServiceStatus traverse_interdependent_mappings(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, const InterDependencyMapping *key, GHashTable *targets_table, GHashTable *pid_table, service_mapping_function map_service_mapping)
+static unsigned int release_waiting_nodes(GQueue *waiting_queue, GQueue *ready_queue, unsigned int max_num_of_nodes)
 {
-    /* Retrieve the mapping from the union array */
-    ServiceMapping *actual_mapping = find_service_mapping(unified_service_mapping_array, key);
+    unsigned int num_released = 0;
+    ServiceMappingNode *waiting_node;
 
-    /* Find all interdependent mapping on this mapping */
-    GPtrArray *interdependent_mappings = find_interdependent_service_mappings(unified_services_table, unified_service_mapping_array, actual_mapping);
+    while(num_released < max_num_of_nodes && waiting_queue != NULL && (waiting_node = g_queue_pop_head(waiting_queue)) != NULL)
+    {
+        g_queue_push_tail(ready_queue, waiting_node);
+        num_released++;
+    }
 
-    /* First deactivate all mappings which have an inter-dependency on this mapping */
-    unsigned int i;
+    return num_released;
+}
 
-    for(i = 0; i < interdependent_mappings->len; i++)
+ProcReact_bool wait_for_background_processes(BackgroundProcesses *background, GHashTable *targets_table)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    while(background->pid_set.length > 0)
     {
-        ServiceMapping *dependency_mapping = g_ptr_array_index(interdependent_mappings, i);
-        ServiceStatus status = traverse_interdependent_mappings(unified_service_mapping_array, unified_services_table, (InterDependencyMapping*)dependency_mapping, targets_table, pid_table, map_service_mapping);
+        int wstatus;
+        void *process_data;
+        pid_t pid = procreact_wait_for_pid_in_set(&background->pid_set, &wstatus, &process_data);
 
-        if(status != SERVICE_DONE)
-        {
-            g_ptr_array_free(interdependent_mappings, TRUE);
-            return status; /* If any inter-dependency is not deactivated, relay its status */
-        }
+        if(process_data != NULL) /* A process that could not be waited for is completed as a failure */
+            background->complete_background_process(background->data, pid, wstatus, process_data);
     }
 
-    g_ptr_array_free(interdependent_mappings, TRUE);
-
-    /* Finally deactivate the mapping itself if it has not been deactivated yet */
-    switch(actual_mapping->status)
+    /* Check whether all target machines have been successfully prepared */
+    g_hash_table_iter_init(&iter, targets_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
     {
-        case SERVICE_MAPPING_ACTIVATED:
-            {
-                Target *target = g_hash_table_lookup(targets_table, (gchar*)actual_mapping->target);
-                ManifestService *service = g_hash_table_lookup(unified_services_table, (gchar*)actual_mapping->service);
+        Target *target = (Target*)value;
 
-                if(target == NULL)
-                {
-                    g_print("[target: %s]: Skip service with key: %s deploying service: %s since machine is no longer present!\n", actual_mapping->target, actual_mapping->service, service->pkg);
-                    actual_mapping->status = SERVICE_MAPPING_DEACTIVATED;
-                    return SERVICE_DONE;
-                }
-                else
-                    return attempt_to_map_service_mapping(actual_mapping, unified_services_table, target, pid_table, map_service_mapping);
-            }
-        case SERVICE_MAPPING_DEACTIVATED:
-            return SERVICE_DONE;
-        case SERVICE_MAPPING_IN_PROGRESS:
-            return SERVICE_IN_PROGRESS;
-        default:
-            return SERVICE_ERROR; /* Should never happen */
+        if(target->readiness != TARGET_READY)
+            return FALSE;
     }
+
+    return TRUE;
 }
 
-ProcReact_bool traverse_service_mappings(GPtrArray *service_mapping_array, GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GHashTable *targets_table, iterate_strategy_function iterate_strategy, service_mapping_function map_service_mapping, complete_service_mapping_function complete_service_mapping)
+ProcReact_bool traverse_service_mappings(GPtrArray *service_mapping_array, const ServiceMappingIndex *index, GHashTable *targets_table, query_prerequisite_mappings_function query_prerequisite_mappings, visit_mapping_function visit_mapping, service_mapping_function map_service_mapping, complete_service_mapping_function complete_service_mapping, BackgroundProcesses *background, const ServiceMappingBatchFunctions *batch_functions)
 {
-    GHashTable *pid_table = g_hash_table_new_full(g_int_hash, g_int_equal, g_free, NULL);
-    unsigned int num_done = 0;
-    int success = TRUE;
+    ProcReact_PidSet own_pid_set = procreact_initialize_pid_set();
+    ProcReact_PidSet *pid_set = (background == NULL) ? &own_pid_set : &background->pid_set; /* Share the PID set with the background processes, so that we can wait for both */
+    GHashTable *nodes_table = generate_service_mapping_graph(service_mapping_array, index, query_prerequisite_mappings);
+    GHashTable *waiting_queues_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_queue_free);
+    GHashTable *pending_batches_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+    GHashTable *batches_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GQueue *ready_queue = g_queue_new();
+    unsigned int num_of_nodes = g_hash_table_size(nodes_table);
+    unsigned int num_done = 0, num_in_progress = 0, num_waiting = 0;
+    ProcReact_bool success = TRUE;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    /* Nodes without any prerequisites can be visited right away */
+    g_hash_table_iter_init(&iter, nodes_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+        ServiceMappingNode *node = (ServiceMappingNode*)value;
 
-    do
+        if(node->num_of_pending_prerequisites == 0)
+            g_queue_push_tail(ready_queue, node);
+    }
+
+    while(TRUE)
     {
-        unsigned int i;
-        num_done = 0;
+        ServiceMappingNode *node;
+        int wstatus;
+        void *process_data;
+        pid_t pid;
 
-        for(i = 0; i < service_mapping_array->len; i++)
+        /* Visit all nodes that are ready */
+        while((node = g_queue_pop_head(ready_queue)) != NULL)
         {
-            ServiceMapping *mapping = g_ptr_array_index(service_mapping_array, i);
-            ServiceStatus status = iterate_strategy(unified_service_mapping_array, unified_services_table, (InterDependencyMapping*)mapping, targets_table, pid_table, map_service_mapping);
+            switch(visit_mapping(node->mapping, index->unified_services_table, targets_table, pid_set, (batch_functions == NULL) ? map_service_mapping : NULL))
+            {
+                case SERVICE_DONE:
+                    num_done++;
+                    release_dependants(node, ready_queue);
+                    break;
+                case SERVICE_IN_PROGRESS:
+                    num_in_progress++;
+                    break;
+                case SERVICE_WAIT:
+                    g_queue_push_tail(lookup_or_create_waiting_queue(waiting_queues_table, node->mapping->target), node); /* Retry when the target has a CPU core available again or has been prepared */
+                    num_waiting++;
+                    break;
+                case SERVICE_BATCHED:
+                    add_to_pending_batch(pending_batches_table, node);
+                    break;
+                default:
+                    success = FALSE;
+                    num_done += mark_service_mapping_node_failed(node);
+                    break;
+            }
+        }
+
+        /* Execute the operations of all mappings that have become ready, with one process per target machine */
+        num_in_progress += execute_pending_batches(pending_batches_table, batches_table, index->unified_services_table, targets_table, pid_set, map_service_mapping, batch_functions, &num_done, &success);
+
+        /* Stop if nothing is in progress, unless there are nodes waiting for a target that is being prepared */
+        if(num_in_progress == 0 && (num_waiting == 0 || background == NULL || background->pid_set.length == 0))
+            break;
 
-            if(status == SERVICE_ERROR)
+        /* Wait for an operation to complete and only release the nodes that it unblocks */
+        pid = procreact_wait_for_pid_in_set(pid_set, &wstatus, &process_data);
+
+        /*
+         * If the wait for a process failed, it has been removed from the set
+         * and is completed as a failure below. If no process is left to wait
+         * for, we would never make progress again.
+         */
+        if(process_data == NULL)
+        {
+            if(pid == -1 && errno == ECHILD && pid_set->length == 0)
             {
+                g_printerr("[coordinator]: Lost track of the processes of the operations in progress!\n");
                 success = FALSE;
-                num_done++;
+                break;
             }
-            else if(status == SERVICE_DONE)
-                num_done++;
+            else
+                continue;
+        }
+        else if((node = g_hash_table_lookup(nodes_table, process_data)) != NULL)
+        {
+            complete_service_mapping_node(node, pid, wstatus, index->unified_services_table, targets_table, complete_service_mapping);
+            num_in_progress--;
+            g_queue_push_tail(ready_queue, node); /* Revisit the node to determine the outcome of the operation */
 
-            wait_for_service_mapping_to_complete(pid_table, unified_services_table, targets_table, complete_service_mapping);
+            /* The target has a CPU core available again, so the first waiting node can be retried */
+            num_waiting -= release_waiting_nodes(g_hash_table_lookup(waiting_queues_table, node->mapping->target), ready_queue, 1);
         }
+        else if(g_hash_table_contains(batches_table, process_data))
+        {
+            ServiceMappingBatch *batch = (ServiceMappingBatch*)process_data;
+            ServiceMapping *first_mapping = g_ptr_array_index(batch->mappings, 0);
+
+            complete_service_mapping_batch(batch, pid, wstatus, index->unified_services_table, nodes_table, complete_service_mapping, batch_functions, ready_queue);
+            num_in_progress--;
+
+            /* The target has a CPU core available again for each operation in the batch */
+            num_waiting -= release_waiting_nodes(g_hash_table_lookup(waiting_queues_table, first_mapping->target), ready_queue, batch->mappings->len);
+
+            g_hash_table_remove(batches_table, batch);
+            delete_service_mapping_batch(batch);
+        }
+        else if(background != NULL)
+        {
+            /* A background process has completed. If it changed the readiness of a target, all its waiting nodes can be retried */
+            const gchar *target_name = background->complete_background_process(background->data, pid, wstatus, process_data);
+
+            if(target_name != NULL)
+                num_waiting -= release_waiting_nodes(g_hash_table_lookup(waiting_queues_table, target_name), ready_queue, G_MAXUINT);
+        }
+    }
+
+    if(num_done < num_of_nodes)
+    {
+        g_printerr("[coordinator]: Cannot visit all service mappings. Do they have a cyclic inter-dependency relationship?\n");
+        success = FALSE;
     }
-    while(num_done < service_mapping_array->len);
 
-    g_hash_table_destroy(pid_table);
+    /* Cleanup */
+    g_queue_free(ready_queue);
+    g_hash_table_destroy(waiting_queues_table);
+    g_hash_table_destroy(pending_batches_table);
+    g_hash_table_destroy(batches_table);
+    g_hash_table_destroy(nodes_table);
+    procreact_destroy_pid_set(&own_pid_set);
+
     return success;
 }
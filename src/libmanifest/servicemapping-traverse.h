@@ -20,10 +20,13 @@
 #ifndef __DISNIX_SERVICEMAPPING_TRAVERSE_H
 #define __DISNIX_SERVICEMAPPING_TRAVERSE_H
 #include <glib.h>
+#include <procreact_pid_set.h>
 #include <targetstable.h>
 #include "manifestservicestable.h"
 #include "servicemappingarray.h"
 #include "interdependencymappingarray.h"
+#include "servicemappingindex.h"
+#include "mappingparameters.h"
 
 /**
  * @brief Enumerates the possible outcomes of an operation on a service mapping
@@ -33,7 +36,8 @@ typedef enum
     SERVICE_ERROR,
     SERVICE_IN_PROGRESS,
     SERVICE_WAIT,
-    SERVICE_DONE
+    SERVICE_DONE,
+    SERVICE_BATCHED
 }
 ServiceStatus;
 
@@ -64,61 +68,138 @@ typedef pid_t (*service_mapping_function) (ServiceMapping *mapping, ManifestServ
 typedef void (*complete_service_mapping_function) (ServiceMapping *mapping, ManifestService *service, Target *target, ProcReact_Status status, ProcReact_bool result);
 
 /**
- * Pointer to a function that traverses the collection of service mappings
- * according to some strategy.
+ * @brief A batch of operations on service mappings that are deployed to the same target machine
+ */
+typedef struct
+{
+    /** The properties of the target machine where the services are mapped to */
+    Target *target;
+    /** Array of service mappings to change the state for */
+    GPtrArray *mappings;
+    /** Array of MappingParameters with the properties of each service mapping */
+    GArray *parameters;
+    /** Arbitrary data that a batch function needs to retrieve the outcomes of the operations */
+    void *data;
+}
+ServiceMappingBatch;
+
+/**
+ * Pointer to a function that executes operations modifying the state of
+ * multiple service mappings on the same target machine with a single process.
  *
- * @param unified_service_mapping_array An array of service mappings that exist in the previous and current configuration
+ * @param batch A batch of service mappings to change the state for
+ * @return The PID of the process invoked
+ */
+typedef pid_t (*service_mapping_batch_function) (ServiceMappingBatch *batch);
+
+/**
+ * Pointer to a function that retrieves the outcomes of the operations in a
+ * batch, after its process has completed.
+ *
+ * @param batch A batch of service mappings
+ * @param status Indicates whether the process terminated abnormally or not
+ * @param result TRUE if all operations succeeded, else FALSE
+ * @return An array with the outcome of each operation in the batch that should be freed with g_free()
+ */
+typedef ProcReact_bool *(*complete_service_mapping_batch_function) (ServiceMappingBatch *batch, ProcReact_Status status, ProcReact_bool result);
+
+/**
+ * @brief Functions that execute the operations of multiple ready service mappings on the same target machine at once
+ */
+typedef struct
+{
+    /** Pointer to a function that starts a batch of operations */
+    service_mapping_batch_function map_service_mappings;
+    /** Pointer to a function that retrieves the outcomes of a batch of operations */
+    complete_service_mapping_batch_function complete_service_mappings;
+}
+ServiceMappingBatchFunctions;
+
+/**
+ * Pointer to a function that looks up the service mappings that must have been
+ * visited before the given mapping can be visited, according to some
+ * traversal strategy.
+ *
+ * @param index An index of the inter-dependency relationships between the unified service mappings
+ * @param mapping Service mapping to look up the prerequisites for
+ * @return Array of prerequisite service mappings or NULL if there are none. The array is owned by the index.
+ */
+typedef const GPtrArray *(*query_prerequisite_mappings_function) (const ServiceMappingIndex *index, const ServiceMapping *mapping);
+
+/**
+ * Pointer to a function that visits a service mapping of which all
+ * prerequisites have been visited. It executes an operation on the mapping
+ * if its state needs to be changed or reports its current status.
+ *
+ * @param mapping Service mapping to visit
  * @param unified_services_table A hash table of services that exist in the previous and current configuration
- * @param key The key values of a service mapping to visit
  * @param targets_table A hash table of targets
- * @param pid_table Hash table translating PIDs to service mappings
- * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping
+ * @param pid_set Set of processes spawned by the traversal, associating each PID with its service mapping
+ * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping, or NULL to reserve a CPU core for the operation and return SERVICE_BATCHED, so that it can be executed as part of a batch
  * @return Any of the activation status codes
  */
-typedef ServiceStatus (*iterate_strategy_function) (GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, const InterDependencyMapping *key, GHashTable *targets_table, GHashTable *pid_table, service_mapping_function map_service_mapping);
+typedef ServiceStatus (*visit_mapping_function) (ServiceMapping *mapping, GHashTable *unified_services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping);
+
+/**
+ * Pointer to a function that gets executed when a background process that
+ * runs alongside a traversal completes.
+ *
+ * @param data Arbitrary data structure
+ * @param pid PID of the process that has completed
+ * @param wstatus Wait status of the process
+ * @param process_data Arbitrary data associated with the process in the PID set
+ * @return The name of the target machine whose readiness has changed, or NULL if it has not changed
+ */
+typedef const gchar *(*complete_background_process_function) (void *data, pid_t pid, int wstatus, void *process_data);
+
+/**
+ * @brief Processes that run alongside service mapping traversals and control the readiness of the target machines
+ */
+typedef struct
+{
+    /** Set of background processes. Traversals add their own processes to this set as well */
+    ProcReact_PidSet pid_set;
+    /** Pointer to a function that gets executed when a background process completes */
+    complete_background_process_function complete_background_process;
+    /** Arbitrary data passed to the above function */
+    void *data;
+}
+BackgroundProcesses;
 
 /**
- * Searches for all the mappings in an array that have an inter-dependency
- * on the given mapping.
+ * Waits for all remaining background processes to complete.
  *
- * @param services_table Hash table with services
- * @param service_mapping_array Array of service mappings
- * @param mapping service mapping from which to derive the interdependent mapping
- * @return Array with interdependent service mappings
+ * @param background Background processes that run alongside traversals
+ * @param targets_table A hash table of targets
+ * @return TRUE if all target machines are ready, else FALSE
  */
-GPtrArray *find_interdependent_service_mappings(GHashTable *services_table, const GPtrArray *service_mapping_array, const ServiceMapping *mapping);
+ProcReact_bool wait_for_background_processes(BackgroundProcesses *background, GHashTable *targets_table);
 
 /**
- * Traverses a collection of service mappings by recursively visiting the
- * inter-dependencies first and then the service mapping with the provided
- * key. This strategy is, for example, useful to reliably activate services
- * without breaking dependencies.
+ * Visits a service mapping of which all inter-dependencies have been visited
+ * and activates it, if it has not been activated yet.
  *
- * @param unified_service_mapping_array An array of service mappings that exist in the previous and current configuration
+ * @param mapping Service mapping to visit
  * @param unified_services_table A hash table of services that exist in the previous and current configuration
- * @param key The key values of a service mapping to visit
  * @param targets_table An hash table of targets
- * @param pid_table Hash table translating PIDs to service mappings
- * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping
+ * @param pid_set Set of processes spawned by the traversal, associating each PID with its service mapping
+ * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping, or NULL to only reserve a CPU core for a batched operation
  * @return Any of the activation status codes
  */
-ServiceStatus traverse_inter_dependency_mappings(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, const InterDependencyMapping *key, GHashTable *targets_table, GHashTable *pid_table, service_mapping_function map_service_mapping);
+ServiceStatus visit_inter_dependency_mapping(ServiceMapping *mapping, GHashTable *unified_services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping);
 
 /**
- * Traverses a collection of services mappings by recursively visting the
- * inter-dependent mappings first (reverse dependencies) and then the activation
- * with the provided key. This strategy is, for example, useful to reliably
- * deactivate services without breaking dependencies.
+ * Visits a service mapping of which all interdependent mappings have been
+ * visited and deactivates it, if it has not been deactivated yet.
  *
- * @param unified_service_mapping_array An array of service mappings that exist in the previous and current configuration
+ * @param mapping Service mapping to visit
  * @param unified_services_table A hash table of services that exist in the previous and current configuration
- * @param key The key values of a service mapping to visit
  * @param targets_table A hash table of targets
- * @param pid_table Hash table translating PIDs to service mappings
- * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping
+ * @param pid_set Set of processes spawned by the traversal, associating each PID with its service mapping
+ * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping, or NULL to only reserve a CPU core for a batched operation
  * @return Any of the activation status codes
  */
-ServiceStatus traverse_interdependent_mappings(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, const InterDependencyMapping *key, GHashTable *targets_table, GHashTable *pid_table, service_mapping_function map_service_mapping);
+ServiceStatus visit_interdependent_mapping(ServiceMapping *mapping, GHashTable *unified_services_table, GHashTable *targets_table, ProcReact_PidSet *pid_set, service_mapping_function map_service_mapping);
 
 /**
  * Traverses the provided service mappings according to some strategy,
@@ -126,15 +207,31 @@ ServiceStatus traverse_interdependent_mappings(GPtrArray *unified_service_mappin
  * that has not yet been executed. Furthermore, it also limits the amount of
  * operations executed concurrently to a specified amount per machine.
  *
+ * The dependency graph of the mappings is constructed only once. Every
+ * mapping keeps track of the amount of prerequisites that have not been
+ * visited yet and becomes ready when that amount drops to zero. The completion
+ * of an operation only releases the mappings that it unblocks.
+ *
+ * Mappings of which the target machine is not ready yet are postponed until
+ * a background process changes the machine's readiness. Background processes
+ * that are still running when the traversal completes are left alone.
+ *
+ * When batch functions are provided, the operations of all mappings that
+ * become ready at the same time on the same target machine are executed by a
+ * single process, saving a round trip per mapping. Each operation in a batch
+ * still occupies a CPU core of the target machine.
+ *
  * @param service_mapping_array An array of service mappings whose state needs to be changed.
- * @param unified_service_mapping_array An array of service mappings that exist in the previous and current configuration
- * @param unified_services_table A hash table of services that exist in the previous and current configuration
+ * @param index An index of the inter-dependency relationships between the unified service mappings
  * @param targets_table A hash table of targets
- * @param iterate_strategy Pointer to a function that traverses the service mappings according to some strategy
+ * @param query_prerequisite_mappings Pointer to a function that determines which mappings must be visited first
+ * @param visit_mapping Pointer to a function that visits a mapping of which all prerequisites have been visited
  * @param map_service_mapping Pointer to a function that executes an operation modifying the deployment state of a service mapping
  * @param complete_service_mapping Pointer to function that gets executed when an operation on a service mapping completes
+ * @param background Background processes that prepare the target machines or NULL if all target machines are ready
+ * @param batch_functions Functions that execute the operations of multiple mappings at once or NULL to execute each operation separately
  * @return TRUE if all the service mappings' states have been successfully changed, else FALSE
  */
-ProcReact_bool traverse_service_mappings(GPtrArray *service_mapping_array, GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table, GHashTable *targets_table, iterate_strategy_function iterate_strategy, service_mapping_function map_service_mapping, complete_service_mapping_function complete_service_mapping);
+ProcReact_bool traverse_service_mappings(GPtrArray *service_mapping_array, const ServiceMappingIndex *index, GHashTable *targets_table, query_prerequisite_mappings_function query_prerequisite_mappings, visit_mapping_function visit_mapping, service_mapping_function map_service_mapping, complete_service_mapping_function complete_service_mapping, BackgroundProcesses *background, const ServiceMappingBatchFunctions *batch_functions);
 
 #endif
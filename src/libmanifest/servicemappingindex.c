@@ -0,0 +1,97 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "servicemappingindex.h"
+#include "servicemappingarray.h"
+#include "manifestservice.h"
+
+static void add_edge(GHashTable *edges_table, ServiceMapping *from, ServiceMapping *to)
+{
+    GPtrArray *mappings = g_hash_table_lookup(edges_table, from);
+
+    if(mappings == NULL)
+    {
+        mappings = g_ptr_array_new();
+        g_hash_table_insert(edges_table, from, mappings);
+    }
+
+    g_ptr_array_add(mappings, to);
+}
+
+static void delete_edges(GPtrArray *mappings)
+{
+    g_ptr_array_free(mappings, TRUE);
+}
+
+ServiceMappingIndex *create_service_mapping_index(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table)
+{
+    ServiceMappingIndex *index = (ServiceMappingIndex*)g_malloc(sizeof(ServiceMappingIndex));
+    unsigned int i;
+
+    index->unified_service_mapping_array = unified_service_mapping_array;
+    index->unified_services_table = unified_services_table;
+    index->inter_dependency_mappings_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)delete_edges);
+    index->interdependent_mappings_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)delete_edges);
+
+    /* Resolve the inter-dependencies of every mapping once and record the edges in both directions */
+    for(i = 0; i < unified_service_mapping_array->len; i++)
+    {
+        ServiceMapping *mapping = g_ptr_array_index(unified_service_mapping_array, i);
+        ManifestService *service = g_hash_table_lookup(unified_services_table, (gchar*)mapping->service);
+
+        if(service != NULL && service->depends_on != NULL)
+        {
+            unsigned int j;
+
+            for(j = 0; j < service->depends_on->len; j++)
+            {
+                InterDependencyMapping *dependency = g_ptr_array_index(service->depends_on, j);
+                ServiceMapping *dependency_mapping = find_service_mapping(unified_service_mapping_array, dependency);
+
+                if(dependency_mapping != NULL)
+                {
+                    add_edge(index->inter_dependency_mappings_table, mapping, dependency_mapping);
+                    add_edge(index->interdependent_mappings_table, dependency_mapping, mapping);
+                }
+            }
+        }
+    }
+
+    return index;
+}
+
+void delete_service_mapping_index(ServiceMappingIndex *index)
+{
+    if(index != NULL)
+    {
+        g_hash_table_destroy(index->inter_dependency_mappings_table);
+        g_hash_table_destroy(index->interdependent_mappings_table);
+        g_free(index);
+    }
+}
+
+const GPtrArray *lookup_inter_dependency_mappings(const ServiceMappingIndex *index, const ServiceMapping *mapping)
+{
+    return g_hash_table_lookup(index->inter_dependency_mappings_table, mapping);
+}
+
+const GPtrArray *lookup_interdependent_mappings(const ServiceMappingIndex *index, const ServiceMapping *mapping)
+{
+    return g_hash_table_lookup(index->interdependent_mappings_table, mapping);
+}
@@ -0,0 +1,83 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_SERVICEMAPPINGINDEX_H
+#define __DISNIX_SERVICEMAPPINGINDEX_H
+#include <glib.h>
+#include "servicemapping.h"
+
+/**
+ * @brief Captures the inter-dependency relationships between service mappings in both directions.
+ *
+ * The index is derived once from the unified service mappings and services
+ * so that traversals do not have to rescan the mappings to find the
+ * dependencies or reverse dependencies of a mapping.
+ */
+typedef struct
+{
+    /** An array of service mappings that exist in the previous and current configuration */
+    GPtrArray *unified_service_mapping_array;
+    /** A hash table of services that exist in the previous and current configuration */
+    GHashTable *unified_services_table;
+    /** Hash table translating a service mapping into an array of service mappings that it has an inter-dependency on */
+    GHashTable *inter_dependency_mappings_table;
+    /** Hash table translating a service mapping into an array of service mappings that have an inter-dependency on it */
+    GHashTable *interdependent_mappings_table;
+}
+ServiceMappingIndex;
+
+/**
+ * Creates an index of the inter-dependency relationships between all the
+ * provided service mappings.
+ *
+ * @param unified_service_mapping_array An array of service mappings that exist in the previous and current configuration
+ * @param unified_services_table A hash table of services that exist in the previous and current configuration
+ * @return A service mapping index. It should be removed from memory with delete_service_mapping_index()
+ */
+ServiceMappingIndex *create_service_mapping_index(GPtrArray *unified_service_mapping_array, GHashTable *unified_services_table);
+
+/**
+ * Deletes a service mapping index from heap memory. The service mappings and
+ * services themselves are not removed.
+ *
+ * @param index A service mapping index
+ */
+void delete_service_mapping_index(ServiceMappingIndex *index);
+
+/**
+ * Looks up the service mappings that the given mapping has an
+ * inter-dependency on.
+ *
+ * @param index A service mapping index
+ * @param mapping A service mapping from the unified service mapping array
+ * @return An array of inter-dependency mappings or NULL if there are none. The array is owned by the index.
+ */
+const GPtrArray *lookup_inter_dependency_mappings(const ServiceMappingIndex *index, const ServiceMapping *mapping);
+
+/**
+ * Looks up the service mappings that have an inter-dependency on the given
+ * mapping (reverse dependencies).
+ *
+ * @param index A service mapping index
+ * @param mapping A service mapping from the unified service mapping array
+ * @return An array of interdependent mappings or NULL if there are none. The array is owned by the index.
+ */
+const GPtrArray *lookup_interdependent_mappings(const ServiceMappingIndex *index, const ServiceMapping *mapping);
+
+#endif
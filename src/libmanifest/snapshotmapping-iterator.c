@@ -0,0 +1,83 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include "snapshotmapping-iterator.h"
+
+static int has_next_snapshot_mapping(void *data)
+{
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)data;
+
+    /* Stop spawning processes for the remaining mappings once an operation has failed */
+    return snapshot_mapping_iterator_data->model_iterator_data.success && has_next_iteration_process(&snapshot_mapping_iterator_data->model_iterator_data);
+}
+
+static pid_t next_snapshot_mapping_process(void *data)
+{
+    /* Declarations */
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)data;
+
+    /* Retrieve snapshot mapping */
+    SnapshotMapping *mapping = g_ptr_array_index(snapshot_mapping_iterator_data->snapshot_mapping_array, snapshot_mapping_iterator_data->model_iterator_data.index);
+
+    /* Invoke the next snapshot mapping operation process */
+    pid_t pid = snapshot_mapping_iterator_data->map_snapshot_mapping(snapshot_mapping_iterator_data->data, mapping, snapshot_mapping_iterator_data->target);
+
+    /* Increase the iterator index and update the pid table */
+    next_iteration_process(&snapshot_mapping_iterator_data->model_iterator_data, pid, mapping);
+
+    /* Return the pid of the invoked process */
+    return pid;
+}
+
+static void complete_snapshot_mapping_process(void *data, pid_t pid, ProcReact_Status status, int result)
+{
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)data;
+
+    /* Retrieve the completed item */
+    SnapshotMapping *mapping = complete_iteration_process(&snapshot_mapping_iterator_data->model_iterator_data, pid, status, result);
+
+    /* Invoke callback that handles completion of the snapshot mapping */
+    snapshot_mapping_iterator_data->complete_map_snapshot_mapping(snapshot_mapping_iterator_data->data, mapping, snapshot_mapping_iterator_data->target, status, result);
+}
+
+ProcReact_PidIterator create_snapshot_mapping_iterator(const GPtrArray *snapshot_mapping_array, Target *target, map_snapshot_mapping_function map_snapshot_mapping, complete_map_snapshot_mapping_function complete_map_snapshot_mapping, void *data)
+{
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)g_malloc(sizeof(SnapshotMappingIteratorData));
+
+    init_model_iterator_data(&snapshot_mapping_iterator_data->model_iterator_data, snapshot_mapping_array->len);
+    snapshot_mapping_iterator_data->snapshot_mapping_array = snapshot_mapping_array;
+    snapshot_mapping_iterator_data->target = target;
+    snapshot_mapping_iterator_data->map_snapshot_mapping = map_snapshot_mapping;
+    snapshot_mapping_iterator_data->complete_map_snapshot_mapping = complete_map_snapshot_mapping;
+    snapshot_mapping_iterator_data->data = data;
+
+    return procreact_initialize_pid_iterator(has_next_snapshot_mapping, next_snapshot_mapping_process, procreact_retrieve_boolean, complete_snapshot_mapping_process, snapshot_mapping_iterator_data);
+}
+
+void destroy_snapshot_mapping_iterator(ProcReact_PidIterator *iterator)
+{
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)iterator->data;
+    destroy_model_iterator_data(&snapshot_mapping_iterator_data->model_iterator_data);
+    g_free(snapshot_mapping_iterator_data);
+}
+
+ProcReact_bool snapshot_mapping_iterator_has_succeeded(const ProcReact_PidIterator *iterator)
+{
+    SnapshotMappingIteratorData *snapshot_mapping_iterator_data = (SnapshotMappingIteratorData*)iterator->data;
+    return snapshot_mapping_iterator_data->model_iterator_data.success;
+}
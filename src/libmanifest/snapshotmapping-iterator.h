@@ -0,0 +1,99 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef __DISNIX_SNAPSHOTMAPPING_ITERATOR_H
+#define __DISNIX_SNAPSHOTMAPPING_ITERATOR_H
+
+#include <procreact_pid_iterator.h>
+#include <modeliterator.h>
+#include <targetstable.h>
+#include "snapshotmappingarray.h"
+
+/**
+ * Pointer to a function that executes an operation for each snapshot mapping
+ *
+ * @param data An arbitrary data structure
+ * @param mapping A snapshot mapping from a snapshots array
+ * @param target The corresponding target machine of the snapshot mapping
+ * @return The PID of the spawned process
+ */
+typedef pid_t (*map_snapshot_mapping_function) (void *data, SnapshotMapping *mapping, Target *target);
+
+/**
+ * Pointer to a function that gets executed when a process completes for a snapshot mapping
+ *
+ * @param data An arbitrary data structure
+ * @param mapping A snapshot mapping from a snapshots array
+ * @param target The corresponding target machine of the snapshot mapping
+ * @param status Indicates whether the process terminated abnormally or not
+ * @param result TRUE if the operation succeeded, else FALSE
+ */
+typedef void (*complete_map_snapshot_mapping_function) (void *data, SnapshotMapping *mapping, Target *target, ProcReact_Status status, ProcReact_bool result);
+
+/**
+ * @brief Iterator that can be used to execute a process for each snapshot mapping of a target machine
+ */
+typedef struct
+{
+    /** Common properties for all model iterators */
+    ModelIteratorData model_iterator_data;
+    /** Array of snapshot mappings that belong to the target machine */
+    const GPtrArray *snapshot_mapping_array;
+    /** Target machine to which the snapshot mappings belong */
+    Target *target;
+
+    /** Pointer to a function that executes an operation for each snapshot mapping */
+    map_snapshot_mapping_function map_snapshot_mapping;
+    /** Pointer to a function that gets executed when a process completes for a snapshot mapping */
+    complete_map_snapshot_mapping_function complete_map_snapshot_mapping;
+
+    /** Pointer to arbitrary data passed to the above functions */
+    void *data;
+}
+SnapshotMappingIteratorData;
+
+/**
+ * Creates a new iterator that steps over each snapshot mapping of a target
+ * machine and executes the provided functions on start and completion. After
+ * an operation has failed, no operations are started for the remaining
+ * snapshot mappings.
+ *
+ * @param snapshot_mapping_array Array of snapshot mappings that belong to the target machine
+ * @param target Target machine to which the snapshot mappings belong
+ * @param map_snapshot_mapping Pointer to a function that executes an operation for each snapshot mapping
+ * @param complete_map_snapshot_mapping Pointer to a function that gets executed when a process completes for a snapshot mapping
+ * @param data Pointer to arbitrary data passed to the above functions
+ * @return A PID iterator that can be used to traverse the snapshot mappings
+ */
+ProcReact_PidIterator create_snapshot_mapping_iterator(const GPtrArray *snapshot_mapping_array, Target *target, map_snapshot_mapping_function map_snapshot_mapping, complete_map_snapshot_mapping_function complete_map_snapshot_mapping, void *data);
+
+/**
+ * Destroys the resources attached to the given snapshot mapping iterator.
+ *
+ * @param iterator Pid iterator constructed with create_snapshot_mapping_iterator()
+ */
+void destroy_snapshot_mapping_iterator(ProcReact_PidIterator *iterator);
+
+/**
+ * Returns the success status of the overall iteration process.
+ *
+ * @return TRUE if all the operations of the iterator have succeeded else FALSE.
+ */
+ProcReact_bool snapshot_mapping_iterator_has_succeeded(const ProcReact_PidIterator *iterator);
+
+#endif
@@ -18,22 +18,23 @@
  */
 
 #include "snapshotmapping-traverse.h"
-#include <sys/types.h>
-#include <sys/wait.h>
 #include <nixxml-generate-env.h>
 #include "interdependencymapping.h"
 #include "manifestservicestable.h"
 #include "mappingparameters.h"
 
-static int wait_to_complete_snapshot_item(GHashTable *pid_table, GHashTable *services_table, GHashTable *targets_table, complete_snapshot_item_mapping_function complete_snapshot_item_mapping)
+static int wait_to_complete_snapshot_item(ProcReact_PidSet *pid_set, GHashTable *services_table, GHashTable *targets_table, complete_snapshot_item_mapping_function complete_snapshot_item_mapping)
 {
-    if(g_hash_table_size(pid_table) > 0)
+    if(pid_set->length > 0)
     {
         int wstatus;
-        pid_t pid = wait(&wstatus);
+        SnapshotMapping *mapping;
 
-        if(pid == -1)
-            return FALSE;
+        /* Wait for a process spawned by this traversal to finish and retrieve its corresponding snapshot mapping */
+        pid_t pid = procreact_wait_for_pid_in_set(pid_set, &wstatus, (void**)&mapping);
+
+        if(mapping == NULL)
+            return FALSE; /* A process that could not be waited for cannot be related to a mapping, so we can only report a failure */
         else
         {
             ManifestService *service;
@@ -41,10 +42,6 @@ static int wait_to_complete_snapshot_item(GHashTable *pid_table, GHashTable *ser
             ProcReact_Status status;
             int result;
 
-            /* Find the corresponding snapshot mapping and remove it from the pids table */
-            SnapshotMapping *mapping = g_hash_table_lookup(pid_table, &pid);
-            g_hash_table_remove(pid_table, &pid);
-
             /* Mark mapping as transferred to prevent it from snapshotting again */
             mapping->transferred = TRUE;
 
@@ -67,7 +64,7 @@ ProcReact_bool map_snapshot_items(const GPtrArray *snapshot_mapping_array, GHash
 {
     unsigned int num_processed = 0;
     ProcReact_bool status = TRUE;
-    GHashTable *pid_table = g_hash_table_new_full(g_int_hash, g_int_equal, g_free, NULL);
+    ProcReact_PidSet pid_set = procreact_initialize_pid_set();
 
     while(num_processed < snapshot_mapping_array->len)
     {
@@ -85,22 +82,28 @@ ProcReact_bool map_snapshot_items(const GPtrArray *snapshot_mapping_array, GHash
                 MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, services_table, target);
                 pid_t pid = map_snapshot_item(mapping, params.service, target, params.type, params.arguments, params.arguments_size);
 
-                /* Add pid and mapping to the hash table */
-                gint *pid_ptr = g_malloc(sizeof(gint));
-                *pid_ptr = pid;
-                g_hash_table_insert(pid_table, pid_ptr, mapping);
+                if(pid == -1)
+                {
+                    /* Complete the mapping as a failure so that it is not retried, and make the CPU core available again */
+                    mapping->transferred = TRUE;
+                    signal_available_target_core(target);
+                    complete_snapshot_item_mapping(mapping, params.service, target, PROCREACT_STATUS_FORK_FAIL, FALSE);
+                    status = FALSE;
+                }
+                else
+                    procreact_add_pid(&pid_set, pid, mapping); /* Add pid and mapping to the PID set */
 
                 /* Cleanup */
                 destroy_mapping_parameters(&params);
             }
         }
 
-        if(!wait_to_complete_snapshot_item(pid_table, services_table, targets_table, complete_snapshot_item_mapping))
+        if(!wait_to_complete_snapshot_item(&pid_set, services_table, targets_table, complete_snapshot_item_mapping))
             status = FALSE;
 
         num_processed++;
     }
 
-    g_hash_table_destroy(pid_table);
+    procreact_destroy_pid_set(&pid_set);
     return status;
 }
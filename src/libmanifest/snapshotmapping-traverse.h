@@ -22,6 +22,7 @@
 #include <glib.h>
 #include <libxml/parser.h>
 #include <procreact_pid.h>
+#include <procreact_pid_set.h>
 #include <targetstable.h>
 #include "snapshotmappingarray.h"
 #include "manifestservice.h"
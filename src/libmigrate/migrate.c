@@ -22,9 +22,9 @@
 #include "restore.h"
 #include "delete-state.h"
 
-ProcReact_bool migrate(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep)
+ProcReact_bool migrate(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep)
 {
-    return (snapshot(manifest, previous_manifest, max_concurrent_transfers, flags, keep)
-      && restore(manifest, previous_manifest, max_concurrent_transfers, flags, keep)
+    return (snapshot(manifest, previous_manifest, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep)
+      && restore(manifest, previous_manifest, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep)
       && (!(flags & FLAG_DELETE_STATE) || (previous_manifest == NULL) || (flags & FLAG_NO_UPGRADE) || delete_obsolete_state(previous_manifest->snapshot_mapping_array, previous_manifest->services_table, manifest->targets_table)));
 }
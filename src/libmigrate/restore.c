@@ -22,6 +22,7 @@
 #include <remote-state-management.h>
 #include <remote-snapshot-management.h>
 #include <snapshotmapping-traverse.h>
+#include <snapshotmapping-iterator.h>
 #include <targets-iterator.h>
 #include <manifestservicestable.h>
 #include <mappingparameters.h>
@@ -32,6 +33,7 @@
 typedef struct
 {
     GPtrArray *snapshot_mapping_array;
+    unsigned int max_concurrent_snapshot_transfers;
     unsigned int flags;
 }
 SendSnapshotsData;
@@ -43,6 +45,18 @@ static pid_t send_snapshot_mapping(SnapshotMapping *mapping, Target *target, con
     return copy_snapshots_to((gchar*)target->client_interface, target_key, (gchar*)mapping->container, (gchar*)mapping->component, flags & FLAG_ALL, STDERR_FILENO);
 }
 
+static pid_t send_snapshot_mapping_process(void *data, SnapshotMapping *mapping, Target *target)
+{
+    SendSnapshotsData *send_snapshots_data = (SendSnapshotsData*)data;
+    return send_snapshot_mapping(mapping, target, send_snapshots_data->flags);
+}
+
+static void complete_send_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target, ProcReact_Status status, ProcReact_bool result)
+{
+    if(status != PROCREACT_STATUS_OK || !result)
+        g_printerr("[target: %s]: Cannot send snapshots of component: %s deployed to container: %s\n", mapping->target, mapping->component, mapping->container);
+}
+
 pid_t send_snapshots_to_target(void *data, gchar *target_name, Target *target)
 {
     pid_t pid = fork();
@@ -53,24 +67,14 @@ pid_t send_snapshots_to_target(void *data, gchar *target_name, Target *target)
 
         gchar *target_key = find_target_key(target);
         GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(send_snapshots_data->snapshot_mapping_array, target_key);
-        unsigned int i;
-        int exit_status = 0;
-        ProcReact_Status status;
+        ProcReact_PidIterator iterator = create_snapshot_mapping_iterator(snapshots_per_target_array, target, send_snapshot_mapping_process, complete_send_snapshot_mapping, send_snapshots_data);
+        int exit_status;
 
-        for(i = 0; i < snapshots_per_target_array->len; i++)
-        {
-            SnapshotMapping *mapping = g_ptr_array_index(snapshots_per_target_array, i);
-            exit_status = procreact_wait_for_exit_status(send_snapshot_mapping(mapping, target, send_snapshots_data->flags), &status);
-
-            if(status != PROCREACT_STATUS_OK)
-            {
-                exit_status = 1;
-                break;
-            }
-            else if(exit_status != 0)
-                break;
-        }
+        /* Send the snapshots of independent components on the same machine in parallel */
+        procreact_fork_and_wait_in_parallel_limit(&iterator, send_snapshots_data->max_concurrent_snapshot_transfers);
+        exit_status = !snapshot_mapping_iterator_has_succeeded(&iterator);
 
+        destroy_snapshot_mapping_iterator(&iterator);
         g_ptr_array_free(snapshots_per_target_array, TRUE);
 
         exit(exit_status);
@@ -85,10 +89,10 @@ void complete_send_snapshots_to_target(void *data, gchar *target_name, Target *t
         g_printerr("[target: %s]: Cannot retrieve snapshots!\n", target_name);
 }
 
-static ProcReact_bool send_snapshots(GPtrArray *snapshot_mapping_array, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int flags)
+static ProcReact_bool send_snapshots(GPtrArray *snapshot_mapping_array, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags)
 {
     ProcReact_bool success;
-    SendSnapshotsData data = { snapshot_mapping_array, flags };
+    SendSnapshotsData data = { snapshot_mapping_array, max_concurrent_snapshot_transfers, flags };
     ProcReact_PidIterator iterator = create_target_pid_iterator(targets_table, send_snapshots_to_target, complete_send_snapshots_to_target, &data);
     procreact_fork_and_wait_in_parallel_limit(&iterator, max_concurrent_transfers);
     success = target_iterator_has_succeeded(iterator.data);
@@ -132,6 +136,7 @@ typedef struct
 {
     GHashTable *services_table;
     GPtrArray *snapshot_mapping_array;
+    unsigned int max_concurrent_snapshot_transfers;
     unsigned int flags;
     int keep;
 }
@@ -139,38 +144,51 @@ SendRestoreAndCleanSnapshotsData;
 
 /* Restore depth-first infrastructure */
 
-static pid_t send_restore_and_clean_snapshot_on_target(void *data, gchar *target_name, Target *target)
+static pid_t send_restore_and_clean_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target)
 {
     pid_t pid = fork();
 
     if(pid == 0)
     {
         SendRestoreAndCleanSnapshotsData *send_snapshots_data = (SendRestoreAndCleanSnapshotsData*)data;
-
-        gchar *target_key = find_target_key(target);
-        GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(send_snapshots_data->snapshot_mapping_array, target_key);
-        unsigned int i;
-        int exit_status = 0;
+        MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, send_snapshots_data->services_table, target);
         ProcReact_Status status;
 
-        for(i = 0; i < snapshots_per_target_array->len; i++)
-        {
-            SnapshotMapping *mapping = g_ptr_array_index(snapshots_per_target_array, i);
+        ProcReact_bool result = procreact_wait_for_boolean(send_snapshot_mapping(mapping, target, send_snapshots_data->flags), &status) && (status == PROCREACT_STATUS_OK)
+          && procreact_wait_for_boolean(restore_snapshot_on_target(mapping, params.service, target, params.type, params.arguments, params.arguments_size), &status) && (status == PROCREACT_STATUS_OK)
+          && procreact_wait_for_boolean(clean_snapshot_mapping(mapping, target, send_snapshots_data->keep), &status) && (status == PROCREACT_STATUS_OK);
+
+        destroy_mapping_parameters(&params);
+
+        exit(!result);
+    }
+
+    return pid;
+}
+
+static void complete_send_restore_and_clean_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target, ProcReact_Status status, ProcReact_bool result)
+{
+    if(status != PROCREACT_STATUS_OK || !result)
+        g_printerr("[target: %s]: Cannot send, restore or clean snapshots of component: %s deployed to container: %s\n", mapping->target, mapping->component, mapping->container);
+}
+
+static pid_t send_restore_and_clean_snapshot_on_target(void *data, gchar *target_name, Target *target)
+{
+    pid_t pid = fork();
 
-            MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, send_snapshots_data->services_table, target);
+    if(pid == 0)
+    {
+        SendRestoreAndCleanSnapshotsData *send_snapshots_data = (SendRestoreAndCleanSnapshotsData*)data;
 
-            if(!procreact_wait_for_boolean(send_snapshot_mapping(mapping, target, send_snapshots_data->flags), &status) || (status != PROCREACT_STATUS_OK)
-              || !procreact_wait_for_boolean(restore_snapshot_on_target(mapping, params.service, target, params.type, params.arguments, params.arguments_size), &status) || (status != PROCREACT_STATUS_OK)
-              || !procreact_wait_for_boolean(clean_snapshot_mapping(mapping, target, send_snapshots_data->keep), &status) || (status != PROCREACT_STATUS_OK))
-            {
-                exit_status = 1;
-                destroy_mapping_parameters(&params);
-                break;
-            }
+        gchar *target_key = find_target_key(target);
+        GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(send_snapshots_data->snapshot_mapping_array, target_key);
+        ProcReact_PidIterator iterator = create_snapshot_mapping_iterator(snapshots_per_target_array, target, send_restore_and_clean_snapshot_mapping, complete_send_restore_and_clean_snapshot_mapping, send_snapshots_data);
+        int exit_status;
 
-            destroy_mapping_parameters(&params);
-        }
+        procreact_fork_and_wait_in_parallel_limit(&iterator, send_snapshots_data->max_concurrent_snapshot_transfers);
+        exit_status = !snapshot_mapping_iterator_has_succeeded(&iterator);
 
+        destroy_snapshot_mapping_iterator(&iterator);
         g_ptr_array_free(snapshots_per_target_array, TRUE);
 
         exit(exit_status);
@@ -185,10 +203,10 @@ void complete_send_restore_and_clean_snapshots_on_target(void *data, gchar *targ
         g_printerr("[target: %s]: Cannot send, restore or clean snapshots!\n", target_name);
 }
 
-static ProcReact_bool restore_depth_first(GPtrArray *snapshot_mapping_array, GHashTable *services_table, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep)
+static ProcReact_bool restore_depth_first(GPtrArray *snapshot_mapping_array, GHashTable *services_table, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep)
 {
     ProcReact_bool success;
-    SendRestoreAndCleanSnapshotsData data = { services_table, snapshot_mapping_array, flags, keep };
+    SendRestoreAndCleanSnapshotsData data = { services_table, snapshot_mapping_array, max_concurrent_snapshot_transfers, flags, keep };
     ProcReact_PidIterator iterator = create_target_pid_iterator(targets_table, send_restore_and_clean_snapshot_on_target, complete_send_restore_and_clean_snapshots_on_target, &data);
 
     g_print("[coordinator]: Sending, restoring and cleaning snapshots...\n");
@@ -203,7 +221,7 @@ static ProcReact_bool restore_depth_first(GPtrArray *snapshot_mapping_array, GHa
 
 /* The entire restore operation */
 
-ProcReact_bool restore(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int flags, const unsigned int keep)
+ProcReact_bool restore(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const unsigned int keep)
 {
     ProcReact_bool exit_status;
     GPtrArray *snapshot_mapping_array;
@@ -220,10 +238,10 @@ ProcReact_bool restore(const Manifest *manifest, const Manifest *previous_manife
     }
 
     if(flags & FLAG_DEPTH_FIRST)
-        exit_status = restore_depth_first(snapshot_mapping_array, manifest->services_table, manifest->targets_table, max_concurrent_transfers, flags, keep);
+        exit_status = restore_depth_first(snapshot_mapping_array, manifest->services_table, manifest->targets_table, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep);
     else
     {
-        exit_status = send_snapshots(snapshot_mapping_array, manifest->targets_table, max_concurrent_transfers, flags) /* First, send the snapshots to the remote machines */
+        exit_status = send_snapshots(snapshot_mapping_array, manifest->targets_table, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags) /* First, send the snapshots to the remote machines */
           && ((flags & FLAG_TRANSFER_ONLY) || restore_services(snapshot_mapping_array, manifest->services_table, manifest->targets_table)); /* Then, restore them on the remote machines */
     }
 
@@ -32,10 +32,11 @@
  * @param manifest Manifest containing all deployment information
  * @param old_snapshots_array Array of stateful components belonging to the previous configurations
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param max_concurrent_snapshot_transfers Specifies the maximum amount of concurrent snapshot transfers per target machine
  * @param flags Data migration option flags
  * @param keep Indicates how many snapshot generations should be kept remotely while executing the depth first operation
  * @return TRUE if the restore completed successfully, else FALSE
  */
-ProcReact_bool restore(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int flags, const unsigned int keep);
+ProcReact_bool restore(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const unsigned int keep);
 
 #endif
@@ -22,6 +22,7 @@
 #include <remote-state-management.h>
 #include <remote-snapshot-management.h>
 #include <snapshotmapping-traverse.h>
+#include <snapshotmapping-iterator.h>
 #include <manifestservicestable.h>
 #include <targets-iterator.h>
 #include <mappingparameters.h>
@@ -52,6 +53,7 @@ static ProcReact_bool snapshot_services(GPtrArray *snapshots_array, GHashTable *
 typedef struct
 {
     GPtrArray *snapshots_array;
+    unsigned int max_concurrent_snapshot_transfers;
     unsigned int flags;
 }
 RetrieveSnapshotsData;
@@ -63,6 +65,18 @@ static pid_t retrieve_snapshot_mapping(SnapshotMapping *mapping, Target *target,
     return copy_snapshots_from((char*)target->client_interface, target_key, (char*)mapping->container, (char*)mapping->component, flags & FLAG_ALL, STDOUT_FILENO, STDERR_FILENO);
 }
 
+static pid_t retrieve_snapshot_mapping_process(void *data, SnapshotMapping *mapping, Target *target)
+{
+    RetrieveSnapshotsData *retrieve_snapshots_data = (RetrieveSnapshotsData*)data;
+    return retrieve_snapshot_mapping(mapping, target, retrieve_snapshots_data->flags);
+}
+
+static void complete_retrieve_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target, ProcReact_Status status, ProcReact_bool result)
+{
+    if(status != PROCREACT_STATUS_OK || !result)
+        g_printerr("[target: %s]: Cannot retrieve snapshots of component: %s deployed to container: %s\n", mapping->target, mapping->component, mapping->container);
+}
+
 pid_t retrieve_snapshots_from_target(void *data, gchar *target_name, Target *target)
 {
     pid_t pid = fork();
@@ -73,24 +87,14 @@ pid_t retrieve_snapshots_from_target(void *data, gchar *target_name, Target *tar
 
         gchar *target_key = find_target_key(target);
         GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(retrieve_snapshots_data->snapshots_array, target_key);
-        unsigned int i;
-        int exit_status = 0;
-        ProcReact_Status status;
+        ProcReact_PidIterator iterator = create_snapshot_mapping_iterator(snapshots_per_target_array, target, retrieve_snapshot_mapping_process, complete_retrieve_snapshot_mapping, retrieve_snapshots_data);
+        int exit_status;
 
-        for(i = 0; i < snapshots_per_target_array->len; i++)
-        {
-            SnapshotMapping *mapping = g_ptr_array_index(snapshots_per_target_array, i);
-            exit_status = procreact_wait_for_exit_status(retrieve_snapshot_mapping(mapping, target, retrieve_snapshots_data->flags), &status);
-
-            if(status != PROCREACT_STATUS_OK)
-            {
-                exit_status = 1;
-                break;
-            }
-            else if(exit_status != 0)
-                break;
-        }
+        /* Retrieve the snapshots of independent components on the same machine in parallel */
+        procreact_fork_and_wait_in_parallel_limit(&iterator, retrieve_snapshots_data->max_concurrent_snapshot_transfers);
+        exit_status = !snapshot_mapping_iterator_has_succeeded(&iterator);
 
+        destroy_snapshot_mapping_iterator(&iterator);
         g_ptr_array_free(snapshots_per_target_array, TRUE);
 
         exit(exit_status);
@@ -105,10 +109,10 @@ void complete_retrieve_snapshots_from_target(void *data, gchar *target_name, Tar
         g_printerr("[target: %s]: Cannot send snapshots!\n", target_name);
 }
 
-static ProcReact_bool retrieve_snapshots(GPtrArray *snapshots_array, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int flags)
+static ProcReact_bool retrieve_snapshots(GPtrArray *snapshots_array, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags)
 {
     ProcReact_bool success;
-    RetrieveSnapshotsData data = { snapshots_array, flags };
+    RetrieveSnapshotsData data = { snapshots_array, max_concurrent_snapshot_transfers, flags };
     ProcReact_PidIterator iterator = create_target_pid_iterator(targets_table, retrieve_snapshots_from_target, complete_retrieve_snapshots_from_target, &data);
 
     g_print("[coordinator]: Retrieving snapshots...\n");
@@ -134,6 +138,7 @@ typedef struct
 {
     GHashTable *services_table;
     GPtrArray *snapshot_mapping_array;
+    unsigned int max_concurrent_snapshot_transfers;
     unsigned int flags;
     int keep;
 }
@@ -141,38 +146,51 @@ TakeRetrieveAndCleanSnapshotsData;
 
 /* Snapshot depth-first infrastructure */
 
-static pid_t take_retrieve_and_clean_snapshot_on_target(void *data, gchar *target_name, Target *target)
+static pid_t take_retrieve_and_clean_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target)
 {
     pid_t pid = fork();
 
     if(pid == 0)
     {
         TakeRetrieveAndCleanSnapshotsData *retrieve_snapshots_data = (TakeRetrieveAndCleanSnapshotsData*)data;
-
-        gchar *target_key = find_target_key(target);
-        GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(retrieve_snapshots_data->snapshot_mapping_array, target_key);
-        unsigned int i;
-        int exit_status = 0;
+        MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, retrieve_snapshots_data->services_table, target);
         ProcReact_Status status;
 
-        for(i = 0; i < snapshots_per_target_array->len; i++)
-        {
-            SnapshotMapping *mapping = g_ptr_array_index(snapshots_per_target_array, i);
+        ProcReact_bool result = procreact_wait_for_boolean(take_snapshot_on_target(mapping, params.service, target, params.type, params.arguments, params.arguments_size), &status) && (status == PROCREACT_STATUS_OK)
+          && procreact_wait_for_boolean(retrieve_snapshot_mapping(mapping, target, retrieve_snapshots_data->flags), &status) && (status == PROCREACT_STATUS_OK)
+          && procreact_wait_for_boolean(clean_snapshot_mapping(mapping, target, retrieve_snapshots_data->keep), &status) && (status == PROCREACT_STATUS_OK);
 
-            MappingParameters params = create_mapping_parameters(mapping->service, mapping->container, mapping->target, mapping->container_provided_by_service, retrieve_snapshots_data->services_table, target);
+        destroy_mapping_parameters(&params);
 
-            if(!procreact_wait_for_boolean(take_snapshot_on_target(mapping, params.service, target, params.type, params.arguments, params.arguments_size), &status) || (status != PROCREACT_STATUS_OK)
-              || !procreact_wait_for_boolean(retrieve_snapshot_mapping(mapping, target, retrieve_snapshots_data->flags), &status) || (status != PROCREACT_STATUS_OK)
-              || !procreact_wait_for_boolean(clean_snapshot_mapping(mapping, target, retrieve_snapshots_data->keep), &status) || (status != PROCREACT_STATUS_OK))
-            {
-                exit_status = 1;
-                destroy_mapping_parameters(&params);
-                break;
-            }
+        exit(!result);
+    }
 
-            destroy_mapping_parameters(&params);
-        }
+    return pid;
+}
+
+static void complete_take_retrieve_and_clean_snapshot_mapping(void *data, SnapshotMapping *mapping, Target *target, ProcReact_Status status, ProcReact_bool result)
+{
+    if(status != PROCREACT_STATUS_OK || !result)
+        g_printerr("[target: %s]: Cannot take, retrieve or clean snapshots of component: %s deployed to container: %s\n", mapping->target, mapping->component, mapping->container);
+}
+
+static pid_t take_retrieve_and_clean_snapshot_on_target(void *data, gchar *target_name, Target *target)
+{
+    pid_t pid = fork();
+
+    if(pid == 0)
+    {
+        TakeRetrieveAndCleanSnapshotsData *retrieve_snapshots_data = (TakeRetrieveAndCleanSnapshotsData*)data;
+
+        gchar *target_key = find_target_key(target);
+        GPtrArray *snapshots_per_target_array = find_snapshot_mappings_per_target(retrieve_snapshots_data->snapshot_mapping_array, target_key);
+        ProcReact_PidIterator iterator = create_snapshot_mapping_iterator(snapshots_per_target_array, target, take_retrieve_and_clean_snapshot_mapping, complete_take_retrieve_and_clean_snapshot_mapping, retrieve_snapshots_data);
+        int exit_status;
+
+        procreact_fork_and_wait_in_parallel_limit(&iterator, retrieve_snapshots_data->max_concurrent_snapshot_transfers);
+        exit_status = !snapshot_mapping_iterator_has_succeeded(&iterator);
 
+        destroy_snapshot_mapping_iterator(&iterator);
         g_ptr_array_free(snapshots_per_target_array, TRUE);
 
         exit(exit_status);
@@ -187,10 +205,10 @@ void complete_take_retrieve_and_clean_snapshots_on_target(void *data, gchar *tar
         g_printerr("[target: %s]: Cannot take, send or clean snapshots!\n", target_name);
 }
 
-static ProcReact_bool snapshot_depth_first(GPtrArray *snapshot_mapping_array, GHashTable *services_table, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep)
+static ProcReact_bool snapshot_depth_first(GPtrArray *snapshot_mapping_array, GHashTable *services_table, GHashTable *targets_table, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep)
 {
     ProcReact_bool success;
-    TakeRetrieveAndCleanSnapshotsData data = { services_table, snapshot_mapping_array, flags, keep };
+    TakeRetrieveAndCleanSnapshotsData data = { services_table, snapshot_mapping_array, max_concurrent_snapshot_transfers, flags, keep };
     ProcReact_PidIterator iterator = create_target_pid_iterator(targets_table, take_retrieve_and_clean_snapshot_on_target, complete_take_retrieve_and_clean_snapshots_on_target, &data);
 
     g_print("[coordinator]: Snapshotting, retrieving and cleaning snapshots...\n");
@@ -205,7 +223,7 @@ static ProcReact_bool snapshot_depth_first(GPtrArray *snapshot_mapping_array, GH
 
 /* The entire snapshot operation */
 
-ProcReact_bool snapshot(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep)
+ProcReact_bool snapshot(const Manifest *manifest, const Manifest *previous_manifest, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep)
 {
     if(!(flags & FLAG_NO_UPGRADE) && previous_manifest == NULL)
     {
@@ -242,11 +260,11 @@ ProcReact_bool snapshot(const Manifest *manifest, const Manifest *previous_manif
         }
 
         if(flags & FLAG_DEPTH_FIRST)
-            exit_status = snapshot_depth_first(snapshot_mapping_array, previous_services_table, manifest->targets_table, max_concurrent_transfers, flags, keep);
+            exit_status = snapshot_depth_first(snapshot_mapping_array, previous_services_table, manifest->targets_table, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep);
         else
         {
             exit_status = ((flags & FLAG_TRANSFER_ONLY) || snapshot_services(snapshot_mapping_array, previous_services_table, manifest->targets_table))
-              && retrieve_snapshots(snapshot_mapping_array, manifest->targets_table, max_concurrent_transfers, flags);
+              && retrieve_snapshots(snapshot_mapping_array, manifest->targets_table, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags);
         }
 
         if(!(flags & FLAG_NO_UPGRADE))
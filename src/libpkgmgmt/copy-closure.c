@@ -21,58 +21,242 @@
 #include <procreact_types.h>
 #include "package-management.h"
 #include "remote-package-management.h"
+#include "export-cache.h"
+#include "requisites-cache.h"
+#include <unistd.h>
+#include <fcntl.h>
 
-ProcReact_bool copy_closure_to_sync(gchar *interface, gchar *target, gchar *tmpdir, gchar **paths, int stderr_fd)
+static ProcReact_bool open_closure_stream(int pipefd[2])
 {
-    char **requisites = pkgmgmt_query_requisites_sync(paths, g_strv_length(paths), stderr_fd);
+    if(pipe(pipefd) == -1)
+        return FALSE;
+    else
+    {
+        /*
+         * Neither end may leak into the other process. Otherwise the
+         * importing process never sees the end of the stream.
+         */
+        fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+        return TRUE;
+    }
+}
 
-    if(requisites == NULL)
+static ProcReact_bool wait_for_closure_stream(pid_t export_pid, pid_t import_pid)
+{
+    ProcReact_Status export_status, import_status;
+    ProcReact_bool export_result = procreact_wait_for_boolean(export_pid, &export_status);
+    ProcReact_bool import_result = procreact_wait_for_boolean(import_pid, &import_status);
+
+    return (export_status == PROCREACT_STATUS_OK && export_result && import_status == PROCREACT_STATUS_OK && import_result);
+}
+
+static ProcReact_bool transfer_cached_closure(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **paths, const unsigned int paths_length, int stderr_fd)
+{
+    int pipefd[2];
+
+    if(open_closure_stream(pipefd))
+    {
+        ProcReact_Status import_status;
+        ProcReact_bool import_result, write_result;
+        pid_t import_pid = pkgmgmt_import_streamed_closure(interface, target, pipefd[0]);
+
+        close(pipefd[0]);
+
+        /* Stream the cached serializations into the remote import */
+        write_result = (import_pid != -1 && pkgmgmt_write_cached_closure(export_cache_dir, paths, paths_length, pipefd[1], stderr_fd));
+        close(pipefd[1]);
+
+        import_result = procreact_wait_for_boolean(import_pid, &import_status);
+        return (write_result && import_status == PROCREACT_STATUS_OK && import_result);
+    }
+    else
         return FALSE;
+}
+
+static ProcReact_bool transfer_paths(gchar *interface, gchar *target, gchar *export_cache_dir, char **invalid_paths, const unsigned int invalid_paths_length, int stderr_fd)
+{
+    if(invalid_paths_length == 0)
+        return TRUE;
+    else if(export_cache_dir != NULL && pkgmgmt_export_cache_shares_paths(export_cache_dir, invalid_paths, invalid_paths_length))
+        return transfer_cached_closure(interface, target, export_cache_dir, invalid_paths, invalid_paths_length, stderr_fd);
     else
     {
-        ProcReact_bool exit_status = TRUE;
-        unsigned int requisites_length = g_strv_length(requisites);
+        int pipefd[2];
 
-        if(requisites_length > 0)
+        if(open_closure_stream(pipefd))
         {
-            char **invalid_paths = pkgmgmt_remote_print_invalid_sync(interface, target, requisites, requisites_length);
+            /* Pipe the export straight into the remote import, so that bytes are transferred while they are produced */
+            pid_t export_pid = pkgmgmt_export_closure_fd(invalid_paths, invalid_paths_length, pipefd[1], stderr_fd);
+            pid_t import_pid = pkgmgmt_import_streamed_closure(interface, target, pipefd[0]);
 
-            if(invalid_paths == NULL)
-                exit_status = FALSE;
-            else
-            {
-                unsigned int invalid_paths_length = g_strv_length(invalid_paths);
+            close(pipefd[0]);
+            close(pipefd[1]);
 
-                if(invalid_paths_length > 0)
-                {
-                    char *tempfile = pkgmgmt_export_closure_sync(tmpdir, invalid_paths, invalid_paths_length, stderr_fd);
+            return wait_for_closure_stream(export_pid, import_pid);
+        }
+        else
+            return FALSE;
+    }
+}
 
-                    if(tempfile == NULL)
-                        exit_status = FALSE;
-                    else
-                    {
-                        exit_status = pkgmgmt_import_local_closure_sync(interface, target, tempfile);
-                        unlink(tempfile);
-                        g_free(tempfile);
-                    }
-                }
+static ProcReact_bool transfer_invalid_paths(gchar *interface, gchar *target, gchar *export_cache_dir, char **requisites, const unsigned int requisites_length, int stderr_fd)
+{
+    ProcReact_bool exit_status = TRUE;
 
-                procreact_free_string_array(invalid_paths);
-            }
+    if(requisites_length > 0)
+    {
+        char **invalid_paths = pkgmgmt_remote_print_invalid_sync(interface, target, requisites, requisites_length);
+
+        if(invalid_paths == NULL)
+            exit_status = FALSE;
+        else
+        {
+            exit_status = transfer_paths(interface, target, export_cache_dir, invalid_paths, g_strv_length(invalid_paths), stderr_fd);
+            procreact_free_string_array(invalid_paths);
         }
+    }
 
-        procreact_free_string_array(requisites);
+    return exit_status;
+}
 
-        return exit_status;
+static ProcReact_bool contains_known_valid_root(char **invalid_paths, gchar **known_valid_roots)
+{
+    unsigned int i, j;
+
+    for(i = 0; invalid_paths[i] != NULL; i++)
+    {
+        for(j = 0; known_valid_roots[j] != NULL; j++)
+        {
+            if(g_strcmp0(invalid_paths[i], known_valid_roots[j]) == 0)
+                return TRUE;
+        }
     }
+
+    return FALSE;
 }
 
-pid_t copy_closure_to(gchar *interface, gchar *target, gchar *tmpdir, gchar **paths, int stderr_fd)
+static ProcReact_bool transfer_uncertain_paths(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **uncertain_paths, gchar **known_valid_roots, char **requisites, int stderr_fd)
+{
+    /*
+     * The target may have lost the paths that we consider valid, e.g. because
+     * it has been reinstalled or garbage collected. Verify the known valid
+     * roots in the same query as the uncertain paths.
+     */
+    GPtrArray *query_paths = g_ptr_array_new();
+    char **invalid_paths;
+    ProcReact_bool exit_status;
+    unsigned int i;
+
+    for(i = 0; uncertain_paths[i] != NULL; i++)
+        g_ptr_array_add(query_paths, uncertain_paths[i]);
+
+    for(i = 0; known_valid_roots[i] != NULL; i++)
+        g_ptr_array_add(query_paths, known_valid_roots[i]);
+
+    if(query_paths->len == 0)
+    {
+        g_ptr_array_free(query_paths, TRUE);
+        return TRUE;
+    }
+
+    invalid_paths = pkgmgmt_remote_print_invalid_sync(interface, target, (gchar**)query_paths->pdata, query_paths->len);
+    g_ptr_array_free(query_paths, TRUE);
+
+    if(invalid_paths == NULL)
+        exit_status = FALSE;
+    else
+    {
+        if(contains_known_valid_root(invalid_paths, known_valid_roots))
+            exit_status = transfer_invalid_paths(interface, target, export_cache_dir, requisites, g_strv_length(requisites), stderr_fd); /* Our knowledge is outdated, check all requisites */
+        else
+            exit_status = transfer_paths(interface, target, export_cache_dir, invalid_paths, g_strv_length(invalid_paths), stderr_fd);
+
+        procreact_free_string_array(invalid_paths);
+    }
+
+    return exit_status;
+}
+
+static gchar **subtract_known_valid_paths(const gchar *requisites_cache_dir, char **requisites, gchar **known_valid_roots, int stderr_fd)
+{
+    char **known_valid_paths = pkgmgmt_query_requisites_cached_sync(requisites_cache_dir, known_valid_roots, g_strv_length(known_valid_roots), stderr_fd);
+
+    if(known_valid_paths == NULL)
+        return NULL;
+    else
+    {
+        GHashTable *known_valid_table = g_hash_table_new(g_str_hash, g_str_equal);
+        GPtrArray *uncertain_paths = g_ptr_array_new();
+        unsigned int i;
+
+        for(i = 0; known_valid_paths[i] != NULL; i++)
+            g_hash_table_insert(known_valid_table, known_valid_paths[i], known_valid_paths[i]);
+
+        /* The resulting array refers to the strings of the requisites array */
+        for(i = 0; requisites[i] != NULL; i++)
+        {
+            if(!g_hash_table_contains(known_valid_table, requisites[i]))
+                g_ptr_array_add(uncertain_paths, requisites[i]);
+        }
+
+        g_ptr_array_add(uncertain_paths, NULL);
+
+        g_hash_table_destroy(known_valid_table);
+        procreact_free_string_array(known_valid_paths);
+
+        return (gchar**)g_ptr_array_free(uncertain_paths, FALSE);
+    }
+}
+
+ProcReact_bool copy_closure_to_sync(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **paths, gchar **known_valid_roots, int stderr_fd)
+{
+    /* Consult the requisites cache, so that repeated transfers of the same paths do not have to query the Nix store again */
+    gchar *requisites_cache_dir = pkgmgmt_open_requisites_cache();
+    char **requisites = pkgmgmt_query_requisites_cached_sync(requisites_cache_dir, paths, g_strv_length(paths), stderr_fd);
+    ProcReact_bool exit_status;
+
+    if(requisites == NULL)
+        exit_status = FALSE;
+    else
+    {
+        gchar **uncertain_paths;
+
+        /* Only ask the target about the requisites that are not already known to be valid there */
+        if(known_valid_roots != NULL && (uncertain_paths = subtract_known_valid_paths(requisites_cache_dir, requisites, known_valid_roots, stderr_fd)) != NULL)
+        {
+            exit_status = transfer_uncertain_paths(interface, target, export_cache_dir, uncertain_paths, known_valid_roots, requisites, stderr_fd);
+            g_free(uncertain_paths);
+
+            /*
+             * A requisite of a valid root may still have disappeared from the
+             * target, causing the import to fail. Retry by verifying all
+             * requisites.
+             */
+            if(!exit_status)
+                exit_status = transfer_invalid_paths(interface, target, export_cache_dir, requisites, g_strv_length(requisites), stderr_fd);
+        }
+        else
+            exit_status = transfer_invalid_paths(interface, target, export_cache_dir, requisites, g_strv_length(requisites), stderr_fd);
+
+        /* The cache entries of shared paths can be removed once every transfer that needs them is done */
+        if(export_cache_dir != NULL)
+            pkgmgmt_release_cached_paths(export_cache_dir, requisites);
+
+        procreact_free_string_array(requisites);
+    }
+
+    g_free(requisites_cache_dir);
+
+    return exit_status;
+}
+
+pid_t copy_closure_to(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **paths, gchar **known_valid_roots, int stderr_fd)
 {
     pid_t pid = fork();
 
     if(pid == 0)
-        _exit(!copy_closure_to_sync(interface, target, tmpdir, paths, stderr_fd));
+        _exit(!copy_closure_to_sync(interface, target, export_cache_dir, paths, known_valid_roots, stderr_fd));
 
     return pid;
 }
@@ -100,16 +284,21 @@ ProcReact_bool copy_closure_from_sync(gchar *interface, gchar *target, gchar **p
 
                 if(invalid_paths_length > 0)
                 {
-                    char *tempfile = pkgmgmt_export_remote_closure_sync(interface, target, invalid_paths, invalid_paths_length);
+                    int pipefd[2];
 
-                    if(tempfile == NULL)
-                        exit_status = FALSE;
-                    else
+                    if(open_closure_stream(pipefd))
                     {
-                        exit_status = pkgmgmt_import_closure_sync(tempfile, stdout_fd, stderr_fd);
-                        unlink(tempfile);
-                        free(tempfile);
+                        /* Pipe the remote export straight into the local import, so that bytes are imported while they are received */
+                        pid_t export_pid = pkgmgmt_export_remote_closure_stream(interface, target, invalid_paths, invalid_paths_length, pipefd[1]);
+                        pid_t import_pid = pkgmgmt_import_closure_fd(pipefd[0], stdout_fd, stderr_fd);
+
+                        close(pipefd[0]);
+                        close(pipefd[1]);
+
+                        exit_status = wait_for_closure_stream(export_pid, import_pid);
                     }
+                    else
+                        exit_status = FALSE;
                 }
 
                 procreact_free_string_array(invalid_paths);
@@ -24,22 +24,26 @@
 
 /**
  * Copies a closure of a collection of a Nix store paths to a remote machine.
+ * Requisites that belong to the closures of the known valid roots are
+ * assumed to be present on the target and are not checked remotely. If
+ * the transfer fails, it is retried by checking all requisites.
  *
  * @param interface Path to the interface executable
  * @param target Target Address of the remote interface
- * @param tmpdir Directory in which temp files are stored
+ * @param export_cache_dir Path to an export cache shared with other transfers or NULL to export the closure directly. The transfer releases the cache entries of its requisites once it is done
  * @param paths An array of Nix store paths
+ * @param known_valid_roots NULL-terminated array of Nix store paths whose closures are expected to be valid on the target, or NULL to verify all requisites remotely. The roots themselves are always verified, if any of them is invalid all requisites are verified
  * @param stderr_fd File descriptor to attach to the process' standard error
  * @return TRUE if the operation succeeds, else FALSE
  */
-ProcReact_bool copy_closure_to_sync(gchar *interface, gchar *target, gchar *tmpdir, gchar **paths, int stderr_fd);
+ProcReact_bool copy_closure_to_sync(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **paths, gchar **known_valid_roots, int stderr_fd);
 
 /**
  * Asynchronously copies a closure to a machine in a sub process.
  *
  * @see copy_closure_to_sync
  */
-pid_t copy_closure_to(gchar *interface, gchar *target, gchar *tmpdir, gchar **paths, int stderr_fd);
+pid_t copy_closure_to(gchar *interface, gchar *target, gchar *export_cache_dir, gchar **paths, gchar **known_valid_roots, int stderr_fd);
 
 /**
  * Copies a closure of a collection of a Nix store paths from a remote machine.
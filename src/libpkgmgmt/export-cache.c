@@ -0,0 +1,456 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "export-cache.h"
+#include "package-management.h"
+#include "requisites-cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#define BUFFER_SIZE 4096
+
+/*
+ * A serialization starts every store path with the number 1 and concludes
+ * with the number 0, both encoded as 64-bit little endian integers. The
+ * serialization of a single store path minus its terminator can be
+ * concatenated with others to form the serialization of all of them.
+ */
+#define TERMINATOR_SIZE 8
+
+static gchar *compose_entry_path(const gchar *export_cache_dir, gchar *path)
+{
+    gchar *base_name = strrchr(path, '/');
+    return g_strconcat(export_cache_dir, "/", base_name == NULL ? path : base_name + 1, NULL);
+}
+
+static GHashTable *count_consumers(GPtrArray *transfers, int stderr_fd)
+{
+    GHashTable *consumers_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    gchar *requisites_cache_dir = pkgmgmt_open_requisites_cache();
+    unsigned int i;
+
+    for(i = 0; i < transfers->len; i++)
+    {
+        gchar **roots = g_ptr_array_index(transfers, i);
+        char **requisites = pkgmgmt_query_requisites_cached_sync(requisites_cache_dir, roots, g_strv_length(roots), stderr_fd);
+
+        if(requisites == NULL)
+        {
+            g_hash_table_destroy(consumers_table);
+            consumers_table = NULL;
+            break;
+        }
+        else
+        {
+            unsigned int j;
+
+            for(j = 0; requisites[j] != NULL; j++)
+            {
+                unsigned int count = GPOINTER_TO_UINT(g_hash_table_lookup(consumers_table, requisites[j]));
+                g_hash_table_insert(consumers_table, g_strdup(requisites[j]), GUINT_TO_POINTER(count + 1));
+            }
+
+            procreact_free_string_array(requisites);
+        }
+    }
+
+    g_free(requisites_cache_dir);
+    return consumers_table;
+}
+
+static ProcReact_bool write_consumer_count(const gchar *entry_path, unsigned int count)
+{
+    gchar *refs_path = g_strconcat(entry_path, ".refs", NULL);
+    gchar *contents = g_strdup_printf("%u", count);
+    ProcReact_bool success = g_file_set_contents(refs_path, contents, -1, NULL);
+
+    g_free(contents);
+    g_free(refs_path);
+    return success;
+}
+
+gchar *pkgmgmt_create_export_cache(const gchar *tmpdir, GPtrArray *transfers, int stderr_fd)
+{
+    GHashTable *consumers_table;
+    GHashTableIter iter;
+    gpointer key, value;
+    gchar *export_cache_dir = NULL;
+
+    /* A single transfer has nothing to share */
+    if(transfers->len < 2 || (consumers_table = count_consumers(transfers, stderr_fd)) == NULL)
+        return NULL;
+
+    /* Only paths that more than one transfer needs get an entry, all other paths are streamed straight from the Nix store */
+    g_hash_table_iter_init(&iter, consumers_table);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+        if(GPOINTER_TO_UINT(value) > 1)
+        {
+            gchar *entry_path;
+
+            if(export_cache_dir == NULL)
+            {
+                export_cache_dir = g_strconcat(tmpdir, "/disnix-export-cache.XXXXXX", NULL);
+
+                if(mkdtemp(export_cache_dir) == NULL)
+                {
+                    g_printerr("Cannot create export cache directory: %s\n", export_cache_dir);
+                    g_free(export_cache_dir);
+                    export_cache_dir = NULL;
+                    break;
+                }
+            }
+
+            entry_path = compose_entry_path(export_cache_dir, (gchar*)key);
+
+            if(!write_consumer_count(entry_path, GPOINTER_TO_UINT(value)))
+            {
+                /* Without a complete set of counts we cannot tell when an entry can be removed */
+                g_printerr("Cannot write the consumer count of export cache entry: %s\n", entry_path);
+                g_free(entry_path);
+                pkgmgmt_delete_export_cache(export_cache_dir);
+                export_cache_dir = NULL;
+                break;
+            }
+
+            g_free(entry_path);
+        }
+    }
+
+    g_hash_table_destroy(consumers_table);
+    return export_cache_dir;
+}
+
+void pkgmgmt_delete_export_cache(gchar *export_cache_dir)
+{
+    if(export_cache_dir != NULL)
+    {
+        DIR *dir = opendir(export_cache_dir);
+
+        if(dir != NULL)
+        {
+            struct dirent *entry;
+
+            while((entry = readdir(dir)) != NULL)
+            {
+                if(strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                {
+                    gchar *entry_path = g_strconcat(export_cache_dir, "/", entry->d_name, NULL);
+                    unlink(entry_path);
+                    g_free(entry_path);
+                }
+            }
+
+            closedir(dir);
+        }
+
+        rmdir(export_cache_dir);
+        g_free(export_cache_dir);
+    }
+}
+
+static ProcReact_bool write_all(int fd, const char *buffer, size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t bytes_written = write(fd, buffer, length);
+
+        if(bytes_written <= 0)
+            return FALSE;
+
+        buffer += bytes_written;
+        length -= bytes_written;
+    }
+
+    return TRUE;
+}
+
+static ProcReact_bool append_cache_entry(const gchar *entry_path, int closure_fd)
+{
+    ProcReact_bool success = FALSE;
+    int entry_fd = open(entry_path, O_RDONLY);
+
+    if(entry_fd != -1)
+    {
+        struct stat st;
+
+        if(fstat(entry_fd, &st) == 0 && st.st_size >= TERMINATOR_SIZE)
+        {
+            off_t remaining = st.st_size - TERMINATOR_SIZE; /* Leave the terminator out */
+            char buffer[BUFFER_SIZE];
+
+            success = TRUE;
+
+            while(success && remaining > 0)
+            {
+                ssize_t bytes_read = read(entry_fd, buffer, remaining < BUFFER_SIZE ? remaining : BUFFER_SIZE);
+
+                if(bytes_read <= 0 || !write_all(closure_fd, buffer, bytes_read))
+                    success = FALSE;
+                else
+                    remaining -= bytes_read;
+            }
+        }
+
+        close(entry_fd);
+    }
+
+    return success;
+}
+
+static ProcReact_bool forward_export(int export_fd, int closure_fd, int entry_fd)
+{
+    char buffer[BUFFER_SIZE + TERMINATOR_SIZE];
+    size_t pending = 0;
+    ssize_t bytes_read;
+
+    while((bytes_read = read(export_fd, buffer + pending, BUFFER_SIZE)) > 0)
+    {
+        /* The cache entry is a complete serialization, including the terminator */
+        if(entry_fd != -1 && !write_all(entry_fd, buffer + pending, bytes_read))
+            return FALSE;
+
+        pending += bytes_read;
+
+        /* Hold back the last bytes, as they may be the terminator */
+        if(pending > TERMINATOR_SIZE)
+        {
+            size_t forwarded = pending - TERMINATOR_SIZE;
+
+            if(!write_all(closure_fd, buffer, forwarded))
+                return FALSE;
+
+            memmove(buffer, buffer + forwarded, TERMINATOR_SIZE);
+            pending = TERMINATOR_SIZE;
+        }
+    }
+
+    return (bytes_read == 0 && pending == TERMINATOR_SIZE);
+}
+
+static ProcReact_bool export_paths_through(gchar **paths, const unsigned int paths_length, int closure_fd, int entry_fd, int stderr_fd)
+{
+    int pipefd[2];
+
+    if(pipe(pipefd) == -1)
+        return FALSE;
+    else
+    {
+        ProcReact_Status status;
+        ProcReact_bool forward_result, export_result;
+        pid_t pid;
+
+        fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+
+        pid = pkgmgmt_export_closure_fd(paths, paths_length, pipefd[1], stderr_fd);
+        close(pipefd[1]);
+
+        forward_result = (pid != -1 && forward_export(pipefd[0], closure_fd, entry_fd));
+        close(pipefd[0]); /* An export that is still running terminates if we gave up forwarding */
+
+        export_result = procreact_wait_for_boolean(pid, &status);
+        return (forward_result && status == PROCREACT_STATUS_OK && export_result);
+    }
+}
+
+static ProcReact_bool export_path_into_cache(gchar *path, const gchar *entry_path, int closure_fd, int stderr_fd)
+{
+    ProcReact_bool success = FALSE;
+    gchar *temp_path = g_strconcat(entry_path, ".tmp", NULL);
+    int temp_fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    if(temp_fd != -1)
+    {
+        gchar *paths[] = { path, NULL };
+
+        /* Tee the export into the cache while it is streamed to the reader */
+        success = export_paths_through(paths, 1, closure_fd, temp_fd, stderr_fd);
+        close(temp_fd);
+
+        /* Only expose complete serializations to other processes */
+        if(!success || rename(temp_path, entry_path) != 0)
+            unlink(temp_path);
+    }
+
+    g_free(temp_path);
+    return success;
+}
+
+static ProcReact_bool is_shared_path(const gchar *export_cache_dir, gchar *path)
+{
+    gchar *entry_path = compose_entry_path(export_cache_dir, path);
+    gchar *refs_path = g_strconcat(entry_path, ".refs", NULL);
+    ProcReact_bool shared = (access(refs_path, F_OK) == 0);
+
+    g_free(refs_path);
+    g_free(entry_path);
+    return shared;
+}
+
+static int lock_cache_entry(const gchar *entry_path)
+{
+    gchar *lock_path = g_strconcat(entry_path, ".lock", NULL);
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT, 0600);
+
+    g_free(lock_path);
+
+    if(lock_fd != -1 && flock(lock_fd, LOCK_EX) != 0)
+    {
+        close(lock_fd);
+        return -1;
+    }
+    else
+        return lock_fd;
+}
+
+static void unlock_cache_entry(int lock_fd)
+{
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+}
+
+static ProcReact_bool write_shared_path(const gchar *export_cache_dir, gchar *path, int closure_fd, int stderr_fd)
+{
+    gchar *entry_path = compose_entry_path(export_cache_dir, path);
+    int lock_fd = lock_cache_entry(entry_path); /* Wait for any process that is exporting the same path */
+    ProcReact_bool success = FALSE;
+
+    if(lock_fd != -1)
+    {
+        if(access(entry_path, R_OK) == 0)
+            success = append_cache_entry(entry_path, closure_fd);
+        else
+            success = export_path_into_cache(path, entry_path, closure_fd, stderr_fd);
+
+        unlock_cache_entry(lock_fd);
+    }
+
+    g_free(entry_path);
+    return success;
+}
+
+ProcReact_bool pkgmgmt_export_cache_shares_paths(const gchar *export_cache_dir, gchar **paths, const unsigned int paths_length)
+{
+    unsigned int i;
+
+    for(i = 0; i < paths_length; i++)
+    {
+        if(is_shared_path(export_cache_dir, paths[i]))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+ProcReact_bool pkgmgmt_write_cached_closure(const gchar *export_cache_dir, gchar **paths, const unsigned int paths_length, int closure_fd, int stderr_fd)
+{
+    ProcReact_bool success = TRUE;
+    unsigned int i = 0;
+    struct sigaction ignore_action, old_action;
+
+    /* A reader that quits early should make us fail, not terminate us */
+    memset(&ignore_action, 0, sizeof(struct sigaction));
+    ignore_action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignore_action, &old_action);
+
+    while(success && i < paths_length)
+    {
+        if(is_shared_path(export_cache_dir, paths[i]))
+        {
+            success = write_shared_path(export_cache_dir, paths[i], closure_fd, stderr_fd);
+
+            if(!success)
+                dprintf(stderr_fd, "Cannot export: %s\n", paths[i]);
+
+            i++;
+        }
+        else
+        {
+            /* Export consecutive paths that no other transfer needs with a single process */
+            unsigned int start = i;
+
+            while(i < paths_length && !is_shared_path(export_cache_dir, paths[i]))
+                i++;
+
+            success = export_paths_through(paths + start, i - start, closure_fd, -1, stderr_fd);
+        }
+    }
+
+    if(success)
+    {
+        const char terminator[TERMINATOR_SIZE] = { 0 };
+        success = write_all(closure_fd, terminator, TERMINATOR_SIZE);
+    }
+
+    sigaction(SIGPIPE, &old_action, NULL);
+    return success;
+}
+
+static void release_cache_entry(const gchar *entry_path)
+{
+    gchar *refs_path = g_strconcat(entry_path, ".refs", NULL);
+    int lock_fd = lock_cache_entry(entry_path);
+
+    if(lock_fd != -1)
+    {
+        gchar *contents;
+
+        if(g_file_get_contents(refs_path, &contents, NULL, NULL))
+        {
+            unsigned int count = (unsigned int)g_ascii_strtoull(contents, NULL, 10);
+
+            /* The last consumer removes the entry, so that the cache does not accumulate the closures of all transfers */
+            if(count <= 1)
+            {
+                unlink(entry_path);
+                unlink(refs_path);
+            }
+            else
+                write_consumer_count(entry_path, count - 1);
+
+            g_free(contents);
+        }
+
+        unlock_cache_entry(lock_fd);
+    }
+
+    g_free(refs_path);
+}
+
+void pkgmgmt_release_cached_paths(const gchar *export_cache_dir, char **paths)
+{
+    unsigned int i;
+
+    for(i = 0; paths[i] != NULL; i++)
+    {
+        if(is_shared_path(export_cache_dir, paths[i]))
+        {
+            gchar *entry_path = compose_entry_path(export_cache_dir, paths[i]);
+            release_cache_entry(entry_path);
+            g_free(entry_path);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_EXPORT_CACHE_H
+#define __DISNIX_EXPORT_CACHE_H
+#include <glib.h>
+#include <procreact_util.h>
+
+/**
+ * Creates a coordinator-side cache that memorizes the serializations of the
+ * Nix store paths that more than one of the given transfers needs. It allows
+ * the same closure to be distributed to many machines while each shared store
+ * path is exported only once. Every entry records how many transfers still
+ * need it, so that it can be removed as soon as the last of them is done.
+ *
+ * @param tmpdir Directory in which temp files are stored
+ * @param transfers Array of NULL-terminated arrays of Nix store paths, each containing the paths whose closure a single transfer copies
+ * @param stderr_fd File descriptor to attach to the query processes' standard error
+ * @return Path to the cache directory or NULL if the transfers do not share any store path or the cache cannot be created. In that case, the closures should be exported directly
+ */
+gchar *pkgmgmt_create_export_cache(const gchar *tmpdir, GPtrArray *transfers, int stderr_fd);
+
+/**
+ * Removes an export cache and all of its remaining entries, and frees the
+ * path.
+ *
+ * @param export_cache_dir Path to the cache directory or NULL
+ */
+void pkgmgmt_delete_export_cache(gchar *export_cache_dir);
+
+/**
+ * Checks whether any of the given Nix store paths is shared with other
+ * transfers through the export cache.
+ *
+ * @param export_cache_dir Path to the cache directory
+ * @param paths An array of Nix store paths
+ * @param paths_length The length of the paths array
+ * @return TRUE if at least one of the paths has a cache entry, else FALSE
+ */
+ProcReact_bool pkgmgmt_export_cache_shares_paths(const gchar *export_cache_dir, gchar **paths, const unsigned int paths_length);
+
+/**
+ * Writes a serialization of the given Nix store paths to a file descriptor.
+ * The result is identical to what nix-store --export produces. Consecutive
+ * paths that no other transfer needs are streamed from a single export
+ * process. A shared path is read from the cache, or exported into the cache
+ * while it is being written the first time it is requested. Concurrent
+ * processes that share the cache wait for each other instead of exporting
+ * the same path twice.
+ *
+ * @param export_cache_dir Path to the cache directory
+ * @param paths An array of Nix store paths in the order in which they must be imported
+ * @param paths_length The length of the paths array
+ * @param closure_fd File descriptor to which the serialization is written
+ * @param stderr_fd File descriptor to attach to the export processes' standard error
+ * @return TRUE if the serialization was completely written, else FALSE
+ */
+ProcReact_bool pkgmgmt_write_cached_closure(const gchar *export_cache_dir, gchar **paths, const unsigned int paths_length, int closure_fd, int stderr_fd);
+
+/**
+ * Notifies the export cache that a transfer no longer needs the given Nix
+ * store paths. Entries that no other transfer needs anymore are removed.
+ *
+ * @param export_cache_dir Path to the cache directory
+ * @param paths NULL-terminated array with all requisites of the transfer's paths
+ */
+void pkgmgmt_release_cached_paths(const gchar *export_cache_dir, char **paths);
+
+#endif
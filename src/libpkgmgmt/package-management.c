@@ -27,6 +27,7 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <errno.h>
+#include <procreact_spawn.h>
 
 #define BUFFER_SIZE 1024
 #define NIX_STORE_CMD "nix-store"
@@ -46,23 +47,18 @@ pid_t pkgmgmt_import_closure(const char *closure, int stdout_fd, int stderr_fd)
     }
     else
     {
-        pid_t pid = fork();
-
-        if(pid == 0)
-        {
-            char *const args[] = {NIX_STORE_CMD, "--import", NULL};
-
-            dup2(closure_fd, 0);
-            dup2(stdout_fd, 1);
-            dup2(stderr_fd, 2);
-            execvp(args[0], args);
-            _exit(1);
-        }
-
+        pid_t pid = pkgmgmt_import_closure_fd(closure_fd, stdout_fd, stderr_fd);
+        close(closure_fd); /* The spawned process has its own copy of the descriptor */
         return pid;
     }
 }
 
+pid_t pkgmgmt_import_closure_fd(int closure_fd, int stdout_fd, int stderr_fd)
+{
+    char *const args[] = {NIX_STORE_CMD, "--import", NULL};
+    return procreact_spawn(args, NULL, closure_fd, stdout_fd, stderr_fd, 0);
+}
+
 ProcReact_bool pkgmgmt_import_closure_sync(const char *closure, int stdout_fd, int stderr_fd)
 {
     ProcReact_Status status;
@@ -83,29 +79,28 @@ gchar *pkgmgmt_export_closure(gchar *tmpdir, gchar **paths, const unsigned int p
     }
     else
     {
-        *pid = fork();
-
-        if(*pid == 0)
-        {
-            unsigned int i;
-            gchar **args = (char**)g_malloc((3 + paths_length) * sizeof(gchar*));
+        *pid = pkgmgmt_export_closure_fd(paths, paths_length, *temp_fd, stderr_fd);
+        return tempfilename;
+    }
+}
 
-            args[0] = NIX_STORE_CMD;
-            args[1] = "--export";
+pid_t pkgmgmt_export_closure_fd(gchar **paths, const unsigned int paths_length, int closure_fd, int stderr_fd)
+{
+    pid_t pid;
+    unsigned int i;
+    gchar **args = (char**)g_malloc((3 + paths_length) * sizeof(gchar*));
 
-            for(i = 0; i < paths_length; i++)
-                args[i + 2] = paths[i];
+    args[0] = NIX_STORE_CMD;
+    args[1] = "--export";
 
-            args[i + 2] = NULL;
+    for(i = 0; i < paths_length; i++)
+        args[i + 2] = paths[i];
 
-            dup2(*temp_fd, 1);
-            dup2(stderr_fd, 2);
-            execvp(args[0], args);
-            _exit(1);
-        }
+    args[i + 2] = NULL;
 
-        return tempfilename;
-    }
+    pid = procreact_spawn(args, NULL, -1, closure_fd, stderr_fd, 0);
+    g_free(args);
+    return pid;
 }
 
 gchar *pkgmgmt_export_closure_sync(gchar *tmpdir, gchar **paths, const unsigned int paths_length, int stderr_fd)
@@ -128,28 +123,21 @@ gchar *pkgmgmt_export_closure_sync(gchar *tmpdir, gchar **paths, const unsigned
 
 ProcReact_Future pkgmgmt_print_invalid_packages(gchar **paths, const unsigned int paths_length, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    gchar **args = (char**)g_malloc((4 + paths_length) * sizeof(gchar*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        gchar **args = (char**)g_malloc((4 + paths_length) * sizeof(gchar*));
-
-        args[0] = NIX_STORE_CMD;
-        args[1] = "--check-validity";
-        args[2] = "--print-invalid";
+    args[0] = NIX_STORE_CMD;
+    args[1] = "--check-validity";
+    args[2] = "--print-invalid";
 
-        for(i = 0; i < paths_length; i++)
-            args[i + 3] = paths[i];
+    for(i = 0; i < paths_length; i++)
+        args[i + 3] = paths[i];
 
-        args[i + 3] = NULL;
-
-        dup2(future.fd, 1); /* Attach write-end to stdout */
-        dup2(stderr_fd, 2); /* Attach logger to stderr */
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 3] = NULL;
 
+    future = procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0); /* Attach logger to stderr */
+    g_free(args);
     return future;
 }
 
@@ -167,30 +155,32 @@ char **pkgmgmt_print_invalid_packages_sync(gchar **paths, const unsigned int pat
 
 ProcReact_Future pkgmgmt_realise(gchar **derivation_paths, const unsigned int derivation_paths_length, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    gchar **args = (gchar**)g_malloc((3 + derivation_paths_length) * sizeof(gchar*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        gchar **args = (gchar**)g_malloc((3 + derivation_paths_length) * sizeof(gchar*));
-
-        args[0] = NIX_STORE_CMD;
-        args[1] = "-r";
+    args[0] = NIX_STORE_CMD;
+    args[1] = "-r";
 
-        for(i = 0; i < derivation_paths_length; i++)
-            args[i + 2] = derivation_paths[i];
+    for(i = 0; i < derivation_paths_length; i++)
+        args[i + 2] = derivation_paths[i];
 
-        args[i + 2] = NULL;
-
-        dup2(future.fd, 1); /* Attach write-end to stdout */
-        dup2(stderr_fd, 2); /* Attach logger to stderr */
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 2] = NULL;
 
+    future = procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0); /* Attach logger to stderr */
+    g_free(args);
     return future;
 }
 
+/* A stderr_fd of -1 means that the spawned process inherits our standard error */
+static void print_spawn_error(int stderr_fd, const char *message)
+{
+    if(stderr_fd == -1)
+        g_printerr("%s\n", message);
+    else
+        dprintf(stderr_fd, "%s\n", message);
+}
+
 static gchar *determine_profile_dir(void)
 {
     if(getuid() == 0)
@@ -233,20 +223,20 @@ pid_t pkgmgmt_set_profile(gchar *profile, gchar *path, int stdout_fd, int stderr
         g_free(generation_path);
     }
 
-    pid = fork();
+    if(resolved_path_size == -1 || (strlen(path) == resolved_path_size && strncmp(resolved_path, path, resolved_path_size) != 0)) /* Only configure the configurator profile if the given manifest is not identical to the previous manifest */
+    {
+        char *const args[] = {NIX_ENV_CMD, "-p", profile_path, "--set", path, NULL};
+        pid = procreact_spawn(args, NULL, -1, stdout_fd, stderr_fd, 0);
 
-    if(pid == 0)
+        if(pid == -1)
+            print_spawn_error(stderr_fd, "Error with executing nix-env");
+    }
+    else
     {
-        if(resolved_path_size == -1 || (strlen(path) == resolved_path_size && strncmp(resolved_path, path, resolved_path_size) != 0)) /* Only configure the configurator profile if the given manifest is not identical to the previous manifest */
-        {
-            char *const args[] = {NIX_ENV_CMD, "-p", profile_path, "--set", path, NULL};
-            dup2(stdout_fd, 1);
-            dup2(stderr_fd, 2);
-            execvp(args[0], args);
-            dprintf(stderr_fd, "Error with executing nix-env\n");
-            _exit(1);
-        }
-        else
+        /* Nothing needs to be done, but the caller still expects a process that it can wait for */
+        pid = fork();
+
+        if(pid == 0)
             _exit(0);
     }
 
@@ -257,27 +247,20 @@ pid_t pkgmgmt_set_profile(gchar *profile, gchar *path, int stdout_fd, int stderr
 
 ProcReact_Future pkgmgmt_query_requisites(gchar **paths, const unsigned int paths_length, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    char **args = (char**)g_malloc((3 + paths_length) * sizeof(char*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)g_malloc((3 + paths_length) * sizeof(char*));
-
-        args[0] = NIX_STORE_CMD;
-        args[1] = "-qR";
+    args[0] = NIX_STORE_CMD;
+    args[1] = "-qR";
 
-        for(i = 0; i < paths_length; i++)
-            args[i + 2] = paths[i];
+    for(i = 0; i < paths_length; i++)
+        args[i + 2] = paths[i];
 
-        args[i + 2] = NULL;
-
-        dup2(future.fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 2] = NULL;
 
+    future = procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0);
+    g_free(args);
     return future;
 }
 
@@ -295,44 +278,19 @@ char **pkgmgmt_query_requisites_sync(gchar **paths, const unsigned int paths_len
 
 pid_t pkgmgmt_collect_garbage(const ProcReact_bool delete_old, int stdout_fd, int stderr_fd)
 {
-    pid_t pid = fork();
+    char *const args[] = {NIX_COLLECT_GARBAGE_CMD, delete_old ? "-d" : NULL, NULL};
+    pid_t pid = procreact_spawn(args, NULL, -1, stdout_fd, stderr_fd, 0);
 
-    if(pid == 0)
-    {
-        dup2(stdout_fd, 1);
-        dup2(stderr_fd, 2);
-
-        if(delete_old)
-        {
-            char *const args[] = {NIX_COLLECT_GARBAGE_CMD, "-d", NULL};
-            execvp(args[0], args);
-        }
-        else
-        {
-            char *const args[] = {NIX_COLLECT_GARBAGE_CMD, NULL};
-            execvp(args[0], args);
-        }
-
-        dprintf(stderr_fd, "Error with executing garbage collect process\n");
-        _exit(1);
-    }
+    if(pid == -1)
+        print_spawn_error(stderr_fd, "Error with executing garbage collect process");
 
     return pid;
 }
 
 ProcReact_Future pkgmgmt_normalize_infrastructure(gchar *infrastructure_expr, gchar *default_target_property, gchar *default_client_interface)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_type());
-
-    if(future.pid == 0)
-    {
-        char *const args[] = {"disnix-normalize-infra", "--target-property", default_target_property, "--interface", default_client_interface, "--raw", infrastructure_expr, NULL};
-        dup2(future.fd, 1); /* Attach write-end to stdout */
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return future;
+    char *const args[] = {"disnix-normalize-infra", "--target-property", default_target_property, "--interface", default_client_interface, "--raw", infrastructure_expr, NULL};
+    return procreact_spawn_future(procreact_create_string_type(), args, NULL, -1, -1, 0);
 }
 
 char *pkgmgmt_normalize_infrastructure_sync(gchar *infrastructure_expr, gchar *default_target_property, gchar *default_client_interface)
@@ -344,16 +302,8 @@ char *pkgmgmt_normalize_infrastructure_sync(gchar *infrastructure_expr, gchar *d
 
 static pid_t execute_set_coordinator_profile(gchar *profile_path, gchar *manifest_file_path)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        char *const args[] = {NIX_ENV_CMD, "-p", profile_path, "--set", manifest_file_path, NULL};
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return pid;
+    char *const args[] = {NIX_ENV_CMD, "-p", profile_path, "--set", manifest_file_path, NULL};
+    return procreact_spawn(args, NULL, -1, -1, -1, 0);
 }
 
 static gchar *create_user_profile_dir(void)
@@ -34,6 +34,17 @@
  */
 pid_t pkgmgmt_import_closure(const char *closure, int stdout_fd, int stderr_fd);
 
+/**
+ * Imports a closure serialization that is read from a file descriptor into
+ * the Nix store.
+ *
+ * @param closure_fd File descriptor from which the Nix store export dump is read
+ * @param stdout_fd File descriptor to attach to the process' standard output
+ * @param stderr_fd File descriptor to attach to the process' standard error
+ * @return Process id of the process that executes the task or -1 in case of a failure
+ */
+pid_t pkgmgmt_import_closure_fd(int closure_fd, int stdout_fd, int stderr_fd);
+
 /**
  * Synchronously imports a closure serialization into the Nix store.
  *
@@ -55,6 +66,18 @@ ProcReact_bool pkgmgmt_import_closure_sync(const char *closure, int stdout_fd, i
  */
 gchar *pkgmgmt_export_closure(gchar *tmpdir, gchar **paths, const unsigned int paths_length, int stderr_fd, pid_t *pid, int *temp_fd);
 
+/**
+ * Serializes a collection of Nix store paths and writes the serialization to
+ * a file descriptor, such as the write-end of a pipe.
+ *
+ * @param paths An array of Nix store paths
+ * @param paths_length The length of the paths array
+ * @param closure_fd File descriptor to which the serialization is written
+ * @param stderr_fd File descriptor to attach to the process' standard error
+ * @return Process id of the process that executes the task or -1 in case of a failure
+ */
+pid_t pkgmgmt_export_closure_fd(gchar **paths, const unsigned int paths_length, int closure_fd, int stderr_fd);
+
 /**
  * Synchronously serializes a collection of Nix store paths into a file.
  *
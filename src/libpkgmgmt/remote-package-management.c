@@ -19,104 +19,124 @@
 
 #include "remote-package-management.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <client-interface.h>
+#include "package-management.h"
 
-pid_t pkgmgmt_remote_collect_garbage(gchar *interface, gchar *target, const ProcReact_bool delete_old)
+/* In-process implementations of the operations for the local client interface */
+
+typedef struct
 {
-    /* Declarations */
-    pid_t pid;
-    char *delete_old_arg;
+    gchar *profile;
+    gchar *component;
+}
+SetData;
 
-    /* Determine whether to use the delete old option */
-    if(delete_old)
-        delete_old_arg = "-d";
-    else
-        delete_old_arg = NULL;
+typedef struct
+{
+    gchar **paths;
+    unsigned int paths_length;
+    int closure_fd;
+}
+PathsData;
 
-    /* Fork and execute the collect garbage process */
-    pid = fork();
+static pid_t local_collect_garbage(void *data)
+{
+    return pkgmgmt_collect_garbage(*((ProcReact_bool*)data), -1, -1);
+}
 
-    if(pid == 0)
-    {
-        char *const args[] = {interface, "--target", target, "--collect-garbage", delete_old_arg, NULL};
-        execvp(interface, args);
-        _exit(1);
-    }
+static pid_t local_set(void *data)
+{
+    SetData *set_data = (SetData*)data;
+    return pkgmgmt_set_profile(set_data->profile, set_data->component, -1, -1);
+}
 
-    return pid;
+static ProcReact_Future local_realise(void *data)
+{
+    return pkgmgmt_realise((gchar**)data, 1, -1);
 }
 
-pid_t pkgmgmt_remote_set(gchar *interface, gchar *target, gchar *profile, gchar *component)
+static ProcReact_Future local_query_requisites(void *data)
 {
-    pid_t pid = fork();
+    PathsData *paths_data = (PathsData*)data;
+    return pkgmgmt_query_requisites(paths_data->paths, paths_data->paths_length, -1);
+}
 
-    if(pid == 0)
-    {
-        char *const args[] = {interface, "--target", target, "--profile", profile, "--set", component, NULL};
-        execvp(interface, args);
-        _exit(1);
-    }
+static ProcReact_Future local_print_invalid(void *data)
+{
+    PathsData *paths_data = (PathsData*)data;
+    return pkgmgmt_print_invalid_packages(paths_data->paths, paths_data->paths_length, -1);
+}
 
-    return pid;
+static pid_t local_import_closure(void *data)
+{
+    return pkgmgmt_import_closure((char*)data, -1, -1);
 }
 
-ProcReact_Future pkgmgmt_remote_query_installed(gchar *interface, gchar *target, gchar *profile)
+static pid_t local_import_closure_fd(void *data)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_type());
+    return pkgmgmt_import_closure_fd(*((int*)data), -1, -1);
+}
 
-    if(future.pid == 0)
-    {
-        char *const args[] = {interface, "--target", target, "--profile", profile, "--query-installed", NULL};
-        dup2(future.fd, 1); /* Attach pipe to the stdout */
-        execvp(interface, args); /* Run process */
-        _exit(1);
-    }
+static pid_t local_export_closure_fd(void *data)
+{
+    PathsData *paths_data = (PathsData*)data;
+    return pkgmgmt_export_closure_fd(paths_data->paths, paths_data->paths_length, paths_data->closure_fd, -1);
+}
 
-    return future;
+pid_t pkgmgmt_remote_collect_garbage(gchar *interface, gchar *target, const ProcReact_bool delete_old)
+{
+    /* Use the delete old option, if requested */
+    char *const args[] = {interface, "--target", target, "--collect-garbage", delete_old ? "-d" : NULL, NULL};
+
+    /* Spawn the collect garbage process */
+    return client_interface_spawn(args, -1, -1, -1, 0, local_collect_garbage, (void*)&delete_old);
 }
 
-ProcReact_Future pkgmgmt_remote_realise(gchar *interface, gchar *target, gchar *derivation)
+pid_t pkgmgmt_remote_set(gchar *interface, gchar *target, gchar *profile, gchar *component)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    char *const args[] = {interface, "--target", target, "--profile", profile, "--set", component, NULL};
+    SetData data = { profile, component };
+    return client_interface_spawn(args, -1, -1, -1, 0, local_set, &data);
+}
 
-    if(future.pid == 0)
-    {
-        char *const args[] = {interface, "--realise", "--target", target, derivation, NULL};
-        dup2(future.fd, 1); /* Attach pipe to the stdout */
-        execvp(interface, args); /* Run process */
-        _exit(1);
-    }
+ProcReact_Future pkgmgmt_remote_query_installed(gchar *interface, gchar *target, gchar *profile)
+{
+    char *const args[] = {interface, "--target", target, "--profile", profile, "--query-installed", NULL};
+    return client_interface_spawn_future(procreact_create_string_type(), args, -1, -1, 0, NULL, NULL);
+}
 
-    return future;
+ProcReact_Future pkgmgmt_remote_realise(gchar *interface, gchar *target, gchar *derivation)
+{
+    char *const args[] = {interface, "--realise", "--target", target, derivation, NULL};
+    return client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_realise, &derivation);
 }
 
 ProcReact_Future pkgmgmt_remote_query_requisites(gchar *interface, gchar *target, gchar **paths, const unsigned int paths_length)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
-
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((5 + paths_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--query-requisites";
-        args[2] = "--target";
-        args[3] = target;
+    ProcReact_Future future;
+    unsigned int i;
+    PathsData data = { paths, paths_length, -1 };
+    char **args = (char**)malloc((5 + paths_length) * sizeof(char*));
 
-        for(i = 0; i < paths_length; i++)
-            args[i + 4] = paths[i];
+    args[0] = interface;
+    args[1] = "--query-requisites";
+    args[2] = "--target";
+    args[3] = target;
 
-        args[i + 4] = NULL;
+    for(i = 0; i < paths_length; i++)
+        args[i + 4] = paths[i];
 
-        dup2(future.fd, 1); /* Attach pipe to the stdout */
-        execvp(interface, args); /* Run process */
-        _exit(1);
-    }
+    args[i + 4] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_query_requisites, &data);
+    free(args);
     return future;
 }
 
@@ -134,27 +154,23 @@ char **pkgmgmt_remote_query_requisites_sync(gchar *interface, gchar *target, gch
 
 ProcReact_Future pkgmgmt_remote_print_invalid(gchar *interface, gchar *target, gchar **paths, const unsigned int paths_length)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    PathsData data = { paths, paths_length, -1 };
+    char **args = (char**)malloc((5 + paths_length) * sizeof(char*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((5 + paths_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--print-invalid";
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--print-invalid";
 
-        for(i = 0; i < paths_length; i++)
-            args[i + 4] = paths[i];
+    for(i = 0; i < paths_length; i++)
+        args[i + 4] = paths[i];
 
-        args[i + 4] = NULL;
-
-        dup2(future.fd, 1); /* Attach pipe to the stdout */
-        execvp(interface, args); /* Run process */
-        _exit(1);
-    }
+    args[i + 4] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_print_invalid, &data);
+    free(args);
     return future;
 }
 
@@ -172,16 +188,8 @@ char **pkgmgmt_remote_print_invalid_sync(gchar *interface, gchar *target, gchar
 
 pid_t pkgmgmt_import_local_closure(gchar *interface, gchar *target, char *closure)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        char *const args[] = {interface, "--import", "--target", target, "--localfile", closure, NULL};
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return pid;
+    char *const args[] = {interface, "--import", "--target", target, "--localfile", closure, NULL};
+    return client_interface_spawn(args, -1, -1, -1, 0, local_import_closure, closure);
 }
 
 ProcReact_bool pkgmgmt_import_local_closure_sync(gchar *interface, gchar *target, char *closure)
@@ -192,31 +200,31 @@ ProcReact_bool pkgmgmt_import_local_closure_sync(gchar *interface, gchar *target
     return(status == PROCREACT_STATUS_OK && exit_status);
 }
 
-ProcReact_Future pkgmgmt_export_remote_closure(gchar *interface, gchar *target, char **paths, const unsigned int paths_length)
+pid_t pkgmgmt_import_streamed_closure(gchar *interface, gchar *target, int closure_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_type());
-
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((paths_length + 6) * sizeof(char*));
+    char *const args[] = {interface, "--import", "--target", target, "--stream", NULL};
+    return client_interface_spawn(args, closure_fd, -1, -1, 0, local_import_closure_fd, &closure_fd);
+}
 
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--export";
-        args[4] = "--remotefile";
+ProcReact_Future pkgmgmt_export_remote_closure(gchar *interface, gchar *target, char **paths, const unsigned int paths_length)
+{
+    ProcReact_Future future;
+    unsigned int i;
+    char **args = (char**)malloc((paths_length + 6) * sizeof(char*));
 
-        for(i = 0; i < paths_length; i++)
-            args[i + 5] = paths[i];
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--export";
+    args[4] = "--remotefile";
 
-        args[i + 5] = NULL;
+    for(i = 0; i < paths_length; i++)
+        args[i + 5] = paths[i];
 
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 5] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_type(), args, -1, -1, 0, NULL, NULL);
+    free(args);
     return future;
 }
 
@@ -236,3 +244,26 @@ char *pkgmgmt_export_remote_closure_sync(gchar *interface, gchar *target, char *
     else
         return NULL;
 }
+
+pid_t pkgmgmt_export_remote_closure_stream(gchar *interface, gchar *target, char **paths, const unsigned int paths_length, int closure_fd)
+{
+    pid_t pid;
+    unsigned int i;
+    PathsData data = { paths, paths_length, closure_fd };
+    char **args = (char**)malloc((paths_length + 6) * sizeof(char*));
+
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--export";
+    args[4] = "--stream";
+
+    for(i = 0; i < paths_length; i++)
+        args[i + 5] = paths[i];
+
+    args[i + 5] = NULL;
+
+    pid = client_interface_spawn(args, -1, closure_fd, -1, 0, local_export_closure_fd, &data);
+    free(args);
+    return pid;
+}
@@ -119,6 +119,18 @@ pid_t pkgmgmt_import_local_closure(gchar *interface, gchar *target, char *closur
  */
 ProcReact_bool pkgmgmt_import_local_closure_sync(gchar *interface, gchar *target, char *closure);
 
+/**
+ * Imports a serialization of a closure of Nix store paths on the remote
+ * machine that is streamed from a file descriptor, without storing it in a
+ * temp file on the coordinator machine first.
+ *
+ * @param interface Path to the interface executable
+ * @param target Target Address of the remote interface
+ * @param closure_fd File descriptor from which the serialization is read
+ * @return PID of the process that executes the task
+ */
+pid_t pkgmgmt_import_streamed_closure(gchar *interface, gchar *target, int closure_fd);
+
 /**
  * Exports the closure of Nix stores paths on the remote machine and retrieves the result.
  *
@@ -137,4 +149,18 @@ ProcReact_Future pkgmgmt_export_remote_closure(gchar *interface, gchar *target,
  */
 char *pkgmgmt_export_remote_closure_sync(gchar *interface, gchar *target, char **paths, const unsigned int paths_length);
 
+/**
+ * Exports the closure of Nix store paths on the remote machine and streams
+ * the serialization to a file descriptor, without storing it in a temp file
+ * on the coordinator machine first.
+ *
+ * @param interface Path to the interface executable
+ * @param target Target Address of the remote interface
+ * @param paths Array of Nix store the paths to export
+ * @param paths_length Length of the paths array
+ * @param closure_fd File descriptor to which the serialization is written
+ * @return PID of the process that executes the task
+ */
+pid_t pkgmgmt_export_remote_closure_stream(gchar *interface, gchar *target, char **paths, const unsigned int paths_length, int closure_fd);
+
 #endif
@@ -0,0 +1,211 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "requisites-cache.h"
+#include "package-management.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <procreact_types.h>
+
+/* Amount of seconds after which an entry that has not been used is removed */
+#define REQUISITES_CACHE_MAX_AGE (30 * 24 * 3600)
+
+/* Amount of seconds between two passes that remove unused entries */
+#define REQUISITES_CACHE_PRUNE_INTERVAL (24 * 3600)
+
+/* File of which the modification time indicates when the cache was pruned last */
+#define PRUNE_STAMP_FILE ".last-pruned"
+
+static void prune_requisites_cache(const gchar *requisites_cache_dir)
+{
+    gchar *stamp_path = g_strconcat(requisites_cache_dir, "/" PRUNE_STAMP_FILE, NULL);
+    time_t now = time(NULL);
+    struct stat st;
+
+    /* Only scan the cache directory once per interval */
+    if(stat(stamp_path, &st) == -1 || now - st.st_mtime >= REQUISITES_CACHE_PRUNE_INTERVAL)
+    {
+        DIR *dir;
+
+        g_file_set_contents(stamp_path, "", 0, NULL);
+
+        if((dir = opendir(requisites_cache_dir)) != NULL)
+        {
+            struct dirent *entry;
+
+            while((entry = readdir(dir)) != NULL)
+            {
+                if(entry->d_name[0] != '.') /* Skip ., .. and the stamp file */
+                {
+                    gchar *entry_path = g_strconcat(requisites_cache_dir, "/", entry->d_name, NULL);
+
+                    if(stat(entry_path, &st) == 0 && now - st.st_mtime > REQUISITES_CACHE_MAX_AGE)
+                        unlink(entry_path);
+
+                    g_free(entry_path);
+                }
+            }
+
+            closedir(dir);
+        }
+    }
+
+    g_free(stamp_path);
+}
+
+gchar *pkgmgmt_open_requisites_cache(void)
+{
+    gchar *requisites_cache_dir = g_strconcat(g_get_user_cache_dir(), "/disnix/requisites-cache", NULL);
+
+    if(g_mkdir_with_parents(requisites_cache_dir, 0755) == -1)
+    {
+        g_free(requisites_cache_dir);
+        return NULL;
+    }
+    else
+    {
+        prune_requisites_cache(requisites_cache_dir);
+        return requisites_cache_dir;
+    }
+}
+
+static gchar *compose_cache_entry_path(const gchar *requisites_cache_dir, const gchar *path)
+{
+    gchar *base_name = strrchr(path, '/');
+    return g_strconcat(requisites_cache_dir, "/", base_name == NULL ? path : base_name + 1, NULL);
+}
+
+static gchar **read_cache_entry(const gchar *requisites_cache_dir, const gchar *path)
+{
+    gchar *entry_path = compose_cache_entry_path(requisites_cache_dir, path);
+    gchar *contents;
+    gchar **requisites;
+
+    if(g_file_get_contents(entry_path, &contents, NULL, NULL))
+    {
+        /* A closure always contains the path itself, so an empty entry is invalid */
+        requisites = (contents[0] == '\0') ? NULL : g_strsplit(contents, "\n", -1);
+        g_free(contents);
+
+        /* Refresh the modification time, so that entries that are still in use are not pruned */
+        if(requisites != NULL)
+            utime(entry_path, NULL);
+    }
+    else
+        requisites = NULL;
+
+    g_free(entry_path);
+    return requisites;
+}
+
+static void write_cache_entry(const gchar *requisites_cache_dir, const gchar *path, char **requisites)
+{
+    gchar *entry_path = compose_cache_entry_path(requisites_cache_dir, path);
+    gchar *contents = g_strjoinv("\n", requisites);
+
+    /* Writes happen atomically, so concurrent readers never observe partial entries */
+    g_file_set_contents(entry_path, contents, -1, NULL);
+
+    g_free(contents);
+    g_free(entry_path);
+}
+
+static gchar **query_requisites(const gchar *requisites_cache_dir, gchar *path, int stderr_fd)
+{
+    gchar **requisites = read_cache_entry(requisites_cache_dir, path);
+
+    if(requisites == NULL)
+    {
+        gchar *paths[] = { path, NULL };
+        char **result = pkgmgmt_query_requisites_sync(paths, 1, stderr_fd);
+
+        if(result != NULL)
+        {
+            write_cache_entry(requisites_cache_dir, path, result);
+            requisites = g_strdupv(result);
+            procreact_free_string_array(result);
+        }
+    }
+
+    return requisites;
+}
+
+char **pkgmgmt_query_requisites_cached_sync(const gchar *requisites_cache_dir, gchar **paths, const unsigned int paths_length, int stderr_fd)
+{
+    if(requisites_cache_dir == NULL)
+        return pkgmgmt_query_requisites_sync(paths, paths_length, stderr_fd);
+    else
+    {
+        unsigned int i;
+        GHashTable *visited_table = g_hash_table_new(g_str_hash, g_str_equal);
+        GPtrArray *union_array = g_ptr_array_new();
+        ProcReact_bool success = TRUE;
+        char **result;
+
+        /*
+         * Each closure is in topological order. Appending the requisites that
+         * we have not seen yet preserves this order for the union.
+         */
+        for(i = 0; success && i < paths_length; i++)
+        {
+            gchar **requisites = query_requisites(requisites_cache_dir, paths[i], stderr_fd);
+
+            if(requisites == NULL)
+                success = FALSE;
+            else
+            {
+                unsigned int j;
+
+                for(j = 0; requisites[j] != NULL; j++)
+                {
+                    if(requisites[j][0] != '\0' && !g_hash_table_contains(visited_table, requisites[j]))
+                    {
+                        char *requisite = strdup(requisites[j]);
+                        g_hash_table_add(visited_table, requisite);
+                        g_ptr_array_add(union_array, requisite);
+                    }
+                }
+
+                g_strfreev(requisites);
+            }
+        }
+
+        if(success)
+        {
+            g_ptr_array_add(union_array, NULL);
+            result = (char**)malloc(union_array->len * sizeof(char*));
+            memcpy(result, union_array->pdata, union_array->len * sizeof(char*));
+        }
+        else
+        {
+            g_ptr_array_set_free_func(union_array, free);
+            result = NULL;
+        }
+
+        g_ptr_array_free(union_array, TRUE);
+        g_hash_table_destroy(visited_table);
+        return result;
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_REQUISITES_CACHE_H
+#define __DISNIX_REQUISITES_CACHE_H
+#include <glib.h>
+
+/**
+ * Opens the persistent requisites cache on the coordinator machine, which
+ * resides in the user's cache directory. The cache memorizes the closure of
+ * every Nix store path that was queried before. Because Nix store paths are
+ * immutable, the entries never become outdated. To keep the cache from
+ * growing without bound, entries that have not been used for 30 days are
+ * removed, at most once a day.
+ *
+ * @return Path to the cache directory or NULL if it cannot be created. It should be freed with g_free()
+ */
+gchar *pkgmgmt_open_requisites_cache(void);
+
+/**
+ * Queries the requisites of the given Nix store paths. The requisites of
+ * paths that are in the cache are read from it. The requisites of other
+ * paths are queried from the Nix store and added to the cache.
+ *
+ * @param requisites_cache_dir Path to the cache directory or NULL to query the Nix store directly
+ * @param paths An array of Nix store paths
+ * @param paths_length The length of the paths array
+ * @param stderr_fd File descriptor to attach to the process' standard error
+ * @return A NULL-terminated array with the union of all requisites in topological order, or NULL in case of a failure. It should be freed with procreact_free_string_array()
+ */
+char **pkgmgmt_query_requisites_cached_sync(const gchar *requisites_cache_dir, gchar **paths, const unsigned int paths_length, int stderr_fd);
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "procreact_future_iterator.h"
 #include <stdlib.h>
+#include <poll.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 
@@ -61,31 +62,60 @@ ProcReact_bool procreact_spawn_next_future(ProcReact_FutureIterator *iterator)
         return FALSE;
 }
 
-unsigned int procreact_buffer(ProcReact_FutureIterator *iterator)
+static void complete_future(ProcReact_FutureIterator *iterator, unsigned int i)
 {
-    unsigned int i;
+    ProcReact_Future *future = &iterator->futures[i];
+    ProcReact_Status status;
 
-    /* Buffer the output of all processes breadth first */
-    for(i = 0; i < iterator->running_processes; i++)
-    {
-        ProcReact_Future *future = &iterator->futures[i];
-        ssize_t bytes_read = future->type.append(&future->type, future->state, future->fd);
+    /* Finalize the buffer */
+    future->result = future->type.finalize(future->state, future->pid, &status);
+    iterator->complete(iterator->data, future, status);
 
-        if(bytes_read <= 0)
-        {
-            /* If a process indicates that it's ready, finalize the buffer */
+    /* Destroy the future's resources as we no longer need them */
+    procreact_destroy_future(future);
 
-            ProcReact_Status status;
-            future->result = future->type.finalize(future->state, future->pid, &status);
-            iterator->complete(iterator->data, future, status);
+    /* Put future at the end of the list and decrease the size */
+    iterator->futures[i] = iterator->futures[iterator->running_processes - 1];
+    iterator->running_processes--;
+}
+
+unsigned int procreact_buffer(ProcReact_FutureIterator *iterator)
+{
+    if(iterator->running_processes > 0)
+    {
+        unsigned int i;
+        unsigned int num_of_fds = iterator->running_processes;
+        struct pollfd *fds = (struct pollfd*)malloc(num_of_fds * sizeof(struct pollfd));
 
-            /* Destroy the future's resources as we no longer need them */
-            procreact_destroy_future(future);
+        for(i = 0; i < num_of_fds; i++)
+        {
+            fds[i].fd = iterator->futures[i].fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
 
-            /* Put future at the end of the list and decrease the size */
-            iterator->futures[i] = iterator->futures[iterator->running_processes - 1];
-            iterator->running_processes--;
+        /* Block until at least one of the processes has produced output or closed its pipe */
+        if(poll(fds, num_of_fds, -1) > 0)
+        {
+            /*
+             * Only read from the pipes that are ready. We traverse the futures
+             * in reverse order, because completing a future moves the last
+             * future into its slot.
+             */
+            for(i = num_of_fds; i > 0; i--)
+            {
+                if(fds[i - 1].revents != 0)
+                {
+                    ProcReact_Future *future = &iterator->futures[i - 1];
+                    ssize_t bytes_read = future->type.append(&future->type, future->state, future->fd);
+
+                    if(bytes_read <= 0)
+                        complete_future(iterator, i - 1); /* If a process indicates that it's ready, finalize the buffer */
+                }
+            }
         }
+
+        free(fds);
     }
 
     return iterator->running_processes;
@@ -116,8 +116,11 @@ void procreact_destroy_future_iterator(ProcReact_FutureIterator *iterator);
 ProcReact_bool procreact_spawn_next_future(ProcReact_FutureIterator *iterator);
 
 /**
- * Reads the data from the read-end of each pipe of a running process and
- * buffers their state.
+ * Waits until the read-end of at least one pipe of a running process has
+ * data available or has been closed, then reads the data from the pipes that
+ * are ready and buffers their state. Processes whose pipes have reached the
+ * end are finalized. A slow process therefore does not block capturing the
+ * output of the others.
  *
  * @param iterator Future iterator
  * @return The amount of running processes
@@ -22,13 +22,14 @@
 #include "procreact_pid_iterator.h"
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <stdint.h>
 
 #define TRUE 1
 #define FALSE 0
 
 ProcReact_PidIterator procreact_initialize_pid_iterator(ProcReact_PidIteratorHasNext has_next, ProcReact_PidIteratorNext next, ProcReact_RetrieveResult retrieve, ProcReact_PidIteratorComplete complete, void *data)
 {
-    ProcReact_PidIterator iterator = { has_next, next, retrieve, complete, data, 0 };
+    ProcReact_PidIterator iterator = { has_next, next, retrieve, complete, data, 0, procreact_initialize_pid_set() };
     return iterator;
 }
 
@@ -41,7 +42,11 @@ ProcReact_bool procreact_spawn_next_pid(ProcReact_PidIterator *iterator)
         if(pid == -1)
             iterator->complete(iterator->data, pid, PROCREACT_STATUS_FORK_FAIL, -1);
         else
+        {
+            /* Remember the PID as data, so that a process that cannot be waited for can still be completed */
+            procreact_add_pid(&iterator->pid_set, pid, (void*)(intptr_t)pid);
             iterator->running_processes++;
+        }
 
         return TRUE;
     }
@@ -49,28 +54,47 @@ ProcReact_bool procreact_spawn_next_pid(ProcReact_PidIterator *iterator)
         return FALSE;
 }
 
-ProcReact_bool procreact_wait_for_process_to_complete(ProcReact_PidIterator *iterator)
+static void complete_pid(ProcReact_PidIterator *iterator, pid_t pid, ProcReact_Status status, int result)
 {
-    if(iterator->running_processes > 0)
+    iterator->running_processes--;
+
+    if(iterator->running_processes == 0)
+        procreact_destroy_pid_set(&iterator->pid_set); /* Release the resources of the set as soon as it becomes empty */
+
+    iterator->complete(iterator->data, pid, status, result);
+}
+
+ProcReact_bool procreact_complete_pid_in_set(ProcReact_PidIterator *iterator, pid_t pid, int wstatus, void *data)
+{
+    if(pid > 0)
     {
-        int wstatus, result;
         ProcReact_Status status;
+        int result = iterator->retrieve(pid, wstatus, &status);
+        complete_pid(iterator, pid, status, result);
+        return TRUE;
+    }
+    else if(data != NULL)
+    {
+        /* The process could not be waited for and has been removed from the set. Complete it as a failure. */
+        complete_pid(iterator, (pid_t)(intptr_t)data, PROCREACT_STATUS_WAIT_FAIL, -1);
+        return TRUE;
+    }
+    else
+        return FALSE;
+}
 
-        /* Wait for one of the processes to finish */
-        pid_t pid = wait(&wstatus);
+ProcReact_bool procreact_wait_for_process_to_complete(ProcReact_PidIterator *iterator)
+{
+    if(iterator->running_processes > 0)
+    {
+        int wstatus;
+        void *data;
 
-        if(pid > 0)
-        {
-            result = iterator->retrieve(pid, wstatus, &status);
-            iterator->running_processes--;
-        }
-        else
-        {
-            status = PROCREACT_STATUS_WAIT_FAIL;
-            result = 1;
-        }
+        /* Wait for one of the processes spawned by this iterator to finish */
+        pid_t pid = procreact_wait_for_pid_in_set(&iterator->pid_set, &wstatus, &data);
 
-        iterator->complete(iterator->data, pid, status, result);
+        /* If the wait was interrupted, nothing has completed and we simply try again */
+        procreact_complete_pid_in_set(iterator, pid, wstatus, data);
 
         return TRUE;
     }
@@ -29,6 +29,7 @@
 #ifndef __PROCREACT_PID_ITERATOR_H
 #define __PROCREACT_PID_ITERATOR_H
 #include "procreact_pid.h"
+#include "procreact_pid_set.h"
 #include "procreact_util.h"
 
 /** Pointer to a function that determines whether there is a next element in the collection */
@@ -90,6 +91,9 @@ struct ProcReact_PidIterator
 
     /** Memorizes the amount of processes running concurrently */
     unsigned int running_processes;
+
+    /** Memorizes the processes spawned by this iterator, so that only these are waited for */
+    ProcReact_PidSet pid_set;
 };
 
 /**
@@ -113,13 +117,28 @@ ProcReact_PidIterator procreact_initialize_pid_iterator(ProcReact_PidIteratorHas
 ProcReact_bool procreact_spawn_next_pid(ProcReact_PidIterator *iterator);
 
 /**
- * Waits for any process to complete and executes its corresponding complete callback.
+ * Waits for any process spawned by the iterator to complete and executes its
+ * corresponding complete callback. Processes that have not been spawned by the
+ * iterator are not reaped.
  *
  * @param iterator PID iterator
  * @return TRUE if there are any running processes completed, else FALSE
  */
 ProcReact_bool procreact_wait_for_process_to_complete(ProcReact_PidIterator *iterator);
 
+/**
+ * Completes a process that has been removed from the iterator's PID set by
+ * executing its corresponding complete callback. A process that could not be
+ * waited for is completed with a PROCREACT_STATUS_WAIT_FAIL status.
+ *
+ * @param iterator PID iterator
+ * @param pid PID returned by a wait on the iterator's PID set
+ * @param wstatus Wait status of the terminated process
+ * @param data Data structure returned by a wait on the iterator's PID set
+ * @return TRUE if a process was completed, else FALSE
+ */
+ProcReact_bool procreact_complete_pid_in_set(ProcReact_PidIterator *iterator, pid_t pid, int wstatus, void *data);
+
 /**
  * Spawns all processes in a collection in parallel and waits for their
  * completion.
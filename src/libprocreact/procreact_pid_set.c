@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2016-2022 Sander van der Burg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "procreact_pid_set.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define TRUE 1
+#define FALSE 0
+
+/* Interval in nanoseconds to back off when a process outside of the set has terminated */
+#define FOREIGN_CHILD_BACKOFF 10000000
+
+static int open_pidfd(pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    return -1;
+#endif
+}
+
+ProcReact_PidSet procreact_initialize_pid_set(void)
+{
+    ProcReact_PidSet pid_set = { NULL, NULL, NULL, 0 };
+    return pid_set;
+}
+
+void procreact_destroy_pid_set(ProcReact_PidSet *pid_set)
+{
+    unsigned int i;
+
+    for(i = 0; i < pid_set->length; i++)
+    {
+        if(pid_set->pidfds[i] != -1)
+            close(pid_set->pidfds[i]);
+    }
+
+    free(pid_set->pids);
+    free(pid_set->pidfds);
+    free(pid_set->data);
+
+    *pid_set = procreact_initialize_pid_set();
+}
+
+void procreact_add_pid(ProcReact_PidSet *pid_set, pid_t pid, void *data)
+{
+    pid_set->length++;
+    pid_set->pids = (pid_t*)realloc(pid_set->pids, pid_set->length * sizeof(pid_t));
+    pid_set->pidfds = (int*)realloc(pid_set->pidfds, pid_set->length * sizeof(int));
+    pid_set->data = (void**)realloc(pid_set->data, pid_set->length * sizeof(void*));
+
+    pid_set->pids[pid_set->length - 1] = pid;
+    pid_set->pidfds[pid_set->length - 1] = open_pidfd(pid);
+    pid_set->data[pid_set->length - 1] = data;
+}
+
+static void remove_pid_from_set(ProcReact_PidSet *pid_set, unsigned int i, void **data)
+{
+    *data = pid_set->data[i];
+
+    if(pid_set->pidfds[i] != -1)
+        close(pid_set->pidfds[i]);
+
+    /* Move the last element into the slot of the removed process */
+    pid_set->length--;
+    pid_set->pids[i] = pid_set->pids[pid_set->length];
+    pid_set->pidfds[i] = pid_set->pidfds[pid_set->length];
+    pid_set->data[i] = pid_set->data[pid_set->length];
+}
+
+static pid_t reap_pid_in_set(ProcReact_PidSet *pid_set, unsigned int i, int *wstatus, void **data)
+{
+    pid_t pid = waitpid(pid_set->pids[i], wstatus, 0);
+
+    if(pid == -1 && errno == EINTR)
+        return -1; /* Keep the process in the set, so that it can be waited for again */
+
+    remove_pid_from_set(pid_set, i, data);
+    return pid;
+}
+
+static ProcReact_bool has_pidfds(const ProcReact_PidSet *pid_set)
+{
+    unsigned int i;
+
+    for(i = 0; i < pid_set->length; i++)
+    {
+        if(pid_set->pidfds[i] == -1)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static pid_t wait_for_pidfd_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data)
+{
+    unsigned int i;
+    pid_t pid = -1;
+    struct pollfd *fds = (struct pollfd*)malloc(pid_set->length * sizeof(struct pollfd));
+
+    for(i = 0; i < pid_set->length; i++)
+    {
+        fds[i].fd = pid_set->pidfds[i];
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    /* A pidfd becomes readable when the process terminates */
+    if(poll(fds, pid_set->length, -1) > 0)
+    {
+        for(i = 0; i < pid_set->length; i++)
+        {
+            if(fds[i].revents != 0)
+            {
+                pid = reap_pid_in_set(pid_set, i, wstatus, data);
+                break;
+            }
+        }
+    }
+
+    free(fds);
+    return pid;
+}
+
+static pid_t scan_pids_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data)
+{
+    while(TRUE)
+    {
+        unsigned int i;
+        siginfo_t info;
+
+        /* Check whether any of our own processes have terminated */
+        for(i = 0; i < pid_set->length; i++)
+        {
+            pid_t pid = waitpid(pid_set->pids[i], wstatus, WNOHANG);
+
+            if(pid != 0)
+            {
+                remove_pid_from_set(pid_set, i, data);
+                return pid;
+            }
+        }
+
+        /* Block until any child terminates, without reaping it */
+        info.si_pid = 0;
+
+        if(waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == -1)
+            return -1;
+        else
+        {
+            /* If a child outside of the set terminated, give its owner the opportunity to reap it */
+            ProcReact_bool found = FALSE;
+
+            for(i = 0; i < pid_set->length; i++)
+            {
+                if(pid_set->pids[i] == info.si_pid)
+                {
+                    found = TRUE;
+                    break;
+                }
+            }
+
+            if(!found)
+            {
+                struct timespec backoff = { 0, FOREIGN_CHILD_BACKOFF };
+                nanosleep(&backoff, NULL);
+            }
+        }
+    }
+}
+
+pid_t procreact_wait_for_pid_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data)
+{
+    *data = NULL;
+
+    if(pid_set->length == 0)
+    {
+        errno = ECHILD;
+        return -1;
+    }
+    else if(has_pidfds(pid_set))
+        return wait_for_pidfd_in_set(pid_set, wstatus, data);
+    else
+        return scan_pids_in_set(pid_set, wstatus, data); /* Fallback for systems without pidfd support */
+}
+
+pid_t procreact_try_wait_for_pid_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data)
+{
+    unsigned int i;
+
+    *data = NULL;
+
+    for(i = 0; i < pid_set->length; i++)
+    {
+        pid_t pid = waitpid(pid_set->pids[i], wstatus, WNOHANG);
+
+        if(pid == -1 && errno == EINTR)
+            return -1; /* Keep the process in the set, so that it can be waited for again */
+        else if(pid != 0)
+        {
+            remove_pid_from_set(pid_set, i, data);
+            return pid;
+        }
+    }
+
+    return 0;
+}
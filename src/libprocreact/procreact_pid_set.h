@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016-2022 Sander van der Burg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief PID set module
+ * @defgroup PidSet
+ * @{
+ */
+
+#ifndef __PROCREACT_PID_SET_H
+#define __PROCREACT_PID_SET_H
+#include <unistd.h>
+#include "procreact_util.h"
+
+/**
+ * @brief Keeps track of a collection of processes that have been spawned by the same owner.
+ *
+ * Waiting on a PID set only collects processes that belong to the set, so
+ * that several sets can be used in the same process without reaping each
+ * other's children. On Linux, each process is tracked with a process file
+ * descriptor (pidfd) that can be polled for termination.
+ */
+typedef struct
+{
+    /** Array of PIDs of the processes in the set */
+    pid_t *pids;
+    /** Array of process file descriptors, or -1 if a process has none */
+    int *pidfds;
+    /** Array of arbitrary data structures associated with each process */
+    void **data;
+    /** Amount of processes in the set */
+    unsigned int length;
+}
+ProcReact_PidSet;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes an empty PID set.
+ *
+ * @return A PID set struct
+ */
+ProcReact_PidSet procreact_initialize_pid_set(void);
+
+/**
+ * Clears all resources allocated with a PID set. Processes that are still in
+ * the set are not waited for.
+ *
+ * @param pid_set A PID set
+ */
+void procreact_destroy_pid_set(ProcReact_PidSet *pid_set);
+
+/**
+ * Adds a process to a PID set.
+ *
+ * @param pid_set A PID set
+ * @param pid PID of a process spawned by the caller
+ * @param data Arbitrary data structure that is returned when the process completes
+ */
+void procreact_add_pid(ProcReact_PidSet *pid_set, pid_t pid, void *data);
+
+/**
+ * Waits for any of the processes in the set to terminate, reaps it and
+ * removes it from the set. Processes that do not belong to the set are left
+ * alone.
+ *
+ * @param pid_set A PID set
+ * @param wstatus Wait status of the terminated process
+ * @param data Will be set to the data structure associated with the terminated process. If waiting for a process in the set failed, it is removed from the set, -1 is returned and data is set to its data structure. Otherwise, data is set to NULL when -1 is returned
+ * @return PID of the terminated process or -1 if the wait failed or the set is empty
+ */
+pid_t procreact_wait_for_pid_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data);
+
+/**
+ * Reaps any of the processes in the set that have already terminated without
+ * blocking, and removes it from the set.
+ *
+ * @param pid_set A PID set
+ * @param wstatus Wait status of the terminated process
+ * @param data Will be set to the data structure associated with the terminated process. If waiting for a process in the set failed, it is removed from the set, -1 is returned and data is set to its data structure. Otherwise, data is set to NULL
+ * @return PID of the terminated process, 0 if none of the processes have terminated, or -1 if the wait failed
+ */
+pid_t procreact_try_wait_for_pid_in_set(ProcReact_PidSet *pid_set, int *wstatus, void **data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**
+ * @}
+ */
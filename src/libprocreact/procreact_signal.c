@@ -21,8 +21,6 @@
 
 #include "procreact_signal.h"
 #include <signal.h>
-#include <sys/wait.h>
-#include <sys/types.h>
 
 #define TRUE 1
 #define FALSE 0
@@ -53,17 +51,15 @@ void procreact_complete_all_finished_processes(ProcReact_PidIterator *iterator)
 
         if(iterator->running_processes > 0)
         {
-            int wstatus, result;
-            ProcReact_Status status;
-            pid_t pid;
+            ProcReact_bool completed = TRUE;
 
-            /* Complete all finished processes */
-
-            while((pid = waitpid(-1, &wstatus, WNOHANG)) > 0)
+            /* Complete all finished processes that have been spawned by the iterator */
+            while(completed && iterator->running_processes > 0)
             {
-                result = iterator->retrieve(pid, wstatus, &status);
-                iterator->running_processes--;
-                iterator->complete(iterator->data, pid, status, result);
+                int wstatus;
+                void *data;
+                pid_t pid = procreact_try_wait_for_pid_in_set(&iterator->pid_set, &wstatus, &data);
+                completed = procreact_complete_pid_in_set(iterator, pid, wstatus, data);
             }
         }
     }
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2016-2022 Sander van der Burg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "procreact_spawn.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <spawn.h>
+
+#define TRUE 1
+#define FALSE 0
+
+extern char **environ;
+
+static int attach_fd(posix_spawn_file_actions_t *file_actions, int fd, int target_fd)
+{
+    if(fd == -1 || fd == target_fd)
+        return 0;
+    else
+        return posix_spawn_file_actions_adddup2(file_actions, fd, target_fd);
+}
+
+pid_t procreact_spawn(char *const *args, char *const *envp, int stdin_fd, int stdout_fd, int stderr_fd, unsigned int flags)
+{
+    pid_t pid;
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attr;
+
+    if(posix_spawn_file_actions_init(&file_actions) != 0)
+        return -1;
+
+    if(posix_spawnattr_init(&attr) != 0)
+    {
+        posix_spawn_file_actions_destroy(&file_actions);
+        return -1;
+    }
+
+    if(attach_fd(&file_actions, stdin_fd, 0) != 0
+      || attach_fd(&file_actions, stdout_fd, 1) != 0
+      || attach_fd(&file_actions, stderr_fd, 2) != 0
+      || ((flags & PROCREACT_SPAWN_NEW_PROCESS_GROUP)
+        && (posix_spawnattr_setpgroup(&attr, 0) != 0 || posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP) != 0))
+      || posix_spawnp(&pid, args[0], &file_actions, &attr, args, envp == NULL ? environ : envp) != 0)
+        pid = -1;
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&file_actions);
+    return pid;
+}
+
+ProcReact_Future procreact_spawn_future(ProcReact_Type type, char *const *args, char *const *envp, int stdin_fd, int stderr_fd, unsigned int flags)
+{
+    ProcReact_Future future;
+    int pipefd[2];
+
+    future.type = type;
+    future.result = NULL;
+
+    if(pipe(pipefd) == 0)
+    {
+        /* Do not leak the read-end into the spawned process or any other process spawned in the meantime */
+        fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+
+        future.pid = procreact_spawn(args, envp, stdin_fd, pipefd[1], stderr_fd, flags);
+        close(pipefd[1]); /* Close write-end of pipe */
+
+        if(future.pid == -1)
+        {
+            close(pipefd[0]);
+            future.fd = -1;
+        }
+        else
+            future.fd = pipefd[0];
+    }
+    else
+    {
+        future.pid = -1;
+        future.fd = -1;
+    }
+
+    return future;
+}
+
+static ProcReact_bool is_overridden(const char *variable, char *const *variables)
+{
+    const char *separator = strchr(variable, '=');
+    size_t name_length = (separator == NULL) ? strlen(variable) : (size_t)(separator - variable);
+    unsigned int i;
+
+    for(i = 0; variables[i] != NULL; i++)
+    {
+        if(strncmp(variables[i], variable, name_length) == 0 && variables[i][name_length] == '=')
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+char **procreact_compose_environment(char *const *variables)
+{
+    unsigned int num_of_variables = 0, num_of_environ = 0, count = 0, i;
+    char **envp;
+
+    while(variables[num_of_variables] != NULL)
+        num_of_variables++;
+
+    while(environ[num_of_environ] != NULL)
+        num_of_environ++;
+
+    envp = (char**)malloc((num_of_variables + num_of_environ + 1) * sizeof(char*));
+
+    if(envp != NULL)
+    {
+        for(i = 0; i < num_of_variables; i++)
+            envp[count++] = variables[i];
+
+        for(i = 0; i < num_of_environ; i++)
+        {
+            if(!is_overridden(environ[i], variables))
+                envp[count++] = environ[i];
+        }
+
+        envp[count] = NULL;
+    }
+
+    return envp;
+}
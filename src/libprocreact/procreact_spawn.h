@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2016-2022 Sander van der Burg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Spawn module
+ * @defgroup Spawn
+ * @{
+ */
+
+#ifndef __PROCREACT_SPAWN_H
+#define __PROCREACT_SPAWN_H
+#include <unistd.h>
+#include "procreact_future.h"
+#include "procreact_types.h"
+
+/** Makes the spawned process the leader of a new process group */
+#define PROCREACT_SPAWN_NEW_PROCESS_GROUP 0x1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Spawns a process that executes a program that is looked up in the PATH.
+ * In contrast to fork() followed by exec(), the caller's address space does
+ * not get duplicated, so the costs of launching a process do not depend on
+ * the size of the caller's heap.
+ *
+ * @param args NULL-terminated argument vector in which the first element refers to the program to execute
+ * @param envp NULL-terminated array of environment variables or NULL to inherit the caller's environment
+ * @param stdin_fd File descriptor to attach to the standard input or -1 to inherit it
+ * @param stdout_fd File descriptor to attach to the standard output or -1 to inherit it
+ * @param stderr_fd File descriptor to attach to the standard error or -1 to inherit it
+ * @param flags Bitwise OR of PROCREACT_SPAWN_* flags
+ * @return The PID of the spawned process or -1 if the process could not be spawned
+ */
+pid_t procreact_spawn(char *const *args, char *const *envp, int stdin_fd, int stdout_fd, int stderr_fd, unsigned int flags);
+
+/**
+ * Spawns a process that executes a program that is looked up in the PATH and
+ * returns a future that captures its standard output.
+ *
+ * @param type Type where the read data will be converted to
+ * @param args NULL-terminated argument vector in which the first element refers to the program to execute
+ * @param envp NULL-terminated array of environment variables or NULL to inherit the caller's environment
+ * @param stdin_fd File descriptor to attach to the standard input or -1 to inherit it
+ * @param stderr_fd File descriptor to attach to the standard error or -1 to inherit it
+ * @param flags Bitwise OR of PROCREACT_SPAWN_* flags
+ * @return A future struct. The pid and fd members are -1 if the process could not be spawned.
+ */
+ProcReact_Future procreact_spawn_future(ProcReact_Type type, char *const *args, char *const *envp, int stdin_fd, int stderr_fd, unsigned int flags);
+
+/**
+ * Composes an environment consisting of the given variables followed by
+ * all variables of the caller's environment that are not overridden.
+ *
+ * @param variables NULL-terminated array of NAME=VALUE strings
+ * @return A NULL-terminated array of environment variables that should be released with free(). The strings themselves are not copied.
+ */
+char **procreact_compose_environment(char *const *variables);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,346 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "activity-batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <procreact_pid.h>
+#include <procreact_pid_set.h>
+#include "state-management.h"
+
+#define BUFFER_SIZE 4096
+
+/* The first fields of a batch line: stage, activity, type, container and component */
+#define NUM_OF_FIXED_FIELDS 5
+
+ActivityBatchItem *create_activity_batch_item(guint stage, const gchar *activity, const gchar *type, const gchar *container, gchar **arguments, const unsigned int arguments_size, const gchar *component)
+{
+    unsigned int i;
+    ActivityBatchItem *item = (ActivityBatchItem*)g_malloc(sizeof(ActivityBatchItem));
+
+    item->stage = stage;
+    item->activity = g_strdup(activity);
+    item->type = g_strdup(type);
+    item->container = g_strdup(container);
+    item->component = g_strdup(component);
+    item->arguments = (gchar**)g_malloc((arguments_size + 1) * sizeof(gchar*));
+
+    for(i = 0; i < arguments_size; i++)
+        item->arguments[i] = g_strdup(arguments[i]);
+
+    item->arguments[i] = NULL;
+
+    return item;
+}
+
+void delete_activity_batch_item(ActivityBatchItem *item)
+{
+    if(item != NULL)
+    {
+        g_free(item->activity);
+        g_free(item->type);
+        g_free(item->container);
+        g_free(item->component);
+        g_strfreev(item->arguments);
+        g_free(item);
+    }
+}
+
+void delete_activity_batch(GPtrArray *batch)
+{
+    if(batch != NULL)
+    {
+        unsigned int i;
+
+        for(i = 0; i < batch->len; i++)
+            delete_activity_batch_item(g_ptr_array_index(batch, i));
+
+        g_ptr_array_free(batch, TRUE);
+    }
+}
+
+statemgmt_activity_function statemgmt_lookup_activity(const gchar *activity)
+{
+    if(g_strcmp0(activity, "activate") == 0)
+        return statemgmt_activate;
+    else if(g_strcmp0(activity, "deactivate") == 0)
+        return statemgmt_deactivate;
+    else if(g_strcmp0(activity, "snapshot") == 0)
+        return statemgmt_snapshot;
+    else if(g_strcmp0(activity, "restore") == 0)
+        return statemgmt_restore;
+    else if(g_strcmp0(activity, "delete-state") == 0)
+        return statemgmt_collect_garbage;
+    else
+        return NULL;
+}
+
+gboolean statemgmt_check_activity_batch(const GPtrArray *batch)
+{
+    unsigned int i;
+
+    for(i = 0; i < batch->len; i++)
+    {
+        ActivityBatchItem *item = g_ptr_array_index(batch, i);
+
+        if(statemgmt_lookup_activity(item->activity) == NULL)
+        {
+            g_printerr("Activity: %s of item: %u cannot be executed as part of a batch!\n", item->activity, i);
+            return FALSE;
+        }
+
+        if(item->type == NULL || item->container == NULL || item->component == NULL)
+        {
+            g_printerr("Item: %u of the batch requires a type, container and component!\n", i);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void write_field(FILE *file, const gchar *field)
+{
+    gchar *escaped_field = g_strescape(field, NULL);
+    fprintf(file, "\t%s", escaped_field);
+    g_free(escaped_field);
+}
+
+gboolean statemgmt_write_activity_batch(FILE *file, const GPtrArray *batch)
+{
+    unsigned int i;
+
+    for(i = 0; i < batch->len; i++)
+    {
+        ActivityBatchItem *item = g_ptr_array_index(batch, i);
+        unsigned int j;
+
+        fprintf(file, "%u", item->stage);
+        write_field(file, item->activity);
+        write_field(file, item->type);
+        write_field(file, item->container);
+        write_field(file, item->component);
+
+        for(j = 0; item->arguments[j] != NULL; j++)
+            write_field(file, item->arguments[j]);
+
+        fputc('\n', file);
+    }
+
+    return (fflush(file) == 0 && !ferror(file));
+}
+
+static gchar **read_lines(FILE *file)
+{
+    char buf[BUFFER_SIZE];
+    size_t bytes_read;
+    GString *contents = g_string_new("");
+    gchar **lines;
+
+    while((bytes_read = fread(buf, 1, BUFFER_SIZE, file)) > 0)
+        g_string_append_len(contents, buf, bytes_read);
+
+    if(ferror(file))
+        lines = NULL;
+    else
+        lines = g_strsplit(contents->str, "\n", -1);
+
+    g_string_free(contents, TRUE);
+    return lines;
+}
+
+static ActivityBatchItem *parse_activity_batch_line(const gchar *line)
+{
+    gchar **fields = g_strsplit(line, "\t", -1);
+    ActivityBatchItem *item;
+    char *end;
+    unsigned int i, num_of_fields = g_strv_length(fields);
+    guint64 stage;
+
+    if(num_of_fields < NUM_OF_FIXED_FIELDS)
+    {
+        g_strfreev(fields);
+        return NULL;
+    }
+
+    stage = g_ascii_strtoull(fields[0], &end, 10);
+
+    if(*fields[0] == '\0' || *end != '\0' || stage > G_MAXUINT)
+    {
+        g_strfreev(fields);
+        return NULL;
+    }
+
+    /* Unescape all fields */
+    for(i = 1; i < num_of_fields; i++)
+    {
+        gchar *field = g_strcompress(fields[i]);
+        g_free(fields[i]);
+        fields[i] = field;
+    }
+
+    item = create_activity_batch_item((guint)stage, fields[1], fields[2], fields[3], fields + NUM_OF_FIXED_FIELDS, num_of_fields - NUM_OF_FIXED_FIELDS, fields[4]);
+    g_strfreev(fields);
+    return item;
+}
+
+GPtrArray *statemgmt_read_activity_batch(FILE *file)
+{
+    gchar **lines = read_lines(file);
+    GPtrArray *batch;
+    unsigned int i;
+
+    if(lines == NULL)
+        return NULL;
+
+    batch = g_ptr_array_new();
+
+    for(i = 0; lines[i] != NULL; i++)
+    {
+        ActivityBatchItem *item;
+
+        if(*lines[i] == '\0')
+            continue; /* Skip empty lines, such as the one following the last newline */
+
+        item = parse_activity_batch_line(lines[i]);
+
+        if(item == NULL)
+        {
+            g_printerr("Malformed activity batch at line: %u\n", i + 1);
+            delete_activity_batch(batch);
+            batch = NULL;
+            break;
+        }
+
+        g_ptr_array_add(batch, item);
+    }
+
+    g_strfreev(lines);
+    return batch;
+}
+
+void statemgmt_print_activity_batch_result(FILE *file, guint index, gboolean result)
+{
+    fprintf(file, "%u %s\n", index, result ? "ok" : "failed");
+    fflush(file);
+}
+
+gboolean *statemgmt_read_activity_batch_results(FILE *file, const unsigned int batch_size)
+{
+    gboolean *results = (gboolean*)g_malloc0(batch_size * sizeof(gboolean));
+    gchar **lines = read_lines(file);
+
+    if(lines != NULL)
+    {
+        unsigned int i;
+
+        for(i = 0; lines[i] != NULL; i++)
+        {
+            char *end;
+            guint64 index = g_ascii_strtoull(lines[i], &end, 10);
+
+            if(end != lines[i] && index < batch_size && strcmp(end, " ok") == 0)
+                results[index] = TRUE;
+        }
+
+        g_strfreev(lines);
+    }
+
+    return results;
+}
+
+gboolean statemgmt_next_activity_batch_stage(const GPtrArray *batch, guint stage, gboolean first, guint *next_stage)
+{
+    unsigned int i;
+    gboolean found = FALSE;
+
+    for(i = 0; i < batch->len; i++)
+    {
+        ActivityBatchItem *item = g_ptr_array_index(batch, i);
+
+        if((first || item->stage > stage) && (!found || item->stage < *next_stage))
+        {
+            *next_stage = item->stage;
+            found = TRUE;
+        }
+    }
+
+    return found;
+}
+
+gboolean statemgmt_run_activity_batch(const GPtrArray *batch, int stdout_fd, int stderr_fd, FILE *results_file)
+{
+    gboolean success = TRUE;
+    guint stage = 0;
+    gboolean has_stage = statemgmt_next_activity_batch_stage(batch, 0, TRUE, &stage);
+
+    while(has_stage)
+    {
+        ProcReact_PidSet pid_set = procreact_initialize_pid_set();
+        unsigned int i;
+
+        /* Start all activities of the current stage */
+        for(i = 0; i < batch->len; i++)
+        {
+            ActivityBatchItem *item = g_ptr_array_index(batch, i);
+
+            if(item->stage == stage)
+            {
+                pid_t pid = -1;
+
+                if(success)
+                    pid = statemgmt_lookup_activity(item->activity)(item->type, item->component, item->container, item->arguments, stdout_fd, stderr_fd);
+
+                if(pid == -1)
+                {
+                    /* Activities that could not be started, or that follow a failed stage, are reported as failed */
+                    statemgmt_print_activity_batch_result(results_file, i, FALSE);
+                    success = FALSE;
+                }
+                else
+                    procreact_add_pid(&pid_set, pid, GUINT_TO_POINTER(i + 1)); /* Offset the index, so that the data is never NULL */
+            }
+        }
+
+        /* Wait for the activities of the current stage to complete */
+        while(pid_set.length > 0)
+        {
+            int wstatus;
+            void *data;
+            pid_t pid = procreact_wait_for_pid_in_set(&pid_set, &wstatus, &data);
+
+            if(data != NULL) /* A process that could not be waited for is reported as failed */
+            {
+                ProcReact_Status status;
+                ProcReact_bool result = procreact_retrieve_boolean(pid, wstatus, &status);
+                result = (status == PROCREACT_STATUS_OK && result);
+
+                statemgmt_print_activity_batch_result(results_file, GPOINTER_TO_UINT(data) - 1, result);
+
+                if(!result)
+                    success = FALSE;
+            }
+        }
+
+        procreact_destroy_pid_set(&pid_set);
+        has_stage = statemgmt_next_activity_batch_stage(batch, stage, FALSE, &stage);
+    }
+
+    return success;
+}
@@ -0,0 +1,166 @@
+/*
+ * Disnix - A Nix-based distributed service deployment tool
+ * Copyright (C) 2008-2022  Sander van der Burg
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __DISNIX_ACTIVITY_BATCH_H
+#define __DISNIX_ACTIVITY_BATCH_H
+#include <stdio.h>
+#include <glib.h>
+#include <unistd.h>
+
+/**
+ * Pointer to a function that asynchronously executes a Dysnomia activity.
+ *
+ * @param type Name of the type of the service
+ * @param component Path to the component to carry out the activity for
+ * @param container Name of the container in which the component is deployed
+ * @param arguments A NULL-terminated array of key=value pairs that are passed as environment variables to the Dysnomia module
+ * @param stdout_fd File descriptor to attach to the process' standard output
+ * @param stderr_fd File descriptor to attach to the process' standard error
+ * @return The PID of the process executing the activity
+ */
+typedef pid_t (*statemgmt_activity_function) (gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd);
+
+/**
+ * @brief Captures the properties of a Dysnomia activity that is executed as part of a batch
+ */
+typedef struct
+{
+    /** Activities in the same stage may run in parallel. Stages run in ascending order */
+    guint stage;
+    /** Name of the activity: activate, deactivate, snapshot, restore or delete-state */
+    gchar *activity;
+    /** Name of the type of the service */
+    gchar *type;
+    /** Name of the container in which the component is deployed */
+    gchar *container;
+    /** NULL-terminated array of key=value pairs that are passed to the Dysnomia module */
+    gchar **arguments;
+    /** Path to the component to carry out the activity for */
+    gchar *component;
+}
+ActivityBatchItem;
+
+/**
+ * Creates a new activity batch item.
+ *
+ * @param stage Stage in which the activity is executed
+ * @param activity Name of the activity
+ * @param type Name of the type of the service
+ * @param container Name of the container in which the component is deployed
+ * @param arguments Array of key=value pairs that are passed to the Dysnomia module
+ * @param arguments_size Length of the arguments array
+ * @param component Path to the component to carry out the activity for
+ * @return An activity batch item that should be freed with delete_activity_batch_item()
+ */
+ActivityBatchItem *create_activity_batch_item(guint stage, const gchar *activity, const gchar *type, const gchar *container, gchar **arguments, const unsigned int arguments_size, const gchar *component);
+
+/**
+ * Deletes an activity batch item and all its properties from heap memory.
+ *
+ * @param item An activity batch item
+ */
+void delete_activity_batch_item(ActivityBatchItem *item);
+
+/**
+ * Deletes an array of activity batch items from heap memory.
+ *
+ * @param batch An array of activity batch items
+ */
+void delete_activity_batch(GPtrArray *batch);
+
+/**
+ * Looks up the function that executes a given activity.
+ *
+ * @param activity Name of the activity
+ * @return Pointer to a function executing the activity or NULL if the activity is not supported in a batch
+ */
+statemgmt_activity_function statemgmt_lookup_activity(const gchar *activity);
+
+/**
+ * Checks whether all items in a batch are valid.
+ *
+ * @param batch An array of activity batch items
+ * @return TRUE if all items are valid, else FALSE
+ */
+gboolean statemgmt_check_activity_batch(const GPtrArray *batch);
+
+/**
+ * Writes a batch of activities to a file. Every activity is written on a
+ * separate line consisting of tab-separated, escaped fields: the stage, the
+ * activity, the type, the container, the component and its arguments.
+ *
+ * @param file File to write the batch to
+ * @param batch An array of activity batch items
+ * @return TRUE if the batch was successfully written, else FALSE
+ */
+gboolean statemgmt_write_activity_batch(FILE *file, const GPtrArray *batch);
+
+/**
+ * Reads a batch of activities from a file.
+ *
+ * @param file File to read the batch from
+ * @return An array of activity batch items or NULL if the batch is malformed. The array should be freed with delete_activity_batch()
+ */
+GPtrArray *statemgmt_read_activity_batch(FILE *file);
+
+/**
+ * Writes the outcome of an activity in a batch to a file.
+ *
+ * @param file File to write the outcome to
+ * @param index Index of the activity in the batch
+ * @param result TRUE if the activity succeeded, else FALSE
+ */
+void statemgmt_print_activity_batch_result(FILE *file, guint index, gboolean result);
+
+/**
+ * Reads the outcomes of the activities in a batch from a file. Activities of
+ * which the outcome is not reported are considered to have failed.
+ *
+ * @param file File to read the outcomes from
+ * @param batch_size Amount of activities in the batch
+ * @return An array of batch_size booleans that should be freed with g_free()
+ */
+gboolean *statemgmt_read_activity_batch_results(FILE *file, const unsigned int batch_size);
+
+/**
+ * Determines the stage that follows the given stage in a batch.
+ *
+ * @param batch An array of activity batch items
+ * @param stage Stage that has been completed
+ * @param first TRUE to return the lowest stage, ignoring the given stage
+ * @param next_stage Returns the next stage
+ * @return TRUE if there is a next stage, else FALSE
+ */
+gboolean statemgmt_next_activity_batch_stage(const GPtrArray *batch, guint stage, gboolean first, guint *next_stage);
+
+/**
+ * Executes a batch of activities on the local machine. Activities in the same
+ * stage are executed in parallel. Stages are executed in ascending order. If an
+ * activity fails, the activities of the subsequent stages are skipped and
+ * reported as failed.
+ *
+ * @param batch An array of activity batch items
+ * @param stdout_fd File descriptor to attach to the activities' standard output
+ * @param stderr_fd File descriptor to attach to the activities' standard error
+ * @param results_file File to which the outcome of each activity is written
+ * @return TRUE if all activities succeeded, else FALSE
+ */
+gboolean statemgmt_run_activity_batch(const GPtrArray *batch, int stdout_fd, int stderr_fd, FILE *results_file);
+
+#endif
@@ -24,6 +24,7 @@
 #include <libgen.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include <procreact_types.h>
 #include "snapshot-management.h"
 #include "remote-snapshot-management.h"
@@ -31,9 +32,15 @@
 static ProcReact_bool order_snapshots_remotely(gchar *interface, gchar *target, gchar *container, gchar *component, char **snapshot_array, const unsigned int snapshot_array_length)
 {
     char **resolved_snapshots = statemgmt_remote_resolve_snapshots_sync(interface, target, snapshot_array, snapshot_array_length);
-    ProcReact_bool exit_status = statemgmt_import_remote_snapshots_sync(interface, target, container, component, resolved_snapshots, g_strv_length(resolved_snapshots));
-    procreact_free_string_array(resolved_snapshots);
-    return exit_status;
+
+    if(resolved_snapshots == NULL)
+        return FALSE;
+    else
+    {
+        ProcReact_bool exit_status = statemgmt_import_remote_snapshots_sync(interface, target, container, component, resolved_snapshots, g_strv_length(resolved_snapshots));
+        procreact_free_string_array(resolved_snapshots);
+        return exit_status;
+    }
 }
 
 static ProcReact_bool send_missing_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component, char **missing_snapshots, const unsigned int missing_snapshots_length, int stderr_fd)
@@ -66,6 +73,60 @@ static char **query_local_snapshots(gchar *container, gchar *component, ProcReac
         return statemgmt_query_latest_snapshot_sync(container, component, stderr_fd);
 }
 
+static ProcReact_bool is_missing_snapshot(char *snapshot, char **missing_snapshots, unsigned int missing_index)
+{
+    return (missing_snapshots[missing_index] != NULL && strcmp(snapshot, missing_snapshots[missing_index]) == 0);
+}
+
+/*
+ * Generations must be imported in the right order. The missing snapshots are
+ * reported in the same order as the snapshots that are checked, so we can
+ * split the generation list into consecutive runs of missing and present
+ * snapshots and import each run with a single invocation. In the common case,
+ * in which a machine only lacks the newest generations, this requires no more
+ * than two imports.
+ */
+static unsigned int next_snapshot_run(char **snapshots, const unsigned int snapshots_length, unsigned int run_start, char **missing_snapshots, unsigned int *missing_index, ProcReact_bool *missing)
+{
+    unsigned int i = run_start;
+
+    *missing = is_missing_snapshot(snapshots[i], missing_snapshots, *missing_index);
+
+    do
+    {
+        if(*missing)
+            (*missing_index)++;
+
+        i++;
+    }
+    while(i < snapshots_length && is_missing_snapshot(snapshots[i], missing_snapshots, *missing_index) == *missing);
+
+    return i;
+}
+
+static ProcReact_bool import_snapshots_in_order(gchar *interface, gchar *target, gchar *container, gchar *component, char **snapshots, const unsigned int snapshots_length, char **missing_snapshots, int stderr_fd)
+{
+    unsigned int i = 0, missing_index = 0;
+
+    while(i < snapshots_length)
+    {
+        unsigned int run_start = i;
+        ProcReact_bool missing, exit_status;
+
+        i = next_snapshot_run(snapshots, snapshots_length, run_start, missing_snapshots, &missing_index, &missing);
+
+        if(missing)
+            exit_status = send_missing_snapshots(interface, target, container, component, snapshots + run_start, i - run_start, stderr_fd);
+        else // If no snapshots need to be transferred, we still have to order them
+            exit_status = order_snapshots_remotely(interface, target, container, component, snapshots + run_start, i - run_start);
+
+        if(!exit_status)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 ProcReact_bool copy_snapshots_to_sync(gchar *interface, gchar *target, gchar *container, gchar *component, ProcReact_bool all, int stderr_fd)
 {
     char **snapshots = query_local_snapshots(container, component, all, stderr_fd);
@@ -74,30 +135,16 @@ ProcReact_bool copy_snapshots_to_sync(gchar *interface, gchar *target, gchar *co
         return FALSE;
     else
     {
-        ProcReact_bool exit_status = TRUE;
-        unsigned int i;
+        ProcReact_bool exit_status;
+        unsigned int snapshots_length = g_strv_length(snapshots);
+        char **missing_snapshots = statemgmt_remote_print_missing_snapshots_sync(interface, target, snapshots, snapshots_length); // Check all generations in one round trip
 
-        for(i = 0; i < g_strv_length(snapshots); i++) // We need to traverse the snapshots in the right order, one by one, to ensure that the generations are imported in the right order
+        if(missing_snapshots == NULL)
+            exit_status = FALSE;
+        else
         {
-            char *snapshot = snapshots[i];
-            char *snapshot_array[] = { snapshot, NULL };
-            unsigned int snapshot_array_length = 1; // Length of the above array
-
-            char **missing_snapshots = statemgmt_remote_print_missing_snapshots_sync(interface, target, snapshot_array, snapshot_array_length);
-
-            if(missing_snapshots == NULL)
-                exit_status = FALSE;
-            else
-            {
-                unsigned int missing_snapshots_length = g_strv_length(missing_snapshots);
-
-                if(missing_snapshots_length == 0) // If no snapshots need to be transferred, we still have to order them
-                     exit_status = order_snapshots_remotely(interface, target, container, component, snapshot_array, snapshot_array_length);
-                else
-                     exit_status = send_missing_snapshots(interface, target, container, component, missing_snapshots, missing_snapshots_length, stderr_fd);
-
-                procreact_free_string_array(missing_snapshots);
-            }
+            exit_status = import_snapshots_in_order(interface, target, container, component, snapshots, snapshots_length, missing_snapshots, stderr_fd);
+            procreact_free_string_array(missing_snapshots);
         }
 
         procreact_free_string_array(snapshots);
@@ -131,10 +178,9 @@ static ProcReact_bool remove_directory_and_contents(char *path)
     return (nftw(path, unlink_cb, 64, FTW_DEPTH | FTW_PHYS) == 0);
 }
 
-static ProcReact_bool order_local_snapshot(gchar *container, gchar *component, char *snapshot, int stdout_fd, int stderr_fd)
+static ProcReact_bool order_local_snapshots(gchar *container, gchar *component, char **snapshot_array, const unsigned int snapshot_array_length, int stdout_fd, int stderr_fd)
 {
-    char *snapshot_array[] = { snapshot, NULL };
-    char **resolved_snapshots = statemgmt_resolve_snapshots_sync(snapshot_array, g_strv_length(snapshot_array), stderr_fd);
+    char **resolved_snapshots = statemgmt_resolve_snapshots_sync(snapshot_array, snapshot_array_length, stderr_fd);
 
     if(resolved_snapshots == NULL)
         return FALSE;
@@ -146,47 +192,115 @@ static ProcReact_bool order_local_snapshot(gchar *container, gchar *component, c
     }
 }
 
-static ProcReact_bool retrieve_missing_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component, char **missing_snapshots, int stdout_fd, int stderr_fd)
+/*
+ * Imports the remote generations in the right order: runs of missing snapshots
+ * are imported from the temp directories to which they have been exported,
+ * runs of snapshots that are already present are reordered locally.
+ */
+static ProcReact_bool import_remote_snapshots_in_order(gchar *container, gchar *component, char **snapshots, const unsigned int snapshots_length, char **missing_snapshots, gchar **tmp_snapshots, int stdout_fd, int stderr_fd)
 {
-    char **resolved_snapshots = statemgmt_remote_resolve_snapshots_sync(interface, target, missing_snapshots, g_strv_length(missing_snapshots));
+    unsigned int i = 0, missing_index = 0;
+
+    while(i < snapshots_length)
+    {
+        unsigned int run_start = i, missing_start = missing_index;
+        ProcReact_bool missing, exit_status;
+
+        i = next_snapshot_run(snapshots, snapshots_length, run_start, missing_snapshots, &missing_index, &missing);
+
+        if(missing)
+            exit_status = statemgmt_import_snapshots_sync(container, component, tmp_snapshots + missing_start, missing_index - missing_start, stdout_fd, stderr_fd);
+        else // If no snapshots need to be transferred, we still have to order them
+            exit_status = order_local_snapshots(container, component, snapshots + run_start, i - run_start, stdout_fd, stderr_fd);
+
+        if(!exit_status)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void remove_tmpdirs(char **tmpdirs)
+{
+    unsigned int i;
+
+    for(i = 0; tmpdirs[i] != NULL; i++)
+        remove_directory_and_contents(tmpdirs[i]);
+}
+
+/*
+ * Exports the missing generations. All of them are transferred in a single
+ * stream to one temp directory, if the client interface supports it.
+ * Otherwise, they are exported one by one, each into a temp directory of its
+ * own.
+ */
+static char **export_missing_snapshots(gchar *interface, gchar *target, char **resolved_snapshots, const unsigned int resolved_snapshots_length)
+{
+    char **tmpdirs = statemgmt_export_remote_snapshots_stream_sync(interface, target, resolved_snapshots, resolved_snapshots_length);
+
+    if(tmpdirs != NULL && g_strv_length(tmpdirs) != 1)
+    {
+        remove_tmpdirs(tmpdirs);
+        procreact_free_string_array(tmpdirs);
+        tmpdirs = NULL;
+    }
+
+    if(tmpdirs == NULL)
+        tmpdirs = statemgmt_export_remote_snapshots_sync(interface, target, resolved_snapshots, resolved_snapshots_length);
+
+    return tmpdirs;
+}
+
+static gchar **compose_tmp_snapshots(char **tmpdirs, char **resolved_snapshots, const unsigned int resolved_snapshots_length)
+{
+    unsigned int i, tmpdirs_length = g_strv_length(tmpdirs);
+    gchar **tmp_snapshots;
+
+    if(tmpdirs_length != 1 && tmpdirs_length != resolved_snapshots_length)
+        return NULL;
+
+    tmp_snapshots = (gchar**)g_malloc((resolved_snapshots_length + 1) * sizeof(gchar*));
+
+    for(i = 0; i < resolved_snapshots_length; i++)
+        tmp_snapshots[i] = g_strconcat(tmpdirs[tmpdirs_length == 1 ? 0 : i], "/", basename(resolved_snapshots[i]), NULL);
+
+    tmp_snapshots[i] = NULL;
+    return tmp_snapshots;
+}
+
+static ProcReact_bool retrieve_missing_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component, char **snapshots, const unsigned int snapshots_length, char **missing_snapshots, int stdout_fd, int stderr_fd)
+{
+    const unsigned int missing_snapshots_length = g_strv_length(missing_snapshots);
+    char **resolved_snapshots = statemgmt_remote_resolve_snapshots_sync(interface, target, missing_snapshots, missing_snapshots_length);
 
     if(resolved_snapshots == NULL)
         return FALSE;
     else
     {
-        ProcReact_bool exit_status = TRUE;
-        unsigned int resolved_snapshots_length = g_strv_length(resolved_snapshots);
+        ProcReact_bool exit_status;
 
-        if(resolved_snapshots_length == 0)
+        if(g_strv_length(resolved_snapshots) != missing_snapshots_length)
             exit_status = FALSE;
         else
         {
-            char **tmpdirs = statemgmt_export_remote_snapshots_sync(interface, target, resolved_snapshots, resolved_snapshots_length);
+            char **tmpdirs = export_missing_snapshots(interface, target, resolved_snapshots, missing_snapshots_length);
 
             if(tmpdirs == NULL)
                 exit_status = FALSE;
             else
             {
-                if(g_strv_length(tmpdirs) == 0)
+                gchar **tmp_snapshots = compose_tmp_snapshots(tmpdirs, resolved_snapshots, missing_snapshots_length);
+
+                if(tmp_snapshots == NULL)
                     exit_status = FALSE;
                 else
                 {
-                    char *tmpdir = tmpdirs[0];
-                    gchar *tmp_snapshot = g_strconcat(tmpdir, "/", basename(resolved_snapshots[0]), NULL);
-                    char *tmp_snapshots[] = { tmp_snapshot, NULL };
-                    const unsigned int tmp_snapshots_length = 1; // Length of the array above
-
-                    exit_status = statemgmt_import_snapshots_sync(container, component, tmp_snapshots, tmp_snapshots_length, stdout_fd, stderr_fd);
-
-                    if(exit_status == 0)
-                        rmdir(tmpdir);
-                    else
-                        remove_directory_and_contents(tmpdir);
-
-                    g_free(tmp_snapshot);
+                    exit_status = import_remote_snapshots_in_order(container, component, snapshots, snapshots_length, missing_snapshots, tmp_snapshots, stdout_fd, stderr_fd);
+                    g_strfreev(tmp_snapshots);
                 }
 
-                g_strfreev(tmpdirs);
+                remove_tmpdirs(tmpdirs);
+                procreact_free_string_array(tmpdirs);
             }
         }
 
@@ -212,27 +326,20 @@ ProcReact_bool copy_snapshots_from_sync(gchar *interface, gchar *target, gchar *
         return FALSE;
     else
     {
-        ProcReact_bool exit_status = TRUE;
-        unsigned int i;
+        ProcReact_bool exit_status;
         unsigned int snapshots_length = g_strv_length(snapshots);
+        char **missing_snapshots = statemgmt_print_missing_snapshots_sync(snapshots, snapshots_length, stderr_fd); // Determine the missing generations once
 
-        for(i = 0; i < snapshots_length; i++) // We need to traverse the snapshots in the right order, one by one, to ensure that the generations are imported in the right order
+        if(missing_snapshots == NULL)
+            exit_status = FALSE;
+        else
         {
-            char *snapshot = snapshots[i];
-
-            char **missing_snapshots = statemgmt_print_missing_snapshots_sync(snapshots, snapshots_length, stderr_fd);
-
-            if(missing_snapshots == NULL)
-                exit_status = FALSE;
+            if(g_strv_length(missing_snapshots) == 0) // If no snapshots need to be transferred, we still have to order them
+                exit_status = order_local_snapshots(container, component, snapshots, snapshots_length, stdout_fd, stderr_fd);
             else
-            {
-                if(g_strv_length(missing_snapshots) == 0) // If no snapshots need to be transferred, we still have to order them
-                    exit_status = order_local_snapshot(container, component, snapshot, stdout_fd, stderr_fd);
-                else
-                    exit_status = retrieve_missing_snapshots(interface, target, container, component, missing_snapshots, stdout_fd, stderr_fd);
+                exit_status = retrieve_missing_snapshots(interface, target, container, component, snapshots, snapshots_length, missing_snapshots, stdout_fd, stderr_fd);
 
-                procreact_free_string_array(missing_snapshots);
-            }
+            procreact_free_string_array(missing_snapshots);
         }
 
         procreact_free_string_array(snapshots);
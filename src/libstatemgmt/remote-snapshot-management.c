@@ -19,93 +19,137 @@
 
 #include "remote-snapshot-management.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <client-interface.h>
+#include "snapshot-management.h"
+
+/* In-process implementations of the operations for the local client interface */
+
+typedef struct
+{
+    int keep;
+    gchar *container;
+    gchar *component;
+    gchar **snapshots;
+    unsigned int snapshots_length;
+}
+SnapshotsData;
+
+static pid_t local_clean_snapshots(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_clean_snapshots(snapshots_data->keep, snapshots_data->container == NULL ? "" : snapshots_data->container, snapshots_data->component == NULL ? "" : snapshots_data->component, -1, -1);
+}
+
+static ProcReact_Future local_query_all_snapshots(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_query_all_snapshots(snapshots_data->container, snapshots_data->component, -1);
+}
+
+static ProcReact_Future local_query_latest_snapshot(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_query_latest_snapshot(snapshots_data->container, snapshots_data->component, -1);
+}
+
+static ProcReact_Future local_print_missing_snapshots(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_print_missing_snapshots(snapshots_data->snapshots, snapshots_data->snapshots_length, -1);
+}
+
+static ProcReact_Future local_resolve_snapshots(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_resolve_snapshots(snapshots_data->snapshots, snapshots_data->snapshots_length, -1);
+}
+
+static pid_t local_import_snapshots(void *data)
+{
+    SnapshotsData *snapshots_data = (SnapshotsData*)data;
+    return statemgmt_import_snapshots(snapshots_data->container, snapshots_data->component, snapshots_data->snapshots, snapshots_data->snapshots_length, -1, -1);
+}
 
 pid_t statemgmt_remote_clean_snapshots(gchar *interface, gchar *target, int keep, char *container, char *component)
 {
-    pid_t pid = fork();
+    pid_t pid;
+    char **args;
+    unsigned int count = 6;
+    char keepStr[15];
+    SnapshotsData data = { keep, container, component, NULL, 0 };
+
+    sprintf(keepStr, "%d", keep);
+
+    args = (char**)g_malloc(11 * sizeof(char*));
 
-    if(pid == 0)
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--clean-snapshots";
+    args[4] = "--keep";
+    args[5] = keepStr;
+
+    if(container != NULL)
     {
-        char **args = (char**)g_malloc(11 * sizeof(char*));
-        unsigned int count = 6;
-        char keepStr[15];
-
-        sprintf(keepStr, "%d", keep);
-
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--clean-snapshots";
-        args[4] = "--keep";
-        args[5] = keepStr;
-
-        if(container != NULL)
-        {
-            args[count] = "--container";
-            count++;
-            args[count] = container;
-            count++;
-        }
-
-        if(component != NULL)
-        {
-            args[count] = "--component";
-            count++;
-            args[count] = component;
-            count++;
-        }
-
-        args[count] = NULL;
-
-        execvp(interface, args);
-        _exit(1);
+        args[count] = "--container";
+        count++;
+        args[count] = container;
+        count++;
     }
 
+    if(component != NULL)
+    {
+        args[count] = "--component";
+        count++;
+        args[count] = component;
+        count++;
+    }
+
+    args[count] = NULL;
+
+    pid = client_interface_spawn(args, -1, -1, -1, 0, local_clean_snapshots, &data);
+    g_free(args);
     return pid;
 }
 
 ProcReact_Future statemgmt_remote_query_all_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int count = 0;
+    unsigned int num_of_extra_params = 0;
+    SnapshotsData data = { 0, container, component, NULL, 0 };
 
-    if(future.pid == 0)
+    if(container != NULL)
+        num_of_extra_params += 2;
+
+    if(component != NULL)
+        num_of_extra_params += 2;
+
+    char **args = (char**)malloc((5 + num_of_extra_params) * sizeof(char*));
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--query-all-snapshots";
+
+    if(container != NULL)
     {
-        unsigned int count = 0;
-        unsigned int num_of_extra_params = 0;
-
-        if(container != NULL)
-            num_of_extra_params += 2;
-
-        if(component != NULL)
-            num_of_extra_params += 2;
-
-        char **args = (char**)malloc((5 + num_of_extra_params) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--query-all-snapshots";
-
-        if(container != NULL)
-        {
-            args[count + 4] = "--container";
-            args[count + 5] = container;
-            count += 2;
-        }
-
-        if(component != NULL)
-        {
-            args[count + 4] = "--component";
-            args[count + 5] = component;
-            count += 2;
-        }
-
-        args[count + 4] = NULL;
-
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
+        args[count + 4] = "--container";
+        args[count + 5] = container;
+        count += 2;
     }
 
+    if(component != NULL)
+    {
+        args[count + 4] = "--component";
+        args[count + 5] = component;
+        count += 2;
+    }
+
+    args[count + 4] = NULL;
+
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_query_all_snapshots, &data);
+    free(args);
     return future;
 }
 
@@ -123,46 +167,41 @@ char **statemgmt_remote_query_all_snapshots_sync(gchar *interface, gchar *target
 
 ProcReact_Future statemgmt_remote_query_latest_snapshot(gchar *interface, gchar *target, gchar *container, gchar *component)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int count = 0;
+    unsigned int num_of_extra_params = 0;
+    SnapshotsData data = { 0, container, component, NULL, 0 };
+
+    if(container != NULL)
+        num_of_extra_params += 2;
+
+    if(component != NULL)
+        num_of_extra_params += 2;
 
-    if(future.pid == 0)
+    char **args = (char**)malloc((5 + num_of_extra_params) * sizeof(char*));
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--query-latest-snapshot";
+
+    if(container != NULL)
     {
-        unsigned int count = 0;
-        unsigned int num_of_extra_params = 0;
-
-        if(container != NULL)
-            num_of_extra_params += 2;
-
-        if(component != NULL)
-            num_of_extra_params += 2;
-
-        char **args = (char**)malloc((5 + num_of_extra_params) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--query-latest-snapshot";
-
-        if(container != NULL)
-        {
-            args[count + 4] = "--container";
-            args[count + 5] = container;
-            count += 2;
-        }
-
-        if(component != NULL)
-        {
-            args[count + 4] = "--component";
-            args[count + 5] = component;
-            count += 2;
-        }
-
-        args[count + 4] = NULL;
-
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
+        args[count + 4] = "--container";
+        args[count + 5] = container;
+        count += 2;
     }
 
+    if(component != NULL)
+    {
+        args[count + 4] = "--component";
+        args[count + 5] = component;
+        count += 2;
+    }
+
+    args[count + 4] = NULL;
+
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_query_latest_snapshot, &data);
+    free(args);
     return future;
 }
 
@@ -180,27 +219,23 @@ char **statemgmt_remote_query_latest_snapshot_sync(gchar *interface, gchar *targ
 
 ProcReact_Future statemgmt_remote_print_missing_snapshots(gchar *interface, gchar *target, gchar **snapshots, const unsigned int snapshots_length)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    SnapshotsData data = { 0, NULL, NULL, snapshots, snapshots_length };
+    char **args = (char**)malloc((5 + snapshots_length) * sizeof(char*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((5 + snapshots_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--print-missing-snapshots";
-
-        for(i = 0; i < snapshots_length; i++)
-            args[i + 4] = snapshots[i];
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--print-missing-snapshots";
 
-        args[i + 4] = NULL;
+    for(i = 0; i < snapshots_length; i++)
+        args[i + 4] = snapshots[i];
 
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 4] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_print_missing_snapshots, &data);
+    free(args);
     return future;
 }
 
@@ -218,27 +253,23 @@ char **statemgmt_remote_print_missing_snapshots_sync(gchar *interface, gchar *ta
 
 ProcReact_Future statemgmt_remote_resolve_snapshots(gchar *interface, gchar *target, gchar **snapshots, const unsigned int snapshots_length)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    SnapshotsData data = { 0, NULL, NULL, snapshots, snapshots_length };
+    char **args = (char**)malloc((5 + snapshots_length) * sizeof(char*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((5 + snapshots_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--resolve-snapshots";
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--resolve-snapshots";
 
-        for(i = 0; i < snapshots_length; i++)
-            args[i + 4] = snapshots[i];
+    for(i = 0; i < snapshots_length; i++)
+        args[i + 4] = snapshots[i];
 
-        args[i + 4] = NULL;
-
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 4] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, local_resolve_snapshots, &data);
+    free(args);
     return future;
 }
 
@@ -256,31 +287,28 @@ char **statemgmt_remote_resolve_snapshots_sync(gchar *interface, gchar *target,
 
 pid_t statemgmt_import_local_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((10 + resolved_snapshots_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--import-snapshots";
-        args[4] = "--localfile";
-        args[5] = "--container";
-        args[6] = container;
-        args[7] = "--component";
-        args[8] = component;
-
-        for(i = 0; i < resolved_snapshots_length; i++)
-            args[i + 9] = resolved_snapshots[i];
-
-        args[i + 9] = NULL;
-
-        execvp(args[0], args);
-        _exit(1);
-    }
-
+    pid_t pid;
+    unsigned int i;
+    SnapshotsData data = { 0, container, component, resolved_snapshots, resolved_snapshots_length };
+    char **args = (char**)malloc((10 + resolved_snapshots_length) * sizeof(char*));
+
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--import-snapshots";
+    args[4] = "--localfile";
+    args[5] = "--container";
+    args[6] = container;
+    args[7] = "--component";
+    args[8] = component;
+
+    for(i = 0; i < resolved_snapshots_length; i++)
+        args[i + 9] = resolved_snapshots[i];
+
+    args[i + 9] = NULL;
+
+    pid = client_interface_spawn(args, -1, -1, -1, 0, local_import_snapshots, &data);
+    free(args);
     return pid;
 }
 
@@ -294,31 +322,28 @@ ProcReact_bool statemgmt_import_local_snapshots_sync(gchar *interface, gchar *ta
 
 pid_t statemgmt_import_remote_snapshots(gchar *interface, gchar *target, gchar *container, gchar *component, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((10 + resolved_snapshots_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--import-snapshots";
-        args[4] = "--remotefile";
-        args[5] = "--container";
-        args[6] = container;
-        args[7] = "--component";
-        args[8] = component;
-
-        for(i = 0; i < resolved_snapshots_length; i++)
-            args[i + 9] = resolved_snapshots[i];
-
-        args[i + 9] = NULL;
-
-        execvp(args[0], args);
-        _exit(1);
-    }
-
+    pid_t pid;
+    unsigned int i;
+    SnapshotsData data = { 0, container, component, resolved_snapshots, resolved_snapshots_length };
+    char **args = (char**)malloc((10 + resolved_snapshots_length) * sizeof(char*));
+
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--import-snapshots";
+    args[4] = "--remotefile";
+    args[5] = "--container";
+    args[6] = container;
+    args[7] = "--component";
+    args[8] = component;
+
+    for(i = 0; i < resolved_snapshots_length; i++)
+        args[i + 9] = resolved_snapshots[i];
+
+    args[i + 9] = NULL;
+
+    pid = client_interface_spawn(args, -1, -1, -1, 0, local_import_snapshots, &data);
+    free(args);
     return pid;
 }
 
@@ -332,27 +357,21 @@ ProcReact_bool statemgmt_import_remote_snapshots_sync(gchar *interface, gchar *t
 
 ProcReact_Future statemgmt_export_remote_snapshots(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    char **args = (char**)malloc((5 + resolved_snapshots_length) * sizeof(char*));
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--export-snapshots";
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)malloc((5 + resolved_snapshots_length) * sizeof(char*));
-        args[0] = interface;
-        args[1] = "--target";
-        args[2] = target;
-        args[3] = "--export-snapshots";
-
-        for(i = 0; i < resolved_snapshots_length; i++)
-            args[i + 4] = resolved_snapshots[i];
+    for(i = 0; i < resolved_snapshots_length; i++)
+        args[i + 4] = resolved_snapshots[i];
 
-        args[i + 4] = NULL;
-
-        dup2(future.fd, 1);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 4] = NULL;
 
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, NULL, NULL);
+    free(args);
     return future;
 }
 
@@ -367,3 +386,36 @@ char **statemgmt_export_remote_snapshots_sync(gchar *interface, gchar *target, g
     else
         return NULL;
 }
+
+ProcReact_Future statemgmt_export_remote_snapshots_stream(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length)
+{
+    ProcReact_Future future;
+    unsigned int i;
+    char **args = (char**)malloc((6 + resolved_snapshots_length) * sizeof(char*));
+    args[0] = interface;
+    args[1] = "--target";
+    args[2] = target;
+    args[3] = "--export-snapshots";
+    args[4] = "--stream";
+
+    for(i = 0; i < resolved_snapshots_length; i++)
+        args[i + 5] = resolved_snapshots[i];
+
+    args[i + 5] = NULL;
+
+    future = client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, NULL, NULL);
+    free(args);
+    return future;
+}
+
+char **statemgmt_export_remote_snapshots_stream_sync(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length)
+{
+    ProcReact_Status status;
+    ProcReact_Future future = statemgmt_export_remote_snapshots_stream(interface, target, resolved_snapshots, resolved_snapshots_length);
+    char **result = procreact_future_get(&future, &status);
+
+    if(status == PROCREACT_STATUS_OK)
+        return result;
+    else
+        return NULL;
+}
@@ -166,4 +166,25 @@ ProcReact_Future statemgmt_export_remote_snapshots(gchar *interface, gchar *targ
  */
 char **statemgmt_export_remote_snapshots_sync(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length);
 
+/**
+ * Remotely exports snapshots from the snapshot store and transfers all of them
+ * to a single temp directory on the coordinator machine in one stream. Not
+ * every client interface supports this mode, so callers should fall back to
+ * statemgmt_export_remote_snapshots() if it fails.
+ *
+ * @param interface Path to the interface executable
+ * @param target Target Address of the remote interface
+ * @param resolved_snapshots Absolute paths to snapshots to be exported
+ * @param resolved_snapshots_length Length of the resolved snapshots array
+ * @return A future that returns an array containing the temp directory
+ */
+ProcReact_Future statemgmt_export_remote_snapshots_stream(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length);
+
+/**
+ * Synchronously exports remote snapshots in one stream.
+ *
+ * @see statemgmt_export_remote_snapshots_stream
+ */
+char **statemgmt_export_remote_snapshots_stream_sync(gchar *interface, gchar *target, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length);
+
 #endif
@@ -20,76 +20,105 @@
 #include "remote-state-management.h"
 #include <sys/types.h>
 #include <stdio.h>
+#include <procreact_spawn.h>
+#include <client-interface.h>
+#include "state-management.h"
 
-static pid_t exec_dysnomia_activity(gchar *operation, gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
+typedef struct
 {
-    pid_t pid = fork();
+    gchar *activity;
+    gchar *container;
+    gchar *type;
+    gchar **arguments;
+    unsigned int arguments_size;
+    gchar *service;
+}
+ActivityData;
 
-    if(pid == 0)
-    {
-        unsigned int i;
-        char **args = (char**)g_malloc((10 + 2 * arguments_size) * sizeof(char*));
-
-        args[0] = interface;
-        args[1] = operation;
-        args[2] = "--target";
-        args[3] = target;
-        args[4] = "--container";
-        args[5] = container;
-        args[6] = "--type";
-        args[7] = type;
-
-        for(i = 0; i < arguments_size * 2; i += 2)
-        {
-            args[i + 8] = "--arguments";
-            args[i + 9] = arguments[i / 2];
-        }
-
-        args[i + 8] = service;
-        args[i + 9] = NULL;
+static pid_t run_local_dysnomia_activity(void *data)
+{
+    ActivityData *activity_data = (ActivityData*)data;
+    pid_t pid;
+    unsigned int i;
+    char **arguments_strv = (char**)g_malloc((activity_data->arguments_size + 1) * sizeof(char*));
+
+    for(i = 0; i < activity_data->arguments_size; i++)
+        arguments_strv[i] = activity_data->arguments[i];
 
-        /*
-         * Attach process to its own process group to prevent them from being
-         * interrupted by the shell session starting the process
-         */
-        setpgid(0, 0);
+    arguments_strv[i] = NULL;
+
+    /* Invoke Dysnomia directly, in its own process group, like disnix-run-activity would do */
+    pid = statemgmt_run_dysnomia_activity(activity_data->type, activity_data->activity, activity_data->service, activity_data->container, arguments_strv, -1, -1, PROCREACT_SPAWN_NEW_PROCESS_GROUP);
+
+    g_free(arguments_strv);
+    return pid;
+}
 
-        execvp(interface, args);
-        _exit(1);
+static pid_t exec_dysnomia_activity(gchar *operation, gchar *activity, gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
+{
+    pid_t pid;
+    unsigned int i;
+    ActivityData data = { activity, container, type, arguments, arguments_size, service };
+    char **args = (char**)g_malloc((10 + 2 * arguments_size) * sizeof(char*));
+
+    args[0] = interface;
+    args[1] = operation;
+    args[2] = "--target";
+    args[3] = target;
+    args[4] = "--container";
+    args[5] = container;
+    args[6] = "--type";
+    args[7] = type;
+
+    for(i = 0; i < arguments_size * 2; i += 2)
+    {
+        args[i + 8] = "--arguments";
+        args[i + 9] = arguments[i / 2];
     }
 
+    args[i + 8] = service;
+    args[i + 9] = NULL;
+
+    /*
+     * Attach process to its own process group to prevent them from being
+     * interrupted by the shell session starting the process
+     */
+    pid = client_interface_spawn(args, -1, -1, -1, PROCREACT_SPAWN_NEW_PROCESS_GROUP, run_local_dysnomia_activity, &data);
+
+    g_free(args);
     return pid;
 }
 
 pid_t statemgmt_remote_activate(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
 {
-    return exec_dysnomia_activity("--activate", interface, target, container, type, arguments, arguments_size, service);
+    return exec_dysnomia_activity("--activate", "activate", interface, target, container, type, arguments, arguments_size, service);
 }
 
 pid_t statemgmt_remote_deactivate(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
 {
-    return exec_dysnomia_activity("--deactivate", interface, target, container, type, arguments, arguments_size, service);
+    return exec_dysnomia_activity("--deactivate", "deactivate", interface, target, container, type, arguments, arguments_size, service);
 }
 
-static pid_t lock_or_unlock(gchar *operation, gchar *interface, gchar *target, gchar *profile)
+pid_t statemgmt_remote_run_activities(gchar *interface, gchar *target, int batch_fd, int results_fd)
 {
-    pid_t pid = fork();
+    char *const args[] = {interface, "--run-activities", "--target", target, NULL};
 
-    if(pid == 0)
-    {
-        char *const args[] = {interface, operation, "--target", target, "--profile", profile, NULL};
-
-        /*
-         * Attach process to its own process group to prevent them from being
-         * interrupted by the shell session starting the process
-         */
-        setpgid(0, 0);
+    /*
+     * Attach process to its own process group to prevent them from being
+     * interrupted by the shell session starting the process
+     */
+    return client_interface_spawn(args, batch_fd, results_fd, -1, PROCREACT_SPAWN_NEW_PROCESS_GROUP, NULL, NULL);
+}
 
-        execvp(interface, args);
-        _exit(1);
-    }
+static pid_t lock_or_unlock(gchar *operation, gchar *interface, gchar *target, gchar *profile)
+{
+    char *const args[] = {interface, operation, "--target", target, "--profile", profile, NULL};
 
-    return pid;
+    /*
+     * Attach process to its own process group to prevent them from being
+     * interrupted by the shell session starting the process
+     */
+    return client_interface_spawn(args, -1, -1, -1, PROCREACT_SPAWN_NEW_PROCESS_GROUP, NULL, NULL);
 }
 
 pid_t statemgmt_remote_lock(gchar *interface, gchar *target, gchar *profile)
@@ -104,86 +133,65 @@ pid_t statemgmt_remote_unlock(gchar *interface, gchar *target, gchar *profile)
 
 pid_t statemgmt_remote_snapshot(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
 {
-    return exec_dysnomia_activity("--snapshot", interface, target, container, type, arguments, arguments_size, service);
+    return exec_dysnomia_activity("--snapshot", "snapshot", interface, target, container, type, arguments, arguments_size, service);
 }
 
 pid_t statemgmt_remote_restore(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
 {
-    return exec_dysnomia_activity("--restore", interface, target, container, type, arguments, arguments_size, service);
+    return exec_dysnomia_activity("--restore", "restore", interface, target, container, type, arguments, arguments_size, service);
 }
 
 pid_t statemgmt_remote_delete_state(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service)
 {
-    return exec_dysnomia_activity("--delete-state", interface, target, container, type, arguments, arguments_size, service);
+    return exec_dysnomia_activity("--delete-state", "collect-garbage", interface, target, container, type, arguments, arguments_size, service);
 }
 
 pid_t statemgmt_remote_shell(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service, gchar *command)
 {
-    pid_t pid = fork();
+    pid_t pid;
+    unsigned int i;
+    char **args = (char**)g_malloc((12 + 2 * arguments_size) * sizeof(char*));
+
+    args[0] = interface;
+    args[1] = "--shell";
+    args[2] = "--target";
+    args[3] = target;
+    args[4] = "--container";
+    args[5] = container;
+    args[6] = "--type";
+    args[7] = type;
+
+    for(i = 0; i < arguments_size * 2; i += 2)
+    {
+        args[i + 8] = "--arguments";
+        args[i + 9] = arguments[i / 2];
+    }
 
-    if(pid == 0)
+    args[i + 8] = service;
+
+    if(command == NULL)
+        args[i + 9] = NULL;
+    else
     {
-        unsigned int i;
-        char **args = (char**)g_malloc((12 + 2 * arguments_size) * sizeof(char*));
-
-        args[0] = interface;
-        args[1] = "--shell";
-        args[2] = "--target";
-        args[3] = target;
-        args[4] = "--container";
-        args[5] = container;
-        args[6] = "--type";
-        args[7] = type;
-
-        for(i = 0; i < arguments_size * 2; i += 2)
-        {
-            args[i + 8] = "--arguments";
-            args[i + 9] = arguments[i / 2];
-        }
-
-        args[i + 8] = service;
-
-        if(command == NULL)
-            args[i + 9] = NULL;
-        else
-        {
-            args[i + 9] = "--command";
-            args[i + 10] = command;
-            args[i + 11] = NULL;
-        }
-
-        execvp(interface, args);
-        _exit(1);
+        args[i + 9] = "--command";
+        args[i + 10] = command;
+        args[i + 11] = NULL;
     }
 
+    pid = client_interface_spawn(args, -1, -1, -1, 0, NULL, NULL);
+
+    g_free(args);
     return pid;
 }
 
 ProcReact_Future statemgmt_remote_capture_config(gchar *interface, gchar *target)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
-
-    if(future.pid == 0)
-    {
-        char *const args[] = {interface, "--capture-config", "--target", target, NULL};
-        dup2(future.fd, 1); /* Attach pipe to the stdout */
-        execvp(interface, args); /* Run process */
-        _exit(1);
-    }
-
-    return future;
+    char *const args[] = {interface, "--capture-config", "--target", target, NULL};
+    return client_interface_spawn_future(procreact_create_string_array_type('\n'), args, -1, -1, 0, NULL, NULL);
 }
 
 pid_t statemgmt_dummy_command(void)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        char *const args[] = {"true", NULL};
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return pid;
+    char *const args[] = {"true", NULL};
+    return procreact_spawn(args, NULL, -1, -1, -1, 0);
 }
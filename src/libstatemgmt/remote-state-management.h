@@ -52,6 +52,19 @@ pid_t statemgmt_remote_activate(gchar *interface, gchar *target, gchar *containe
  */
 pid_t statemgmt_remote_deactivate(gchar *interface, gchar *target, gchar *container, gchar *type, gchar **arguments, const unsigned int arguments_size, gchar *service);
 
+/**
+ * Invokes the run activities operation through a Disnix client interface,
+ * executing a batch of Dysnomia activities on the target machine with a single
+ * request.
+ *
+ * @param interface Path to the interface executable
+ * @param target Target Address of the remote interface
+ * @param batch_fd File descriptor from which the batch of activities is read
+ * @param results_fd File descriptor to which the outcome of each activity is written
+ * @return PID of the client interface process performing the operation, or -1 in case of a failure
+ */
+pid_t statemgmt_remote_run_activities(gchar *interface, gchar *target, int batch_fd, int results_fd);
+
 /**
  * Invokes the lock operation through a Disnix client interface
  *
@@ -19,22 +19,12 @@
 
 #include "snapshot-management.h"
 #include <stdio.h>
+#include <procreact_spawn.h>
 
 ProcReact_Future statemgmt_query_all_snapshots(gchar *container, gchar *component, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
-
-    if(future.pid == 0)
-    {
-        char *const args[] = {"dysnomia-snapshots", "--query-all", "--container", container, "--component", component, NULL};
-
-        dup2(future.fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return future;
+    char *const args[] = {"dysnomia-snapshots", "--query-all", "--container", container, "--component", component, NULL};
+    return procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0);
 }
 
 char **statemgmt_query_all_snapshots_sync(gchar *container, gchar *component, int stderr_fd)
@@ -51,19 +41,8 @@ char **statemgmt_query_all_snapshots_sync(gchar *container, gchar *component, in
 
 ProcReact_Future statemgmt_query_latest_snapshot(gchar *container, gchar *component, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
-
-    if(future.pid == 0)
-    {
-        char *const args[] = {"dysnomia-snapshots", "--query-latest", "--container", container, "--component", component, NULL};
-
-        dup2(future.fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return future;
+    char *const args[] = {"dysnomia-snapshots", "--query-latest", "--container", container, "--component", component, NULL};
+    return procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0);
 }
 
 char **statemgmt_query_latest_snapshot_sync(gchar *container, gchar *component, int stderr_fd)
@@ -80,27 +59,20 @@ char **statemgmt_query_latest_snapshot_sync(gchar *container, gchar *component,
 
 ProcReact_Future statemgmt_print_missing_snapshots(gchar **snapshots, const unsigned int snapshots_length, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    gchar **args = (gchar**)g_malloc((snapshots_length + 3) * sizeof(gchar*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        gchar **args = (gchar**)g_malloc((snapshots_length + 3) * sizeof(gchar*));
-
-        args[0] = "dysnomia-snapshots";
-        args[1] = "--print-missing";
+    args[0] = "dysnomia-snapshots";
+    args[1] = "--print-missing";
 
-        for(i = 0; i < snapshots_length; i++)
-            args[i + 2] = snapshots[i];
+    for(i = 0; i < snapshots_length; i++)
+        args[i + 2] = snapshots[i];
 
-        args[i + 2] = NULL;
-
-        dup2(future.fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-       _exit(1);
-    }
+    args[i + 2] = NULL;
 
+    future = procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0);
+    g_free(args);
     return future;
 }
 
@@ -118,27 +90,20 @@ char **statemgmt_print_missing_snapshots_sync(gchar **snapshots, const unsigned
 
 ProcReact_Future statemgmt_resolve_snapshots(gchar **snapshots, const unsigned int snapshots_length, int stderr_fd)
 {
-    ProcReact_Future future = procreact_initialize_future(procreact_create_string_array_type('\n'));
+    ProcReact_Future future;
+    unsigned int i;
+    gchar **args = (gchar**)g_malloc((snapshots_length + 3) * sizeof(gchar*));
 
-    if(future.pid == 0)
-    {
-        unsigned int i;
-        gchar **args = (gchar**)g_malloc((snapshots_length + 3) * sizeof(gchar*));
-
-        args[0] = "dysnomia-snapshots";
-        args[1] = "--resolve";
+    args[0] = "dysnomia-snapshots";
+    args[1] = "--resolve";
 
-        for(i = 0; i < snapshots_length; i++)
-            args[i + 2] = snapshots[i];
+    for(i = 0; i < snapshots_length; i++)
+        args[i + 2] = snapshots[i];
 
-        args[i + 2] = NULL;
-
-        dup2(future.fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 2] = NULL;
 
+    future = procreact_spawn_future(procreact_create_string_array_type('\n'), args, NULL, -1, stderr_fd, 0);
+    g_free(args);
     return future;
 }
 
@@ -156,77 +121,60 @@ char **statemgmt_resolve_snapshots_sync(gchar **snapshots, const unsigned int sn
 
 pid_t statemgmt_clean_snapshots(int keep, gchar *container, gchar *component, int stdout_fd, int stderr_fd)
 {
-    pid_t pid = fork();
+    char *args[9];
+    unsigned int count = 4;
+    char keep_str[15];
 
-    if(pid == 0)
+    /* Convert keep value to string */
+    sprintf(keep_str, "%d", keep);
+
+    /* Compose command-line arguments */
+    args[0] = "dysnomia-snapshots";
+    args[1] = "--gc";
+    args[2] = "--keep";
+    args[3] = keep_str;
+
+    if(g_strcmp0(container, "") != 0) /* Add container parameter, if requested */
     {
-        char **args = (char**)g_malloc(9 * sizeof(gchar*));
-        unsigned int count = 4;
-        char keep_str[15];
-
-        /* Convert keep value to string */
-        sprintf(keep_str, "%d", keep);
-
-        /* Compose command-line arguments */
-        args[0] = "dysnomia-snapshots";
-        args[1] = "--gc";
-        args[2] = "--keep";
-        args[3] = keep_str;
-
-        if(g_strcmp0(container, "") != 0) /* Add container parameter, if requested */
-        {
-            args[count] = "--container";
-            count++;
-            args[count] = container;
-            count++;
-        }
-
-        if(g_strcmp0(component, "") != 0) /* Add component parameter, if requested */
-        {
-            args[count] = "--component";
-            count++;
-            args[count] = component;
-            count++;
-        }
-
-        args[count] = NULL;
-
-        dup2(stdout_fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
+        args[count] = "--container";
+        count++;
+        args[count] = container;
+        count++;
     }
 
-    return pid;
+    if(g_strcmp0(component, "") != 0) /* Add component parameter, if requested */
+    {
+        args[count] = "--component";
+        count++;
+        args[count] = component;
+        count++;
+    }
+
+    args[count] = NULL;
+
+    return procreact_spawn(args, NULL, -1, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_import_snapshots(gchar *container, gchar *component, gchar **resolved_snapshots, const unsigned int resolved_snapshots_length, int stdout_fd, int stderr_fd)
 {
-    pid_t pid = fork();
+    pid_t pid;
+    unsigned int i;
+    gchar **args = (gchar**)g_malloc((resolved_snapshots_length + 6) * sizeof(gchar*));
 
-    if(pid == 0)
-    {
-        unsigned int i;
-        gchar **args = (gchar**)g_malloc((resolved_snapshots_length + 6) * sizeof(gchar*));
+    args[0] = "dysnomia-snapshots";
+    args[1] = "--import";
+    args[2] = "--container";
+    args[3] = container;
+    args[4] = "--component";
+    args[5] = component;
 
-        args[0] = "dysnomia-snapshots";
-        args[1] = "--import";
-        args[2] = "--container";
-        args[3] = container;
-        args[4] = "--component";
-        args[5] = component;
+    for(i = 0; i < resolved_snapshots_length; i++)
+        args[i + 6] = resolved_snapshots[i];
 
-        for(i = 0; i < resolved_snapshots_length; i++)
-            args[i + 6] = resolved_snapshots[i];
-
-        args[i + 6] = NULL;
-
-        dup2(stdout_fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    args[i + 6] = NULL;
 
+    pid = procreact_spawn(args, NULL, -1, stdout_fd, stderr_fd, 0);
+    g_free(args);
     return pid;
 }
 
@@ -20,72 +20,53 @@
 #include "state-management.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <procreact_spawn.h>
 
-static pid_t run_dysnomia_activity(gchar *type, gchar *activity, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
+pid_t statemgmt_run_dysnomia_activity(gchar *type, gchar *activity, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd, unsigned int flags)
 {
-    pid_t pid = fork();
+    pid_t pid;
+    char *const args[] = {"dysnomia", "--type", type, "--operation", activity, "--component", component, "--container", container, "--environment", NULL};
 
-    if(pid == 0)
-    {
-        char *const args[] = {"dysnomia", "--type", type, "--operation", activity, "--component", component, "--container", container, "--environment", NULL};
-
-        /* Add environment variables */
-        unsigned int i = 0;
+    /* Add environment variables */
+    char **envp = procreact_compose_environment(arguments);
 
-        while(arguments[i] != NULL)
-        {
-            putenv(arguments[i]);
-            i++;
-        }
-
-        dup2(stdout_fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
+    if(envp == NULL)
+        return -1;
 
+    pid = procreact_spawn(args, envp, -1, stdout_fd, stderr_fd, flags);
+    free(envp);
     return pid;
 }
 
 pid_t statemgmt_activate(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
 {
-    return run_dysnomia_activity(type, "activate", component, container, arguments, stdout_fd, stderr_fd);
+    return statemgmt_run_dysnomia_activity(type, "activate", component, container, arguments, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_deactivate(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
 {
-    return run_dysnomia_activity(type, "deactivate", component, container, arguments, stdout_fd, stderr_fd);
+    return statemgmt_run_dysnomia_activity(type, "deactivate", component, container, arguments, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_snapshot(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
 {
-    return run_dysnomia_activity(type, "snapshot", component, container, arguments, stdout_fd, stderr_fd);
+    return statemgmt_run_dysnomia_activity(type, "snapshot", component, container, arguments, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_restore(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
 {
-    return run_dysnomia_activity(type, "restore", component, container, arguments, stdout_fd, stderr_fd);
+    return statemgmt_run_dysnomia_activity(type, "restore", component, container, arguments, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_collect_garbage(gchar *type, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd)
 {
-    return run_dysnomia_activity(type, "collect-garbage", component, container, arguments, stdout_fd, stderr_fd);
+    return statemgmt_run_dysnomia_activity(type, "collect-garbage", component, container, arguments, stdout_fd, stderr_fd, 0);
 }
 
 static pid_t lock_or_unlock(gchar *operation, gchar *type, gchar *container, gchar *component, int stdout_fd, int stderr_fd)
 {
-    pid_t pid = fork();
-
-    if(pid == 0)
-    {
-        char *const args[] = {"dysnomia", "--type", type, "--operation", operation, "--container", container, "--component", component, "--environment", NULL};
-        dup2(stdout_fd, 1);
-        dup2(stderr_fd, 2);
-        execvp(args[0], args);
-        _exit(1);
-    }
-
-    return pid;
+    char *const args[] = {"dysnomia", "--type", type, "--operation", operation, "--container", container, "--component", component, "--environment", NULL};
+    return procreact_spawn(args, NULL, -1, stdout_fd, stderr_fd, 0);
 }
 
 pid_t statemgmt_lock(gchar *type, gchar *container, gchar *component, int stdout_fd, int stderr_fd)
@@ -100,33 +81,17 @@ pid_t statemgmt_unlock(gchar *type, gchar *container, gchar *component, int stdo
 
 pid_t statemgmt_shell(gchar *type, gchar *component, gchar *container, char **arguments, gchar *command)
 {
-    pid_t pid = fork();
+    pid_t pid;
+    char *const args[] = {"dysnomia", "--type", type, "--shell", "--component", component, "--container", container, "--environment", command == NULL ? NULL : "--command", command, NULL};
 
-    if(pid == 0)
-    {
-        /* Add environment variables */
-        unsigned int i = 0;
-
-        while(arguments[i] != NULL)
-        {
-            putenv(arguments[i]);
-            i++;
-        }
-
-        if(command == NULL)
-        {
-            char *const args[] = {"dysnomia", "--type", type, "--shell", "--component", component, "--container", container, "--environment", NULL};
-            execvp(args[0], args);
-        }
-        else
-        {
-            char *const args[] = {"dysnomia", "--type", type, "--shell", "--component", component, "--container", container, "--environment", "--command", command, NULL};
-            execvp(args[0], args);
-        }
-
-        _exit(1);
-    }
+    /* Add environment variables */
+    char **envp = procreact_compose_environment(arguments);
+
+    if(envp == NULL)
+        return -1;
 
+    pid = procreact_spawn(args, envp, -1, -1, -1, 0);
+    free(envp);
     return pid;
 }
 
@@ -146,18 +111,8 @@ gchar *statemgmt_capture_config(gchar *tmpdir, int stderr_fd, pid_t *pid, int *t
     else
     {
         /* Execute process capturing the config and writing it to a temp file */
-        *pid = fork();
-
-        if(*pid == 0)
-        {
-            char *const args[] = { "dysnomia-containers", "--generate-expr", NULL };
-
-            dup2(*temp_fd, 1);
-            dup2(stderr_fd, 2);
-            execvp(args[0], args);
-            _exit(1);
-        }
-
+        char *const args[] = { "dysnomia-containers", "--generate-expr", NULL };
+        *pid = procreact_spawn(args, NULL, -1, *temp_fd, stderr_fd, 0);
         return tempfilename;
     }
 }
@@ -24,6 +24,21 @@
 #include <unistd.h>
 #include <procreact_future.h>
 
+/**
+ * Executes a Dysnomia activity for a component in a container.
+ *
+ * @param type Name of the module that manages a component life-cycle
+ * @param activity Name of the Dysnomia operation, such as activate or collect-garbage
+ * @param component Name of the component
+ * @param container Name of the container
+ * @param arguments NULL-terminated array of name=value pairs representing the deployment parameters
+ * @param stdout_fd File descriptor to attach to the process' standard output
+ * @param stderr_fd File descriptor to attach to the process' standard error
+ * @param flags Bitwise OR of PROCREACT_SPAWN_* flags
+ * @return Process id of the process that executes the task or -1 in case of a failure
+ */
+pid_t statemgmt_run_dysnomia_activity(gchar *type, gchar *activity, gchar *component, gchar *container, char **arguments, int stdout_fd, int stderr_fd, unsigned int flags);
+
 /**
  * Activates a component in a container.
  *
@@ -54,6 +54,11 @@ static void print_usage(const char *command)
     "  DISNIX_PROFILE    Sets the name of the profile that stores the manifest on the\n"
     "                    coordinator machine and the deployed services per machine on\n"
     "                    each target (Defaults to: default)\n"
+    "  DISNIX_SSH_SESSION_DIR\n"
+    "                    Directory containing the shared SSH connections of\n"
+    "                    disnix-ssh-client. Only disnix-env sets it up. When it is\n"
+    "                    not set, every remote operation opens a connection of its\n"
+    "                    own\n"
     );
 }
 
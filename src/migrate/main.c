@@ -70,6 +70,10 @@ static void print_usage(const char *command)
     "                                       in most cases.\n"
     "  -m, --max-concurrent-transfers=NUM   Maximum amount of concurrent closure\n"
     "                                       transfers. Defauls to: 2\n"
+    "      --max-concurrent-snapshot-transfers=NUM\n"
+    "                                       Maximum amount of concurrent snapshot\n"
+    "                                       transfers per target machine. Defaults\n"
+    "                                       to: 1\n"
     "  -h, --help                           Shows the usage of this command to the\n"
     "                                       user\n"
 
@@ -81,6 +85,11 @@ static void print_usage(const char *command)
     "                       state after upgrading. (defaults to: 0)\n"
     "  DYSNOMIA_STATEDIR    Specifies where the snapshots must be stored on the\n"
     "                       coordinator machine (defaults to: /var/state/dysnomia)\n"
+    "  DISNIX_SSH_SESSION_DIR\n"
+    "                       Directory containing the shared SSH connections of\n"
+    "                       disnix-ssh-client. Only disnix-env sets it up. When it is\n"
+    "                       not set, every remote operation opens a connection of its\n"
+    "                       own\n"
     );
 }
 
@@ -102,12 +111,14 @@ int main(int argc, char *argv[])
         {"all", no_argument, 0, DISNIX_OPTION_ALL},
         {"keep", required_argument, 0, DISNIX_OPTION_KEEP},
         {"max-concurrent-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS},
+        {"max-concurrent-snapshot-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS},
         {"help", no_argument, 0, DISNIX_OPTION_HELP},
         {"version", no_argument, 0, DISNIX_OPTION_VERSION},
         {0, 0, 0, 0}
     };
 
     unsigned int max_concurrent_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_TRANSFERS;
+    unsigned int max_concurrent_snapshot_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_SNAPSHOT_TRANSFERS;
     unsigned int flags = 0;
     int keep = DISNIX_DEFAULT_KEEP;
     char *manifest_file;
@@ -158,6 +169,9 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS:
                 max_concurrent_transfers = atoi(optarg);
                 break;
+            case DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS:
+                max_concurrent_snapshot_transfers = atoi(optarg);
+                break;
             case DISNIX_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
@@ -182,5 +196,5 @@ int main(int argc, char *argv[])
     if(check_global_delete_state())
         flags |= FLAG_DELETE_STATE;
 
-    return run_migrate(manifest_file, max_concurrent_transfers, flags, keep, old_manifest, coordinator_profile_path, profile, container, component); /* Execute migrate operation */
+    return run_migrate(manifest_file, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep, old_manifest, coordinator_profile_path, profile, container, component); /* Execute migrate operation */
 }
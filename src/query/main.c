@@ -56,6 +56,10 @@ static void print_usage(const char *command)
     "                             manifest on the coordinator machine and the\n"
     "                             deployed services per machine on each target\n"
     "                             (Defaults to: default).\n"
+    "  DISNIX_SSH_SESSION_DIR     Directory containing the shared SSH connections of\n"
+    "                             disnix-ssh-client. Only disnix-env sets it up. When\n"
+    "                             it is not set, every remote operation opens a\n"
+    "                             connection of its own\n"
     );
 }
 
@@ -73,6 +73,10 @@ static void print_usage(const char *command)
     "                                       in most cases.\n"
     "  -m, --max-concurrent-transfers=NUM   Maximum amount of concurrent closure\n"
     "                                       transfers. Defauls to: 2\n"
+    "      --max-concurrent-snapshot-transfers=NUM\n"
+    "                                       Maximum amount of concurrent snapshot\n"
+    "                                       transfers per target machine. Defaults\n"
+    "                                       to: 1\n"
     "  -h, --help                           Shows the usage of this command to the\n"
     "                                       user\n"
 
@@ -80,6 +84,11 @@ static void print_usage(const char *command)
     "  DISNIX_PROFILE    Sets the name of the profile that stores the manifest on the\n"
     "                    coordinator machine and the deployed services per machine on\n"
     "                    each target (Defaults to: default)\n"
+    "  DISNIX_SSH_SESSION_DIR\n"
+    "                    Directory containing the shared SSH connections of\n"
+    "                    disnix-ssh-client. Only disnix-env sets it up. When it is\n"
+    "                    not set, every remote operation opens a connection of its\n"
+    "                    own\n"
     );
 }
 
@@ -100,12 +109,14 @@ int main(int argc, char *argv[])
         {"all", no_argument, 0, DISNIX_OPTION_ALL},
         {"keep", required_argument, 0, DISNIX_OPTION_KEEP},
         {"max-concurrent-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS},
+        {"max-concurrent-snapshot-transfers", required_argument, 0, DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0}
     };
 
     unsigned int max_concurrent_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_TRANSFERS;
+    unsigned int max_concurrent_snapshot_transfers = DISNIX_DEFAULT_MAX_NUM_OF_CONCURRENT_SNAPSHOT_TRANSFERS;
     unsigned int flags = 0;
     int keep = DISNIX_DEFAULT_KEEP;
     char *old_manifest = NULL;
@@ -153,6 +164,9 @@ int main(int argc, char *argv[])
             case DISNIX_OPTION_MAX_CONCURRENT_TRANSFERS:
                 max_concurrent_transfers = atoi(optarg);
                 break;
+            case DISNIX_OPTION_MAX_CONCURRENT_SNAPSHOT_TRANSFERS:
+                max_concurrent_snapshot_transfers = atoi(optarg);
+                break;
             case DISNIX_OPTION_HELP:
                 print_usage(argv[0]);
                 return 0;
@@ -174,5 +188,5 @@ int main(int argc, char *argv[])
     else
         manifest_file = argv[optind];
 
-    return run_restore(manifest_file, max_concurrent_transfers, flags, keep, old_manifest, coordinator_profile_path, profile, container, component); /* Execute restore operation */
+    return run_restore(manifest_file, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep, old_manifest, coordinator_profile_path, profile, container, component); /* Execute restore operation */
 }
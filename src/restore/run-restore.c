@@ -21,7 +21,7 @@
 #include <manifest.h>
 #include <snapshotmappingarray.h>
 
-int run_restore(const gchar *manifest_file, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep, const gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const gchar *container_filter, const gchar *component_filter)
+int run_restore(const gchar *manifest_file, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep, const gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const gchar *container_filter, const gchar *component_filter)
 {
     /* Generate a distribution array from the manifest file */
     Manifest *manifest = open_provided_or_previous_manifest_file(manifest_file, coordinator_profile_path, profile, MANIFEST_SNAPSHOT_MAPPINGS_FLAG | MANIFEST_INFRASTRUCTURE_FLAG, container_filter, component_filter);
@@ -45,7 +45,7 @@ int run_restore(const gchar *manifest_file, const unsigned int max_concurrent_tr
                 previous_manifest = open_provided_or_previous_manifest_file(old_manifest, coordinator_profile_path, profile, MANIFEST_SNAPSHOT_MAPPINGS_FLAG, container_filter, component_filter);
 
             if(previous_manifest == NULL || check_manifest(previous_manifest))
-                exit_status = !restore(manifest, previous_manifest, max_concurrent_transfers, flags, keep);
+                exit_status = !restore(manifest, previous_manifest, max_concurrent_transfers, max_concurrent_snapshot_transfers, flags, keep);
             else
                 exit_status = 1;
 
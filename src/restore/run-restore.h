@@ -27,6 +27,7 @@
  *
  * @param manifest_file Path to the manifest file which maps services to machines
  * @param max_concurrent_transfers Specifies the maximum amount of concurrent transfers
+ * @param max_concurrent_snapshot_transfers Specifies the maximum amount of concurrent snapshot transfers per target machine
  * @param keep Indicates how many snapshot generations should be kept
  * @param flags Option flags
  * @param old_manifest Manifest file representing the old deployment configuration
@@ -36,6 +37,6 @@
  * @param component_filter Snapshot operations will be restricted to the given component, NULL indicates all components
  * @return 0 if everything succeeds, else a non-zero exit status
  */
-int run_restore(const gchar *manifest_file, const unsigned int max_concurrent_transfers, const unsigned int flags, const int keep, const gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const gchar *container_filter, const gchar *component_filter);
+int run_restore(const gchar *manifest_file, const unsigned int max_concurrent_transfers, const unsigned int max_concurrent_snapshot_transfers, const unsigned int flags, const int keep, const gchar *old_manifest, const gchar *coordinator_profile_path, gchar *profile, const gchar *container_filter, const gchar *component_filter);
 
 #endif
@@ -52,6 +52,9 @@ static void print_usage(const char *command)
     "      --collect-garbage      Collects garbage on the given target machine\n"
     "      --activate             Activates the given service on the target machine\n"
     "      --deactivate           Deactivates the given service on the target machine\n"
+    "      --run-activities       Executes a batch of activities read from the\n"
+    "                             standard input and prints the outcome of each\n"
+    "                             activity\n"
     "      --lock                 Acquires a lock on a Disnix profile of the target\n"
     "                             machine\n"
     "      --unlock               Release the lock on a Disnix profile of the target\n"
@@ -87,6 +90,9 @@ static void print_usage(const char *command)
     "  -t, --target=TARGET        Specifies the target to connect to. This property\n"
     "                             is ignored by this client because it only supports\n"
     "                             loopback connections.\n"
+    "      --stream-log           Writes the log of the activity to the standard\n"
+    "                             error while it is in progress. This property is\n"
+    "                             ignored by this client, because it always does so.\n"
 
     "\nImport/Export/Import snapshots/Export snapshots options:\n"
     "      --localfile            Specifies that the given paths are stored locally\n"
@@ -96,6 +102,11 @@ static void print_usage(const char *command)
     "                             and must transferred from the remote machine if\n"
     "                             needed\n"
 
+    "\nImport/Export options:\n"
+    "      --stream               Reads the closure to import from the standard\n"
+    "                             input or writes the exported closure to the\n"
+    "                             standard output, instead of using a file\n"
+
     "\nSet/Query installed/Lock/Unlock options:\n"
     "  -p, --profile=PROFILE      Name of the Disnix profile. Defaults to: default\n"
 
@@ -148,6 +159,7 @@ int main(int argc, char *argv[])
         {"collect-garbage", no_argument, 0, 'W'},
         {"activate", no_argument, 0, 'A'},
         {"deactivate", no_argument, 0, 'D'},
+        {"run-activities", no_argument, 0, '5'},
         {"delete-state", no_argument, 0, 'F'},
         {"lock", no_argument, 0, 'L'},
         {"unlock", no_argument, 0, 'U'},
@@ -164,6 +176,8 @@ int main(int argc, char *argv[])
         {"target", required_argument, 0, 't'},
         {"localfile", no_argument, 0, 'l'},
         {"remotefile", no_argument, 0, 'R'},
+        {"stream", no_argument, 0, '4'},
+        {"stream-log", no_argument, 0, '6'},
         {"profile", required_argument, 0, 'p'},
         {"delete-old", no_argument, 0, 'd'},
         {"type", required_argument, 0, 'T'},
@@ -258,12 +272,20 @@ int main(int argc, char *argv[])
             case '2':
                 operation = OP_SHELL;
                 break;
+            case '5':
+                operation = OP_RUN_ACTIVITIES;
+                break;
             case 't':
                 break;
             case 'l':
                 break;
             case 'R':
                 break;
+            case '4':
+                flags |= FLAG_STREAM;
+                break;
+            case '6':
+                break;
             case 'p':
                 profile = optarg;
                 break;
@@ -27,6 +27,7 @@
 #include <package-management.h>
 #include <state-management.h>
 #include <snapshot-management.h>
+#include <activity-batch.h>
 #include <profilemanifest.h>
 #include <profilelocking.h>
 
@@ -122,7 +123,9 @@ int run_disnix_activity(Operation operation, gchar **paths, const unsigned int f
     switch(operation)
     {
         case OP_IMPORT:
-            if(paths[0] == NULL)
+            if(flags & FLAG_STREAM)
+                exit_status = procreact_wait_for_exit_status(pkgmgmt_import_closure_fd(0, 1, 2), &status);
+            else if(paths[0] == NULL)
             {
                 g_printerr("ERROR: A Nix store component has to be specified!\n");
                 exit_status = 1;
@@ -132,8 +135,13 @@ int run_disnix_activity(Operation operation, gchar **paths, const unsigned int f
 
             break;
         case OP_EXPORT:
-            tempfilename = pkgmgmt_export_closure(tmpdir, paths, g_strv_length(paths), 2, &pid, &temp_fd);
-            return_tempfile(pid, tempfilename, temp_fd);
+            if(flags & FLAG_STREAM)
+                exit_status = procreact_wait_for_exit_status(pkgmgmt_export_closure_fd(paths, g_strv_length(paths), 1, 2), &status);
+            else
+            {
+                tempfilename = pkgmgmt_export_closure(tmpdir, paths, g_strv_length(paths), 2, &pid, &temp_fd);
+                return_tempfile(pid, tempfilename, temp_fd);
+            }
             break;
         case OP_PRINT_INVALID:
             exit_status = print_strv(pkgmgmt_print_invalid_packages(paths, g_strv_length(paths), 2));
@@ -295,6 +303,21 @@ int run_disnix_activity(Operation operation, gchar **paths, const unsigned int f
             else
                 exit_status = procreact_wait_for_exit_status(statemgmt_shell((gchar*)type, paths[0], (gchar*)container, arguments, command), &status);
             break;
+        case OP_RUN_ACTIVITIES:
+            {
+                GPtrArray *batch = statemgmt_read_activity_batch(stdin);
+
+                if(batch == NULL || !statemgmt_check_activity_batch(batch))
+                {
+                    g_printerr("ERROR: Cannot read a valid batch of activities from the standard input!\n");
+                    exit_status = 1;
+                }
+                else
+                    exit_status = !statemgmt_run_activity_batch(batch, 2, 2, stdout); /* The standard output is reserved for the outcomes */
+
+                delete_activity_batch(batch);
+            }
+            break;
         case OP_NONE:
             g_printerr("ERROR: No operation specified!\n");
             exit_status = 1;
@@ -21,6 +21,7 @@
 #define __DISNIX_RUN_ACTIVITY_H
 
 #define FLAG_DELETE_OLD 0x1
+#define FLAG_STREAM 0x2
 
 #include <glib.h>
 
@@ -52,7 +53,8 @@ typedef enum
     OP_CLEAN_SNAPSHOTS,
     OP_DELETE_STATE,
     OP_CAPTURE_CONFIG,
-    OP_SHELL
+    OP_SHELL,
+    OP_RUN_ACTIVITIES
 }
 Operation;
 
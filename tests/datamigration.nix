@@ -318,6 +318,26 @@ simpleTest {
               "testService1 state should be: 1, instead it is: {}".format(result[:-1])
           )
 
+      # Capture and restore snapshots while limiting the amount of
+      # concurrent snapshot transfers. The restored state should be the one
+      # that was captured.
+      testtarget1.succeed("echo 3 > /var/db/testService1/state")
+      coordinator.succeed(
+          "${env} disnix-snapshot --max-concurrent-snapshot-transfers 1"
+      )
+      testtarget1.succeed("echo 4 > /var/db/testService1/state")
+      coordinator.succeed(
+          "${env} disnix-restore --no-upgrade --max-concurrent-snapshot-transfers 1"
+      )
+      result = testtarget1.succeed("cat /var/db/testService1/state")
+
+      if result[:-1] == "3":
+          print("testService1 state is: {}".format(result[:-1]))
+      else:
+          raise Exception(
+              "testService1 state should be: 3, instead it is: {}".format(result[:-1])
+          )
+
       # Test disnix-reconstruct. Because nothing has changed the coordinator
       # profile should remain identical.
 
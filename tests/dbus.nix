@@ -12,6 +12,22 @@ simpleTest {
   nodes = {
     client = machine;
     server = machine;
+
+    # Applies a log retention policy that keeps at most three job logs
+    retention = {lib, ...}:
+
+    {
+      imports = [ machine ];
+      systemd.services.disnix.serviceConfig.ExecStart = lib.mkForce "${disnix}/bin/disnix-service --log-retention-count=3";
+    };
+
+    # Admits only one transfer at a time
+    scheduling = {lib, ...}:
+
+    {
+      imports = [ machine ];
+      systemd.services.disnix.serviceConfig.ExecStart = lib.mkForce "${disnix}/bin/disnix-service --max-concurrent-transfers=1";
+    };
   };
   testScript =
     let
@@ -123,6 +139,17 @@ simpleTest {
       # This test should succeed.
       client.succeed("disnix-client --import {}".format(result))
 
+      # Streamed export test. Exports the closure of the bash shell over a
+      # file descriptor passed to the service. This test should succeed.
+      client.succeed(
+          "disnix-client --export --stream ${pkgs.bash} > /tmp/bash.closure"
+      )
+      client.succeed("[ -s /tmp/bash.closure ]")
+
+      # Streamed import test. Imports the closure of the previous test from
+      # a file descriptor passed to the service. This test should succeed.
+      client.succeed("disnix-client --import --stream < /tmp/bash.closure")
+
       # Lock test. This test should succeed.
       client.succeed("disnix-client --lock")
 
@@ -155,6 +182,48 @@ simpleTest {
           )
       )
 
+      # Log streaming test. Activates the service again while following the
+      # log of the job. The output of the echo module should appear on the
+      # standard error. This test should succeed.
+      client.succeed(
+          "disnix-client --stream-log --activate --type echo {} 2> /tmp/activate.log".format(
+              testService1
+          )
+      )
+      client.succeed("grep 'activate: {}' /tmp/activate.log".format(testService1))
+
+      # Activity batch test. Activates and deactivates the service in two
+      # stages. The argument contains an escaped tab, that should have been
+      # unescaped by the time it reaches the Dysnomia module.
+      # This test should succeed.
+      batch = "0\tactivate\techo\techo\t{0}\tgreeting=hello\\tworld\n1\tdeactivate\techo\techo\t{0}\n".format(
+          testService1
+      )
+      client.succeed("cat > /tmp/batch << 'EOF'\n{}EOF".format(batch))
+      result = client.succeed("disnix-client --run-activities < /tmp/batch")
+
+      if "0 ok" in result and "1 ok" in result:
+          print("Both activities of the batch have succeeded!")
+      else:
+          raise Exception(
+              "Both activities of the batch should succeed, instead we have: {}".format(
+                  result
+              )
+          )
+
+      client.succeed("cat /var/log/disnix/* | grep -P 'greeting=hello\tworld$'")
+
+      # Malformed activity batch test. This test should fail.
+      client.fail("echo garbage | disnix-client --run-activities")
+
+      # Activity batch test with an activity that cannot be executed as part
+      # of a batch. This test should fail.
+      client.fail(
+          "printf '0\\tlock\\techo\\techo\\t{}\\n' | disnix-client --run-activities".format(
+              testService1
+          )
+      )
+
       # Security test. First we try to invoke a Disnix operation by an
       # unprivileged user, which should fail. Then we try the same
       # command by a privileged user, which should succeed.
@@ -168,12 +237,15 @@ simpleTest {
 
       # Logfiles test. We perform an operation and check the id of the
       # logfile. Then we stop the Disnix service and start it again and perform
-      # another operation. It should create a logfile which id is one higher.
+      # another operation. The job ids that have been reserved in the counter
+      # file are never reused, so the new logfile's id should be the value of
+      # the counter.
 
       client.succeed(
           "disnix-client --print-invalid /nix/store/00000000000000000000000000000000-invalid"
       )
       result = client.succeed("ls /var/log/disnix | sort -n | tail -1")
+      counter = client.succeed("cat /var/log/disnix/.job-counter")
       client.stop_job("disnix")
       client.start_job("disnix")
       client.wait_for_unit("disnix")
@@ -182,7 +254,7 @@ simpleTest {
       )
       result2 = client.succeed("ls /var/log/disnix | sort -n | tail -1")
 
-      if int(result2[:-1]) - int(result[:-1]) == 1:
+      if int(result2[:-1]) == int(counter[:-1]) and int(result2[:-1]) > int(result[:-1]):
           print("The log file numbers are correct!")
       else:
           raise Exception("The logfile numbers are incorrect!")
@@ -191,5 +263,61 @@ simpleTest {
       # contain one property: "foo" = "bar";
       result = client.succeed("disnix-client --capture-config")
       client.succeed('(cat {}) | grep \'"foo" = "bar"\${"'"}'.format(result))
+
+      # Log retention test. We create ten old logfiles and a recent one. After
+      # starting the service, only the three newest logfiles should be kept.
+
+      retention.wait_for_unit("disnix")
+      retention.stop_job("disnix")
+      retention.succeed(
+          "for i in $(seq 1000 1009); do echo old > /var/log/disnix/$i; touch -d '2 hours ago' /var/log/disnix/$i; done"
+      )
+      retention.succeed("echo recent > /var/log/disnix/1010")
+      retention.start_job("disnix")
+      retention.wait_for_unit("disnix")
+      retention.succeed("sleep 3")
+
+      retention.succeed("[ ! -e /var/log/disnix/1007 ]")
+      retention.succeed("[ -e /var/log/disnix/1008 ]")
+      retention.succeed("[ -e /var/log/disnix/1009 ]")
+      retention.succeed("[ -e /var/log/disnix/1010 ]")
+
+      # Logfiles that have recently been modified may still be written to.
+      # They should be kept, even if they exceed the limit.
+
+      retention.stop_job("disnix")
+      retention.succeed(
+          "for i in $(seq 2000 2004); do echo recent > /var/log/disnix/$i; done"
+      )
+      retention.start_job("disnix")
+      retention.wait_for_unit("disnix")
+      retention.succeed("sleep 3")
+
+      retention.succeed("[ ! -e /var/log/disnix/1009 ]")
+      retention.succeed("[ -e /var/log/disnix/1010 ]")
+      retention.succeed('[ "$(ls /var/log/disnix/200* | wc -l)" = "5" ]')
+
+      # Scheduling test. The service admits only one transfer at a time. The
+      # first streamed import keeps its transfer slot until its input ends, so
+      # the second import has to wait for it. Both should succeed and the log
+      # of the second import should report that it had to wait.
+
+      scheduling.wait_for_unit("disnix")
+      scheduling.succeed(
+          "disnix-client --export --stream ${pkgs.bash} > /tmp/bash.closure"
+      )
+      scheduling.succeed(
+          "((sleep 10; cat /tmp/bash.closure) | disnix-client --import --stream && touch /tmp/first.ok) > /dev/null 2>&1 &"
+      )
+      scheduling.succeed("sleep 3")
+      scheduling.succeed("disnix-client --import --stream < /tmp/bash.closure")
+      scheduling.wait_until_succeeds("[ -e /tmp/first.ok ]")
+
+      result = scheduling.succeed("ls /var/log/disnix | sort -n | tail -1")
+      scheduling.succeed(
+          "grep 'Waiting for other jobs to complete...' /var/log/disnix/{}".format(
+              result[:-1]
+          )
+      )
     '';
 }
@@ -39,6 +39,45 @@ simpleTest {
       coordinator.copy_from_host("key", "/root/.ssh/id_dsa")
       coordinator.succeed("chmod 600 /root/.ssh/id_dsa")
 
+      # Delegate the builds of the services to the target machines while
+      # only one derivation may be built at a time. Because numOfCores
+      # defaults to 1, each machine builds its derivations one by one anyway.
+      # All build results should have been retrieved by the coordinator.
+      # This test should succeed.
+      coordinator.succeed(
+          "${env} disnix-delegate --max-concurrent-builds 1 -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-reverse.nix"
+      )
+      distributedDerivation = coordinator.succeed(
+          "${env} disnix-instantiate -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-reverse.nix --no-out-link"
+      )
+      coordinator.succeed(
+          "grep -o '/nix/store/[^<]*\\.drv' {} | xargs nix-store -q --outputs | xargs nix-store --check-validity".format(
+              distributedDerivation[:-1]
+          )
+      )
+
+      # Delegate the builds of the services to both target machines. Each
+      # target realises its store derivations as soon as they have been
+      # distributed to it and its results are retrieved while the other
+      # target may still be building. All build results should have been
+      # retrieved by the coordinator. This test should succeed.
+      coordinator.succeed(
+          "${env} disnix-delegate -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-simple.nix"
+      )
+      distributedDerivation = coordinator.succeed(
+          "${env} disnix-instantiate -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-simple.nix --no-out-link"
+      )
+      coordinator.succeed(
+          "grep -o '/nix/store/[^<]*\\.drv' {} | xargs nix-store -q --outputs | xargs nix-store --check-validity".format(
+              distributedDerivation[:-1]
+          )
+      )
+
+      # Both targets should have realised the store derivations that have
+      # been mapped to them.
+      testtarget1.succeed("cat /var/log/disnix/* | grep '\\-testService1.drv'")
+      testtarget2.succeed("cat /var/log/disnix/* | grep '\\-testService2.drv'")
+
       # Do a rollback. Since there is nothing deployed, it should fail.
       coordinator.fail(
           "${env} disnix-env --rollback"
@@ -432,6 +471,76 @@ simpleTest {
           "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService3']/name\" query.xml"
       )
 
+      # Pipelined upgrade test. We move testService2 to another machine
+      # again, transferring the closures to one machine at the time, so that
+      # the other machine is prepared while the first one is busy.
+      # This test should succeed.
+      coordinator.succeed(
+          "${env} disnix-env -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-reverse.nix --pipeline --max-concurrent-transfers 1"
+      )
+
+      coordinator.succeed(
+          "${env} disnix-query -f xml ${manifestTests}/infrastructure.nix > query.xml"
+      )
+
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget1']/profileManifest/services/service[name='testService1']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget1']/profileManifest/services/service[name='testService2']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService3']/name\" query.xml"
+      )
+
+      # Batched activities test. We move testService2 back, executing the
+      # activities of each machine in a single batch.
+      # This test should succeed.
+      coordinator.succeed(
+          "${env} disnix-env -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-simple.nix --batch-activities"
+      )
+
+      coordinator.succeed(
+          "${env} disnix-query -f xml ${manifestTests}/infrastructure.nix > query.xml"
+      )
+
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget1']/profileManifest/services/service[name='testService1']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService2']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService3']/name\" query.xml"
+      )
+
+      # Deploy the multi container configuration again by combining both
+      # options, while streaming the logs of the remote jobs. Each line of
+      # the logs should be labelled with the machine it originates from.
+      # This test should succeed.
+      coordinator.succeed(
+          "${env} DISNIX_STREAM_LOG=1 disnix-env -s ${manifestTests}/services-complete.nix -i ${manifestTests}/infrastructure.nix -d ${manifestTests}/distribution-multicontainer.nix --pipeline --batch-activities 2> result"
+      )
+      coordinator.succeed("grep '^\\[testtarget1\\]: ' result")
+      coordinator.succeed("grep '^\\[testtarget2\\]: ' result")
+
+      coordinator.succeed(
+          "${env} disnix-query -f xml ${manifestTests}/infrastructure.nix > query.xml"
+      )
+
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget1']/profileManifest/services/service[name='testService1']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget1']/profileManifest/services/service[name='testService3']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService2']/name\" query.xml"
+      )
+      coordinator.succeed(
+          "xmllint --xpath \"/profileManifestTargets/target[@name='testtarget2']/profileManifest/services/service[name='testService3']/name\" query.xml"
+      )
+
       # Remove old generation test. We remove one profile generation and we
       # check if it has been successfully removed
 
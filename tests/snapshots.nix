@@ -280,6 +280,31 @@ simpleTest {
           "dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | wc -l"
       )
 
+      if int(result) == 4:
+          print("We have 4 snapshots!")
+      else:
+          raise Exception("Expecting 4 snapshots, but we have: {}!".format(result))
+
+      # Remove the second and fourth snapshot from the client, so that the
+      # missing snapshots are interleaved with the ones that are present.
+      # Then copy all snapshots through a client interface that does not
+      # support streamed snapshot exports. It should fall back to exporting
+      # the snapshots one by one, and we should have 4 of them again.
+      client.succeed(
+          "for i in $(dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | sed -n '2p;4p'); do rm -rf $(dysnomia-snapshots --resolve $i); done"
+      )
+      client.succeed(
+          "cat > /root/no-stream-client << 'EOF'\n#!/bin/sh\nfor i in \"$@\"; do [ \"$i\" = \"--stream\" ] && exit 1; done\nexec disnix-ssh-client \"$@\"\nEOF"
+      )
+      client.succeed("chmod +x /root/no-stream-client")
+      client.succeed(
+          "${env} disnix-copy-snapshots --from --target server --container wrapper --component ${wrapper} --all --interface /root/no-stream-client"
+      )
+
+      result = client.succeed(
+          "dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | wc -l"
+      )
+
       if int(result) == 4:
           print("We have 4 snapshots!")
       else:
@@ -342,6 +367,50 @@ simpleTest {
       )
       result = server.succeed("cat {}/state".format(lastResolvedSnapshot[:-1]))
 
+      if result == "2\n":
+          print("Result is 2")
+      else:
+          raise Exception("Result should be 2, instead it is: {}!".format(result))
+
+      # Remove the second and fourth snapshot from the server, so that the
+      # snapshots that are missing are interleaved with the ones that are
+      # present. Copying all snapshots should transfer each run of missing
+      # snapshots, and we should have 4 of them again. The last snapshot
+      # should still contain 2.
+      server.succeed(
+          "for i in $(dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | sed -n '2p;4p'); do rm -rf $(dysnomia-snapshots --resolve $i); done"
+      )
+
+      result = server.succeed(
+          "dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | wc -l"
+      )
+
+      if int(result) == 2:
+          print("We have 2 snapshots!")
+      else:
+          raise Exception("Expecting only 2 snapshots, but we have: {}!".format(result))
+
+      client.succeed(
+          "${env} disnix-copy-snapshots --to --target server --container wrapper --component ${wrapper} --all"
+      )
+
+      result = server.succeed(
+          "dysnomia-snapshots --query-all --container wrapper --component ${wrapper} | wc -l"
+      )
+
+      if int(result) == 4:
+          print("We have 4 snapshots!")
+      else:
+          raise Exception("Expecting only 4 snapshots, but we have: {}!".format(result))
+
+      lastSnapshot = server.succeed(
+          "dysnomia-snapshots --query-latest --container wrapper --component ${wrapper}"
+      )
+      lastResolvedSnapshot = server.succeed(
+          "dysnomia-snapshots --resolve {}".format(lastSnapshot[:-1])
+      )
+      result = server.succeed("cat {}/state".format(lastResolvedSnapshot[:-1]))
+
       if result == "2\n":
           print("Result is 2")
       else:
@@ -228,5 +228,80 @@ simpleTest {
           )
       )
       server.succeed("grep 'foo' /tmp/tmpfile")
+
+      # Session sharing test. We put a stand-in for ssh in front of the PATH
+      # that records all its invocations before it runs the real ssh. When a
+      # session directory is given, only the first operation should start a
+      # master connection and all operations should multiplex over it.
+      # This test should succeed.
+
+      client.succeed("mkdir -p /root/stand-in /tmp/session")
+      client.succeed(
+          "cat > /root/stand-in/ssh << 'EOF'\n#!/bin/sh\necho \"$*\" >> /tmp/ssh.log\nexec ${pkgs.openssh}/bin/ssh \"$@\"\nEOF"
+      )
+      client.succeed("chmod +x /root/stand-in/ssh")
+
+      sessionEnv = "${env} PATH=/root/stand-in:$PATH DISNIX_SSH_SESSION_DIR=/tmp/session"
+
+      for i in range(3):
+          client.succeed(
+              "{} disnix-ssh-client --target server --print-invalid ${pkgs.bash}".format(
+                  sessionEnv
+              )
+          )
+
+      result = client.succeed("grep -c 'ControlMaster=yes' /tmp/ssh.log")
+
+      if int(result) == 1:
+          print("One master connection has been started!")
+      else:
+          raise Exception(
+              "Expecting one master connection, but we have: {}!".format(result)
+          )
+
+      result = client.succeed(
+          "grep -c 'ControlMaster=no -o ControlPath=/tmp/session/%C.*--print-invalid' /tmp/ssh.log"
+      )
+
+      if int(result) == 3:
+          print("All operations have used the shared connection!")
+      else:
+          raise Exception(
+              "Expecting 3 operations over the shared connection, but we have: {}!".format(
+                  result
+              )
+          )
+
+      # The session slots must have been released after each operation
+      client.fail("ls -d /tmp/session/server-22.slot*")
+
+      # Session slot exhaustion test. We occupy the only session slot, so
+      # that the next operation must fall back to a connection of its own.
+      # This test should succeed.
+
+      client.succeed("mkdir /tmp/session/server-22.slot1")
+      client.succeed("rm /tmp/ssh.log")
+      client.succeed(
+          "{} DISNIX_SSH_MAX_SESSIONS=1 disnix-ssh-client --target server --print-invalid ${pkgs.bash}".format(
+              sessionEnv
+          )
+      )
+      client.succeed("grep 'ControlPath=none.*--print-invalid' /tmp/ssh.log")
+      client.fail("grep 'ControlMaster=yes' /tmp/ssh.log")
+
+      # After releasing the slot, the operation should use the shared
+      # connection again. This test should succeed.
+
+      client.succeed("rmdir /tmp/session/server-22.slot1")
+      client.succeed("rm /tmp/ssh.log")
+      client.succeed(
+          "{} DISNIX_SSH_MAX_SESSIONS=1 disnix-ssh-client --target server --print-invalid ${pkgs.bash}".format(
+              sessionEnv
+          )
+      )
+      client.succeed(
+          "grep 'ControlMaster=no -o ControlPath=/tmp/session/%C.*--print-invalid' /tmp/ssh.log"
+      )
+      client.fail("grep 'ControlPath=none' /tmp/ssh.log")
     '';
 }